@@ -73,15 +73,75 @@ extern "C"
     /* open daec file in read-only mode */
     int de_open_readonly(const char *fname, de_file *de);
 
+    /*
+        open daec file in read-only mode, for files that never change while they
+        are open, e.g. published files on network storage.
+        NOTES:
+        * the file is opened without locking and without checking for changes by
+          other processes, which makes reading much faster on network file
+          systems. If the file does change, reads may fail or return wrong
+          results.
+        * connections to the same file in one process share their page cache.
+        * if `in_memory` is not 0, the whole file is copied into memory when it
+          is opened and the file itself is closed right away.
+    */
+    int de_open_immutable(const char *fname, int in_memory, de_file *de);
+
     /* open a daec database in memory */
     int de_open_memory(de_file *pde);
 
-    /* close a previously opened daec file */
+    /* close a previously opened daec file. A bulk load in progress is ended
+       (see de_bulk_end); if that fails, the load is rolled back, the file is
+       closed anyway and the error is returned. */
     int de_close(de_file de);
 
     /* delete everything in the given daec file */
     int de_truncate(de_file de);
 
+    /*
+        record the byte order, "little" or "big", of the values in the given daec
+        file, as the attribute DE_BYTE_ORDER of the root.
+        NOTES:
+        * new files record the byte order of the host that makes them. Files made
+          by versions of the library before the attribute don't, and their values
+          are read in the byte order of the host until it is recorded.
+        * return DE_EXISTS if the file already records its byte order.
+    */
+    int de_set_byte_order(de_file de, const char *order);
+
+    /*
+        turn deduplication of values on (enable != 0) or off for this de_file.
+        NOTES:
+        * while it is on, the values of new tseries, mvtseries and ndtseries are
+          kept in a store of blobs shared by all objects. A value that is already
+          in the store is not written again; the object only refers to it.
+        * each blob counts the objects that refer to it and is deleted together
+          with the last of them.
+        * the setting is not saved in the file; it is off when the file is opened.
+          Values stored either way are loaded the same way.
+        * chunked values and values written with de_open_*_writer are not shared.
+    */
+    int de_set_dedup(de_file de, int enable);
+
+    /* return the number of blobs in the shared store, their total size in bytes
+       and the number of references to them. Any of the outputs may be NULL. */
+    int de_dedup_stats(de_file de, int64_t *nblobs, int64_t *nbytes, int64_t *nrefs);
+
+    /*
+        turn deferred object info on (enable != 0) or off for this de_file.
+        NOTES:
+        * while it is on, new objects get their full path, depth and creation
+          time (see de_get_object_info) all at once, when the transaction is
+          committed, rather than one at a time. This makes loading many objects
+          faster.
+        * functions that need the info of new objects, e.g. de_find_fullpath,
+          fill it in before they run.
+        * the creation time of the new objects is the time their info is filled in.
+        * the setting is not saved in the file; it is off when the file is opened.
+          Turning it off fills in the info that is still missing.
+    */
+    int de_set_defer_info(de_file de, int enable);
+
     /* ***************************** object  ************************************* */
 
     typedef enum
@@ -145,6 +205,12 @@ extern "C"
     /* delete object given id*/
     int de_delete_object(de_file de, obj_id_t id);
 
+    /* give an object a new name in the same catalog */
+    int de_rename(de_file de, obj_id_t id, const char *name);
+
+    /* move an object, and everything under it if it is a catalog, to catalog `pid` */
+    int de_move(de_file de, obj_id_t id, obj_id_t pid);
+
     /* set attribute by name */
     int de_set_attribute(de_file de, obj_id_t id, const char *name, const char *value);
 
@@ -173,6 +239,42 @@ extern "C"
     /* create new catalog. return error if catalog already exists */
     int de_new_catalog(de_file de, obj_id_t pid, const char *name, obj_id_t *id);
 
+    /* statistics of the objects under a catalog, at any depth */
+    typedef struct
+    {
+        int64_t count;     /* number of objects */
+        int64_t nbytes;    /* total size of their values */
+        int dated;         /* 0 if none of them has a date axis */
+        int64_t first_day; /* first and last day (dates of frequency freq_daily) */
+        int64_t last_day;  /* covered by their date axes, if `dated` */
+    } catalog_stats_t;
+
+    /*
+        return the statistics of catalog `id`.
+        NOTES:
+        * unless they are kept in the file (see de_set_catalog_stats), the
+          statistics are computed from every object under the catalog.
+        * shared values (see de_set_dedup) count in full for each object using them.
+        * if they are kept, after objects are deleted the date coverage may need
+          to be recomputed, which takes a look at every object under the catalog.
+          The result is saved, if there are changes to the file that are not yet
+          committed.
+    */
+    int de_catalog_stats(de_file de, obj_id_t id, catalog_stats_t *stats);
+
+    /*
+        keep the statistics of all catalogs (enable != 0) in the file, or stop
+        keeping them.
+        NOTES:
+        * while they are kept, de_catalog_stats is fast however many objects are
+          under the catalog, but every change to the objects updates the
+          statistics of all the catalogs above them, which makes writes slower.
+        * the setting is saved in the file. It is off in new files and in files
+          upgraded from versions that did not keep statistics. Turning it on
+          computes the statistics of the objects already in the file.
+    */
+    int de_set_catalog_stats(de_file de, int enable);
+
     /* ***************************** date **************************************** */
 
     typedef enum
@@ -291,6 +393,16 @@ extern "C"
     /* load an axis from its id */
     int de_load_axis(de_file de, axis_id_t id, axis_t *axis);
 
+    /*
+        delete the axes that are not used by any object, e.g. those of deleted
+        objects. `removed` (may be NULL) receives the number of axes deleted.
+        NOTES:
+        * axes are shared by all objects with equal axes, so they are not deleted
+          together with the objects using them.
+        * the ids of axes made but not yet used by an object are no longer valid.
+    */
+    int de_gc_axes(de_file de, int64_t *removed);
+
     /* ***************************** tseries ************************************* */
 
     typedef struct
@@ -315,6 +427,91 @@ extern "C"
     /* load a 1d-array object by name from a given parent catalog */
     int de_load_tseries(de_file de, obj_id_t id, tseries_t *tseries);
 
+    typedef enum
+    {
+        align_intersection = 0, /* the common range of all series */
+        align_union,            /* the smallest range that contains all series */
+    } align_mode_t;
+
+    /*
+        load several tseries aligned on a common range axis into a column-major
+        matrix, one column per series.
+        NOTES:
+        * all tseries must have range axes of the same frequency and the same
+          element type and size.
+        * the aligned range is computed from the axes alone. It is written in
+          `axis`, whose `id` is set to 0 since the axis is not stored in the file.
+        * only the part of each value that falls in the aligned range is read
+          from the file. With align_union the remaining elements are filled with
+          NaN if the element type is type_float and with zeros otherwise.
+        * `nbytes` follows the same protocol as in de_pack_strings. If `*nbytes`
+          is negative on entry, `value` is not accessed and only `axis`, `eltype`
+          and the required number of bytes are calculated.
+        * `eltype` may be NULL.
+    */
+    int de_load_aligned(de_file de, int64_t n, const obj_id_t *ids, align_mode_t mode,
+                        axis_t *axis, type_t *eltype, int64_t *nbytes, void *value);
+
+    /*
+        load the value of a 1d-array object converted to elements of type
+        `eltype` and size `elsize` bytes.
+        NOTES:
+        * the stored elements and the requested ones must be numeric: type_signed
+          or type_unsigned of size 1, 2, 4 or 8, or type_float of size 4 or 8.
+        * floats are truncated towards zero when converted to integers. If any
+          element can't be represented in the requested type, for example NaN (a
+          missing value) or a number that is too large, we return DE_RANGE and
+          `value` is left as it was.
+        * `nbytes` follows the same protocol as in de_pack_strings.
+    */
+    int de_load_tseries_as(de_file de, obj_id_t id, type_t eltype, int64_t elsize,
+                           int64_t *nbytes, void *value);
+
+    /* ***************************** fconvert ************************************ */
+
+    typedef enum
+    {
+        /* from higher to lower frequency (aggregation) */
+        fconv_mean = 0, /* average of the values in each period */
+        fconv_sum,      /* sum of the values in each period */
+        fconv_first,    /* first non-missing value in each period */
+        fconv_last,     /* last non-missing value in each period */
+        fconv_eop,      /* value in the last sub-period, i.e. end of period */
+        /* from lower to higher frequency (interpolation) */
+        fconv_const,  /* repeat the value in each sub-period */
+        fconv_even,   /* divide the value evenly among the sub-periods */
+        fconv_linear, /* linear interpolation between end-of-period values */
+    } fconv_method_t;
+
+    /* compute the range of dates that results from converting the range
+       `first:first+length-1` of frequency `freq` to frequency `to_freq`. When
+       aggregating, only periods fully covered by the given range are included. */
+    int de_fconvert_range(frequency_t freq, date_t first, int64_t length,
+                          frequency_t to_freq, fconv_method_t method,
+                          date_t *to_first, int64_t *to_length);
+
+    /*
+        convert the values of a tseries to a different frequency.
+        NOTES:
+        * the tseries must have a range axis and numeric elements (signed,
+          unsigned or float). The result is always written as double.
+        * each period of the higher frequency must lie within one period of the
+          lower frequency, otherwise we return DE_BAD_FREQ. E.g. weeks don't nest
+          in months, nor quarters ending in January in years ending in December.
+        * missing values are NaN; they propagate into mean and sum and are skipped
+          by first and last.
+        * on entry `*to_length` must contain the number of doubles available in
+          `value`. If it is negative, `value` is not accessed and only the range of
+          the result is calculated. If it is too small, the required length is
+          written in `*to_length` and we return DE_SHORT_BUF.
+    */
+    int de_fconvert_tseries(const tseries_t *tseries, frequency_t to_freq, fconv_method_t method,
+                            date_t *to_first, int64_t *to_length, double *value);
+
+    /* same as de_fconvert_tseries, but the tseries is loaded from the file by its id */
+    int de_load_tseries_fconvert(de_file de, obj_id_t id, frequency_t to_freq, fconv_method_t method,
+                                 date_t *to_first, int64_t *to_length, double *value);
+
     /* ***************************** mvtseries *********************************** */
 
     typedef struct
@@ -338,9 +535,51 @@ extern "C"
                            int64_t nbytes, const void *value,
                            obj_id_t *id);
 
-    /* load a 2d-array object by name from a given parent catalog */
+    /* load a 2d-array object by name from a given parent catalog. The value is
+       always in column-major order; one stored in row-major order (see
+       de_store_mvtseries_order) is transposed as in de_load_mvtseries_order. */
     int de_load_mvtseries(de_file de, obj_id_t id, mvtseries_t *mvtseries);
 
+    typedef enum
+    {
+        order_col_major = 0, /* elements along axis1 are contiguous (this is the default) */
+        order_row_major,     /* elements along axis2 are contiguous */
+    } order_t;
+
+    /* same as de_store_mvtseries, but the value is in the given order. The order
+       is recorded with the object. */
+    int de_store_mvtseries_order(de_file de, obj_id_t pid, const char *name, type_t obj_type,
+                                 type_t eltype, frequency_t elfreq,
+                                 axis_id_t axis1_id, axis_id_t axis2_id,
+                                 order_t order, int64_t nbytes, const void *value,
+                                 obj_id_t *id);
+
+    /* get the order in which the value of a 2d-array object is stored */
+    int de_get_mvtseries_order(de_file de, obj_id_t id, order_t *order);
+
+    /* same as de_load_mvtseries, but the value is returned in the requested
+       order. If it is stored in the other order, the elements are transposed into
+       memory managed by the library, valid until the next library call. */
+    int de_load_mvtseries_order(de_file de, obj_id_t id, order_t order, mvtseries_t *mvtseries);
+
+    /* load a hyperslab of a 2d-array object, e.g. some of its columns. This works
+       like de_load_ndtseries_slice with two axes, axis1 being the first. To load
+       column j use start = {0, j}, count = {axis1.length, 1}. The result is always
+       in column-major order, regardless of the order the value is stored in. */
+    int de_load_mvtseries_slice(de_file de, obj_id_t id,
+                                const int64_t *start, const int64_t *count, const int64_t *stride,
+                                int64_t *nbytes, void *value);
+
+    /* same as de_store_mvtseries, but the value is split into chunks of shape
+       `chunk_shape[0]` x `chunk_shape[1]`, each stored separately. See
+       de_store_ndtseries_chunked. */
+    int de_store_mvtseries_chunked(de_file de, obj_id_t pid, const char *name, type_t obj_type,
+                                   type_t eltype, frequency_t elfreq,
+                                   axis_id_t axis1_id, axis_id_t axis2_id,
+                                   const int64_t *chunk_shape,
+                                   int64_t nbytes, const void *value,
+                                   obj_id_t *id);
+
     /* ***************************** ndtseries *********************************** */
 
     typedef struct
@@ -367,6 +606,74 @@ extern "C"
     /* load a Nd-array object by name from a given parent catalog */
     int de_load_ndtseries(de_file de, obj_id_t id, ndtseries_t *ndtseries);
 
+    /* same as de_store_ndtseries, but the value is split into chunks of shape
+       `chunk_shape` (one number per axis), each stored separately. Reading a
+       hyperslab of a chunked object only touches the chunks that contain
+       selected elements. Chunks at the end of an axis are truncated to the
+       length of the axis. The elements must be of fixed size, i.e. `nbytes` must
+       be a multiple of the number of elements. */
+    int de_store_ndtseries_chunked(de_file de, obj_id_t pid, const char *name, type_t obj_type,
+                                   type_t eltype, frequency_t elfreq,
+                                   int64_t naxes, const axis_id_t *axis_ids,
+                                   const int64_t *chunk_shape,
+                                   int64_t nbytes, const void *value,
+                                   obj_id_t *id);
+
+    /*
+        load a hyperslab of a Nd-array object.
+        NOTES:
+        * `start`, `count` and `stride` have one entry per axis. Along axis k we
+          select the `count[k]` elements at positions `start[k]`,
+          `start[k] + stride[k]`, etc. `stride` may be NULL, meaning 1 for all axes.
+        * the selected elements are written in `value` in column-major order, i.e.
+          as an Nd-array of shape `count`. Return DE_RANGE if the selection does
+          not fit in the object.
+        * `nbytes` follows the same protocol as in de_pack_strings.
+    */
+    int de_load_ndtseries_slice(de_file de, obj_id_t id,
+                                const int64_t *start, const int64_t *count, const int64_t *stride,
+                                int64_t *nbytes, void *value);
+
+    /* ***************************** calendar ************************************ */
+
+    typedef int64_t calendar_id_t;
+
+    struct de_calendar_s;
+    typedef struct de_calendar_s de_calendar_t;
+    typedef de_calendar_t *de_calendar;
+
+    /* create a new business-day calendar with the given name. It covers the days
+       from `first` to `last` (freq_daily dates). Days in this range that fall on
+       a weekend or are listed in `holidays` (freq_daily dates) are not business
+       days. Return DE_EXISTS if a calendar with this name already exists. */
+    int de_store_calendar(de_file de, const char *name, date_t first, date_t last,
+                          int64_t nholidays, const date_t *holidays, calendar_id_t *id);
+
+    /* find the id of a calendar from its name */
+    int de_find_calendar(de_file de, const char *name, calendar_id_t *id);
+
+    /* load a calendar and prepare it for date conversions. The calendar is
+       independent of the file and must be released with de_finalize_calendar. */
+    int de_load_calendar(de_file de, calendar_id_t id, de_calendar *cal);
+
+    /* release the resources of a calendar */
+    int de_finalize_calendar(de_calendar cal);
+
+    /* get the range of days covered by the calendar and the number of business days in it */
+    int de_calendar_info(de_calendar cal, date_t *first, date_t *last, int64_t *count);
+
+    /* convert a date of frequency freq_daily or freq_bdaily to the index of the
+       business day in the calendar. Index 0 is the first business day in the
+       calendar. If the date is not a business day, `index` is set to the
+       following business day and we return DE_INEXACT. Return DE_RANGE if the
+       date is not covered by the calendar, or if it is not a business day and
+       none follows it in the calendar; `index` is then left unchanged. */
+    int de_calendar_index(de_calendar cal, frequency_t freq, date_t date, int64_t *index);
+
+    /* convert the index of a business day in the calendar to a date of frequency
+       freq_daily or freq_bdaily. Return DE_RANGE if the index is not valid. */
+    int de_calendar_date(de_calendar cal, frequency_t freq, int64_t index, date_t *date);
+
     /* ***************************** misc **************************************** */
 
     /*
@@ -424,6 +731,301 @@ extern "C"
     /* Release resources allocated for the given search. */
     int de_finalize_search(de_search search);
 
+    /* ***************************** stream ************************************** */
+
+    struct de_writer_s;
+    typedef struct de_writer_s de_writer_t;
+    typedef de_writer_t *de_writer;
+
+    /*
+        create a new 1d-array object and open a writer for its value, which is
+        then written in pieces with de_write_next.
+        NOTES:
+        * the object is created right away with `nbytes` zero bytes as its value.
+          The pieces given to de_write_next go directly into the file, so the
+          memory used does not depend on the size of the value.
+        * the writer must be closed with de_close_writer before anything else is
+          changed in the file and before the file is closed.
+        * a value larger than fits in one row of the file (1 GB, unless SQLite was
+          compiled with a different SQLITE_MAX_LENGTH) is split into chunks, as in
+          de_open_mvtseries_writer. Vintages can't be appended to such an object.
+    */
+    int de_open_tseries_writer(de_file de, obj_id_t pid, const char *name, type_t obj_type,
+                               type_t eltype, frequency_t elfreq,
+                               axis_id_t axis_id, int64_t nbytes,
+                               obj_id_t *id, de_writer *writer);
+
+    /* same as de_open_tseries_writer, for a 2d-array object in column-major
+       order. If `chunk_shape` is NULL, the value is stored in one piece when it
+       fits in the file and is otherwise split into chunks of whole columns. If
+       `chunk_shape` is given (see de_store_mvtseries_chunked), its chunks must
+       span all of axis1, otherwise we return DE_ARG. */
+    int de_open_mvtseries_writer(de_file de, obj_id_t pid, const char *name, type_t obj_type,
+                                 type_t eltype, frequency_t elfreq,
+                                 axis_id_t axis1_id, axis_id_t axis2_id,
+                                 const int64_t *chunk_shape, int64_t nbytes,
+                                 obj_id_t *id, de_writer *writer);
+
+    /* same as de_open_mvtseries_writer, for a Nd-array object. Chunks must span
+       all axes except the last one. */
+    int de_open_ndtseries_writer(de_file de, obj_id_t pid, const char *name, type_t obj_type,
+                                 type_t eltype, frequency_t elfreq,
+                                 int64_t naxes, const axis_id_t *axis_ids,
+                                 const int64_t *chunk_shape, int64_t nbytes,
+                                 obj_id_t *id, de_writer *writer);
+
+    /* write the next `nbytes` bytes of the value. Return DE_RANGE if this goes
+       past the size given when the writer was opened. If the byte order of the
+       file is not that of the host, the elements are swapped on their way to
+       the file, and `nbytes` must be a multiple of their size (DE_ARG). */
+    int de_write_next(de_writer writer, int64_t nbytes, const void *buffer);
+
+    /* release the resources of a writer. Return DE_ARG if fewer bytes were
+       written than the size given when it was opened; the rest of the value
+       remains zero. */
+    int de_close_writer(de_writer writer);
+
+    struct de_reader_s;
+    typedef struct de_reader_s de_reader_t;
+    typedef de_reader_t *de_reader;
+
+    /*
+        open a reader for the value of a tseries, mvtseries or ndtseries object,
+        which is then read in pieces with de_read_next.
+        NOTES:
+        * `nbytes` (may be NULL) receives the size of the value.
+        * the bytes come in the order in which they are stored (see
+          de_get_mvtseries_order). Chunked values are reassembled in column-major
+          order.
+        * the value is read directly from the file, one piece at a time, so the
+          memory used does not depend on the size of the value. The file must not
+          be modified while the reader is open.
+        * the elements are in the byte order of the host, as with the other ways
+          to load a value (see de_set_byte_order).
+    */
+    int de_open_reader(de_file de, obj_id_t id, int64_t *nbytes, de_reader *reader);
+
+    /* read the next bytes of the value. On entry `*nbytes` is the size of
+       `buffer`. On exit it is the number of bytes written in `buffer`, which is
+       less than the size of `buffer` only at the end of the value and 0 after
+       the value has been read completely. If the byte order of the file is not
+       that of the host, the size of `buffer` must be a multiple of the size of
+       the elements (DE_ARG). */
+    int de_read_next(de_reader reader, int64_t *nbytes, void *buffer);
+
+    /* release the resources of a reader. */
+    int de_close_reader(de_reader reader);
+
+    /* ***************************** vintage ************************************* */
+
+    /*
+        append a new vintage (revision) to a 1d-array object. The vintage becomes
+        the value of the object and is added to its history.
+        NOTES:
+        * `timestamp` identifies the vintage, e.g. the time of its release. It can
+          be any number, but each vintage must have a larger timestamp than the
+          previous one, otherwise we return DE_ARG.
+        * the axis may differ from that of the previous vintage, but the element
+          type is that of the object.
+        * the history keeps most vintages as the bytes that changed since the
+          previous one, so revisions that touch a few elements or extend the
+          range take little space. Every 16 vintages (and whenever the changes
+          are large) the full value is kept instead, so that loading any vintage
+          never goes through more than 15 sets of changes.
+        * the value the object had before its first vintage is not part of the
+          history.
+    */
+    int de_append_vintage(de_file de, obj_id_t id, int64_t timestamp,
+                          axis_id_t axis_id, int64_t nbytes, const void *value);
+
+    /* load the vintage of a 1d-array object that was in effect at `timestamp`,
+       i.e. the last one appended with a timestamp not larger than it. Return
+       DE_OBJ_DNE if there is none. The memory of the value is managed by the
+       library and is valid until the next library call. */
+    int de_load_tseries_asof(de_file de, obj_id_t id, int64_t timestamp, tseries_t *tseries);
+
+    /* ***************************** copy **************************************** */
+
+    /*
+        copy object `src_id` of file `src`, and everything under it if it is a
+        catalog, into catalog `dst_pid` of file `dst` under the given name.
+        NOTES:
+        * the copy is done by the database engine, table by table. Values are
+          copied as they are stored, without going through the memory of the
+          caller. Axes are matched with those already in `dst`, and shared values
+          (see de_set_dedup) with those in its store.
+        * `src` and `dst` may be the same file, but then `dst_pid` must not be
+          in the copied subtree (DE_ARG).
+        * pending changes in both files are committed first. If `src` and `dst`
+          are different, `src` must be a file on disk (not in memory) with the
+          same version and byte order as `dst`, otherwise we return DE_ARG.
+        * the new objects get new creation times. `id` (may be NULL) receives the
+          id of the copy of `src_id`.
+    */
+    int de_copy_subtree(de_file src, obj_id_t src_id, de_file dst, obj_id_t dst_pid,
+                        const char *name, obj_id_t *id);
+
+    /* what to do with an object of the source that is at the same path as one in
+       the destination, unless both are catalogs, which are merged */
+    typedef enum
+    {
+        merge_skip = 0,  /* keep the object in the destination */
+        merge_overwrite, /* replace the object in the destination */
+        merge_rename,    /* copy the object under a new name, e.g. "name~1" */
+    } merge_mode_t;
+
+    /*
+        merge everything in file `src` into file `dst`. Catalogs at the same path
+        in both files are merged and the other objects of `src` are copied as
+        with de_copy_subtree. `mode` settles conflicts, whose number `nconflicts`
+        (may be NULL) receives.
+        NOTES:
+        * the attributes of merged catalogs are added to those in `dst`. Those
+          with the same name are replaced only in mode merge_overwrite.
+        * attributes of the root catalog are not merged.
+        * the merge is one transaction: if it fails, `dst` is left unchanged.
+    */
+    int de_merge(de_file src, de_file dst, merge_mode_t mode, int64_t *nconflicts);
+
+    /* ***************************** backup ************************************** */
+
+    /* called between the steps of a long operation, with the number of steps
+       done so far and the number of steps. For a copy of a whole file, the steps
+       are its pages */
+    typedef void (*de_progress_t)(int64_t done, int64_t total);
+
+    /*
+        open a copy in memory of a daec file, e.g. for many changes at the speed
+        of memory. The file itself is closed right away and is not changed
+        unless the copy is saved over it with de_save_as.
+    */
+    int de_open_file_in_memory(const char *fname, de_file *de);
+
+    /*
+        save the whole content of `de` to file `fname`, replacing it if it
+        exists. Pending changes in `de` are committed first.
+        NOTES:
+        * the content is written into `fname` in one transaction, so other
+          connections to it see either the old or the new content. We wait for
+          their locks, but give up with SQLITE_BUSY (5) if they hold them for too
+          long (see de_backup). If `fname` exists, it must be a database file.
+        * `progress` (may be NULL) is called as the pages are written.
+        * `de` may be in memory or a file on disk. It stays open.
+    */
+    int de_save_as(de_file de, const char *fname, de_progress_t progress);
+
+    /*
+        make a backup copy of `de` in file `fname`, replacing it if it exists,
+        while the file stays in use. Pending changes in `de` are committed first.
+        NOTES:
+        * the copy is made `pages_per_step` pages at a time, with a pause of
+          `sleep_ms` milliseconds after each step. The file is locked only during
+          the steps, so other connections can read and write it in between.
+        * if another connection changes the file, the copy starts over, so that
+          it is always consistent. Changes made through `de` itself (e.g. from
+          the progress function) are added to the copy as they are made.
+        * after 16 restarts, or as many steps in a row that find either file
+          locked by another connection, we give up and return SQLITE_BUSY (5),
+          leaving `fname` as it was. After a locked step we pause for at least
+          100 milliseconds. A larger `pages_per_step` and a shorter `sleep_ms`
+          leave less time for writers to get in.
+        * `progress` (may be NULL) is called after each step, e.g. to report the
+          rate of the copy. After a restart the number of pages done goes back.
+        * the copy is written into `fname` in one transaction, as with
+          de_save_as, so if we give up `fname` is left as it was.
+    */
+    int de_backup(de_file de, const char *fname, int pages_per_step, int sleep_ms, de_progress_t progress);
+
+    /* ***************************** storage ************************************* */
+
+    /* space used by one table or index of a file */
+    typedef struct
+    {
+        const char *name; /* name of the table or index */
+        int64_t nbytes;   /* size of its pages */
+        int64_t unused;   /* bytes not in use within its pages */
+    } table_storage_t;
+
+    /* how the file uses its pages */
+    typedef struct
+    {
+        int64_t page_size;       /* size of a page in bytes */
+        int64_t page_count;      /* number of pages in the file */
+        int64_t free_pages;      /* pages not in use, which de_compact gives back */
+        int auto_vacuum;         /* 0: off, 1: full, 2: incremental (see compact_incremental) */
+        int64_t ntables;         /* number of tables and indexes in `tables` */
+        table_storage_t *tables; /* in the order of their names */
+    } storage_stats_t;
+
+    /* report the space used by the file. The memory of the tables is managed by
+       the library and is valid until the next library call. */
+    int de_storage_stats(de_file de, storage_stats_t *stats);
+
+    typedef enum
+    {
+        compact_full = 0,    /* rebuild the file, which drops the free pages and defragments the rest */
+        compact_into,        /* write a compacted copy to a new file, leaving this one as it is */
+        compact_incremental, /* give back the free pages, without moving the rest */
+    } compact_mode_t;
+
+    /*
+        give back the space that is not in use in a file.
+        NOTES:
+        * pending changes are committed first.
+        * compact_full and compact_into take time and temporary space that grow
+          with the size of the file. For compact_into, `fname` must be the name
+          of a new file (it is ignored in the other modes).
+        * compact_incremental is fast when auto_vacuum is incremental: it only
+          truncates the file. Otherwise, it turns incremental auto_vacuum on,
+          which takes a full rebuild this one time.
+    */
+    int de_compact(de_file de, compact_mode_t mode, const char *fname);
+
+    /* ***************************** delete ************************************** */
+
+    /*
+        delete object `id` and everything under it if it is a catalog, as with
+        de_delete_object, but table by table rather than object by object, which
+        is much faster for large catalogs.
+        NOTES:
+        * `progress` (may be NULL) is called after each step with the number of
+          steps done so far and the number of steps.
+        * `ndeleted` (may be NULL) receives the number of objects deleted,
+          including `id` itself.
+        * the delete is one transaction: if it fails, nothing is deleted.
+    */
+    int de_delete_subtree(de_file de, obj_id_t id, de_progress_t progress, int64_t *ndeleted);
+
+    /* ***************************** bulk **************************************** */
+
+    /* options of a bulk load, which may be combined with | */
+    typedef enum
+    {
+        bulk_no_sync = 1,      /* do not wait for the disk when the load is committed */
+        bulk_drop_indexes = 2, /* drop the indexes that only serve foreign keys and build them again at the end */
+    } bulk_option_t;
+
+    /*
+        begin a bulk load, e.g. the first population of a new file. Until
+        de_bulk_end, foreign keys are not checked and object info is deferred
+        (see de_set_defer_info).
+        NOTES:
+        * pending changes are committed first. The load is one transaction.
+        * deleting objects during the load goes through de_delete_subtree,
+          because ON DELETE CASCADE is off with the foreign keys.
+        * functions that commit, e.g. de_copy_subtree or de_save_as, return
+          DE_ARG until the load ends. de_close ends it.
+    */
+    int de_bulk_begin(de_file de, int options);
+
+    /*
+        end the bulk load: fill in the object info, build the dropped indexes,
+        check the foreign keys and commit. If anything fails, e.g. a value refers
+        to an axis that does not exist, everything since de_bulk_begin is rolled
+        back. Either way, the file is back to its usual settings.
+    */
+    int de_bulk_end(de_file de);
+
 #ifdef __cplusplus
 }
 #endif
@@ -68,3 +68,15 @@ int de_load_axis(de_file de, axis_id_t id, axis_t *axis)
     TRACE_RUN(sql_load_axis(de, id, axis));
     return DE_SUCCESS;
 }
+
+int de_gc_axes(de_file de, int64_t *removed)
+{
+    if (de == NULL)
+        return error(DE_NULL);
+    TRACE_RUN(de_begin_transaction(de));
+    int64_t count;
+    TRACE_RUN(sql_gc_axes(de, &count));
+    if (removed != NULL)
+        *removed = count;
+    return DE_SUCCESS;
+}
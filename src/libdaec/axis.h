@@ -40,6 +40,16 @@ int de_axis_names(de_file de, int64_t length, const char *names, axis_id_t *id);
 /* load an axis from its id */
 int de_load_axis(de_file de, axis_id_t id, axis_t *axis);
 
+/*
+    delete the axes that are not used by any object, e.g. those of deleted
+    objects. `removed` (may be NULL) receives the number of axes deleted.
+    NOTES:
+    * axes are shared by all objects with equal axes, so they are not deleted
+      together with the objects using them.
+    * the ids of axes made but not yet used by an object are no longer valid.
+*/
+int de_gc_axes(de_file de, int64_t *removed);
+
 /* ========================================================================= */
 /* internal */
 
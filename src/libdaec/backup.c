@@ -0,0 +1,108 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <sqlite3.h>
+
+#include "error.h"
+#include "file.h"
+#include "backup.h"
+
+/* copy database `src` into database `dst`, `pages` pages at a time, pausing
+   `sleep_ms` milliseconds between steps. SQLite starts the copy over when
+   another connection changes `src`, and a step fails while another
+   connection holds a lock on either file; we give up after
+   DE_BACKUP_RESTARTS restarts, or as many locked steps in a row, rather
+   than run for as long as the other connection goes on. */
+static int _backup(sqlite3 *dst, sqlite3 *src, int pages, int sleep_ms, de_progress_t progress)
+{
+    sqlite3_backup *backup = sqlite3_backup_init(dst, "main", src, "main");
+    if (backup == NULL)
+        return set_db_error(dst, __func__, __FILE__, __LINE__);
+    int rc, restarts = 0, locked = 0;
+    int64_t done = 0;
+    do
+    {
+        rc = sqlite3_backup_step(backup, pages);
+        const int64_t total = sqlite3_backup_pagecount(backup);
+        const int64_t now = total - sqlite3_backup_remaining(backup);
+        /* a step that copied pages but is no further along started over */
+        if (rc == SQLITE_OK && now <= done && ++restarts > DE_BACKUP_RESTARTS)
+        {
+            rc = SQLITE_BUSY;
+            break;
+        }
+        locked = (rc == SQLITE_BUSY || rc == SQLITE_LOCKED) ? locked + 1 : 0;
+        if (locked > DE_BACKUP_RESTARTS)
+            break;
+        done = now;
+        if (progress != NULL)
+            progress(done, total);
+        /* wait for a while if another connection is writing the file */
+        if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
+            sqlite3_sleep(sleep_ms > DE_BACKUP_BUSY_MS ? sleep_ms : DE_BACKUP_BUSY_MS);
+        else if (rc == SQLITE_OK && sleep_ms > 0)
+            sqlite3_sleep(sleep_ms);
+    } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+    int rc_fin = sqlite3_backup_finish(backup);
+    if (rc != SQLITE_DONE)
+        return rc_error(rc);
+    if (rc_fin != SQLITE_OK)
+        return rc_error(rc_fin);
+    return DE_SUCCESS;
+}
+
+int de_open_file_in_memory(const char *fname, de_file *pde)
+{
+    if (fname == NULL || pde == NULL)
+        return error(DE_NULL);
+    sqlite3 *source;
+    int rc = sqlite3_open_v2(fname, &source, SQLITE_OPEN_READONLY, NULL);
+    if (rc != SQLITE_OK)
+    {
+        sqlite3_close(source);
+        return rc_error(rc);
+    }
+    rc = _open(":memory:", pde, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_MEMORY, source);
+    sqlite3_close(source);
+    TRACE_RUN(rc);
+    return DE_SUCCESS;
+}
+
+/* copy database `src` to file `fname` as _backup does. The copy is written
+   through a connection to `fname` itself, in one transaction that respects
+   the locks of other connections to it, so they see either the old or the
+   new content, and a hot journal left in `fname` is dealt with first. */
+static int _save(sqlite3 *src, const char *fname, int pages, int sleep_ms, de_progress_t progress)
+{
+    sqlite3 *dst;
+    int rc = sqlite3_open_v2(fname, &dst, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+    if (rc != SQLITE_OK)
+        rc = rc_error(rc);
+    else
+        rc = _backup(dst, src, pages, sleep_ms, progress);
+    int rc_close = sqlite3_close(dst);
+    if (rc == DE_SUCCESS && rc_close != SQLITE_OK)
+        rc = rc_error(rc_close);
+    return rc;
+}
+
+int de_save_as(de_file de, const char *fname, de_progress_t progress)
+{
+    if (de == NULL || fname == NULL)
+        return error(DE_NULL);
+    TRACE_RUN(de_commit(de));
+    TRACE_RUN(_save(de->db, fname, DE_SAVE_STEP, 0, progress));
+    return DE_SUCCESS;
+}
+
+int de_backup(de_file de, const char *fname, int pages_per_step, int sleep_ms, de_progress_t progress)
+{
+    if (de == NULL || fname == NULL)
+        return error(DE_NULL);
+    if (pages_per_step <= 0 || sleep_ms < 0)
+        return error(DE_ARG);
+    /* the backup includes only committed changes */
+    TRACE_RUN(de_commit(de));
+    TRACE_RUN(_save(de->db, fname, pages_per_step, sleep_ms, progress));
+    return DE_SUCCESS;
+}
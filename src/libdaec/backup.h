@@ -0,0 +1,71 @@
+#ifndef __BACKUP_H__
+#define __BACKUP_H__
+
+#include <stdint.h>
+
+#include "file.h"
+
+/* ========================================================================= */
+/* API */
+
+/* called between the steps of a long operation, with the number of steps
+   done so far and the number of steps. For a copy of a whole file, the steps
+   are its pages */
+typedef void (*de_progress_t)(int64_t done, int64_t total);
+
+/*
+    open a copy in memory of a daec file, e.g. for many changes at the speed
+    of memory. The file itself is closed right away and is not changed
+    unless the copy is saved over it with de_save_as.
+*/
+int de_open_file_in_memory(const char *fname, de_file *de);
+
+/*
+    save the whole content of `de` to file `fname`, replacing it if it
+    exists. Pending changes in `de` are committed first.
+    NOTES:
+    * the content is written into `fname` in one transaction, so other
+      connections to it see either the old or the new content. We wait for
+      their locks, but give up with SQLITE_BUSY (5) if they hold them for too
+      long (see de_backup). If `fname` exists, it must be a database file.
+    * `progress` (may be NULL) is called as the pages are written.
+    * `de` may be in memory or a file on disk. It stays open.
+*/
+int de_save_as(de_file de, const char *fname, de_progress_t progress);
+
+/*
+    make a backup copy of `de` in file `fname`, replacing it if it exists,
+    while the file stays in use. Pending changes in `de` are committed first.
+    NOTES:
+    * the copy is made `pages_per_step` pages at a time, with a pause of
+      `sleep_ms` milliseconds after each step. The file is locked only during
+      the steps, so other connections can read and write it in between.
+    * if another connection changes the file, the copy starts over, so that
+      it is always consistent. Changes made through `de` itself (e.g. from
+      the progress function) are added to the copy as they are made.
+    * after DE_BACKUP_RESTARTS (16) restarts, or as many steps in a row that find
+      either file locked by another connection, we give up and return
+      SQLITE_BUSY (5), leaving `fname` as it was. After a locked step we
+      pause for at least 100 milliseconds. A larger `pages_per_step`
+      and a shorter `sleep_ms` leave less time for writers to get in.
+    * `progress` (may be NULL) is called after each step, e.g. to report the
+      rate of the copy. After a restart the number of pages done goes back.
+    * the copy is written into `fname` in one transaction, as with
+      de_save_as, so if we give up `fname` is left as it was.
+*/
+int de_backup(de_file de, const char *fname, int pages_per_step, int sleep_ms, de_progress_t progress);
+
+/* ========================================================================= */
+/* internal */
+
+/* number of pages written between calls to the progress function */
+#define DE_SAVE_STEP 1024
+
+/* number of times a backup starts over, or finds a file locked in a row,
+   before we give up */
+#define DE_BACKUP_RESTARTS 16
+
+/* the least pause in milliseconds after a step that finds a file locked */
+#define DE_BACKUP_BUSY_MS 100
+
+#endif
@@ -0,0 +1,170 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <sqlite3.h>
+
+#include "error.h"
+#include "file.h"
+#include "bulk.h"
+
+/*
+    Foreign keys can only be turned off outside of transactions, so the
+    load begins with a commit and the pragmas, then a transaction that lasts
+    until de_bulk_end. Dropped indexes are kept, with their SQL, in a
+    temporary table, which a rollback takes away together with the rest.
+*/
+
+/* indexes used only by the checks of foreign keys, which are off */
+static const char *_indexes[] = {
+    "tseries_1", "tseries_2", "mvtseries_1", "mvtseries_2",
+    "mvtseries_3", "ndtseries_1", "ndaxes_1", "vintages_2",
+};
+
+#define _NINDEXES ((int)(sizeof _indexes / sizeof _indexes[0]))
+
+static int _exec(de_file de, const char *sql)
+{
+    if (SQLITE_OK != sqlite3_exec(de->db, sql, NULL, NULL, NULL))
+        return db_error(de);
+    return DE_SUCCESS;
+}
+
+static int _drop_indexes(de_file de)
+{
+    TRACE_RUN(_exec(de, "CREATE TEMP TABLE `de_bulk_indexes` (`name` TEXT PRIMARY KEY, `sql` TEXT NOT NULL);"));
+    _reset_stmts(de);
+    for (int i = 0; i < _NINDEXES; ++i)
+    {
+        char sql[256];
+        snprintf(sql, sizeof sql,
+                 "INSERT INTO temp.`de_bulk_indexes` SELECT `name`, `sql` FROM `sqlite_master`"
+                 "   WHERE `type` = 'index' AND `name` = '%s';"
+                 "DROP INDEX IF EXISTS `%s`;",
+                 _indexes[i], _indexes[i]);
+        TRACE_RUN(_exec(de, sql));
+    }
+    return DE_SUCCESS;
+}
+
+static int _build_indexes(de_file de)
+{
+    sqlite3_stmt *stmt;
+    if (SQLITE_OK != sqlite3_prepare_v2(de->db, "SELECT `sql` FROM temp.`de_bulk_indexes` WHERE `name` = ?;", -1, &stmt, NULL))
+        return db_error(de);
+    int rc = DE_SUCCESS;
+    for (int i = 0; i < _NINDEXES && rc == DE_SUCCESS; ++i)
+    {
+        sqlite3_reset(stmt);
+        sqlite3_bind_text(stmt, 1, _indexes[i], -1, SQLITE_STATIC);
+        int step = sqlite3_step(stmt);
+        if (step == SQLITE_ROW)
+            rc = _exec(de, (const char *)sqlite3_column_text(stmt, 0));
+        else if (step != SQLITE_DONE)
+            rc = db_error(de);
+    }
+    sqlite3_finalize(stmt);
+    if (rc != DE_SUCCESS)
+        return trace_error();
+    _reset_stmts(de);
+    TRACE_RUN(_exec(de, "DROP TABLE temp.`de_bulk_indexes`;"));
+    return DE_SUCCESS;
+}
+
+static int _check_foreign_keys(de_file de)
+{
+    sqlite3_stmt *stmt;
+    if (SQLITE_OK != sqlite3_prepare_v2(de->db, "PRAGMA foreign_key_check;", -1, &stmt, NULL))
+        return db_error(de);
+    int rc;
+    switch ((rc = sqlite3_step(stmt)))
+    {
+    case SQLITE_DONE:
+        rc = DE_SUCCESS;
+        break;
+    case SQLITE_ROW:
+        rc = error1(DE_BAD_OBJ, (const char *)sqlite3_column_text(stmt, 0));
+        break;
+    default:
+        rc = db_error(de);
+        break;
+    }
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+/* go back to the usual settings, after a commit or, if `rollback`, after
+   undoing the load */
+static void _restore(de_file de, bool rollback)
+{
+    if (rollback)
+    {
+        _reset_stmts(de);
+        sqlite3_exec(de->db, "ROLLBACK;", NULL, NULL, NULL);
+        de->transaction = false;
+        de->info_from = 0;
+    }
+    char sql[128];
+    snprintf(sql, sizeof sql, "PRAGMA foreign_keys = ON; PRAGMA synchronous = %d;", de->bulk.sync);
+    sqlite3_exec(de->db, sql, NULL, NULL, NULL);
+    de->defer_info = de->bulk.defer_info;
+    de->bulk.on = false;
+}
+
+int de_bulk_begin(de_file de, int options)
+{
+    if (de == NULL)
+        return error(DE_NULL);
+    if (de->bulk.on)
+        return error1(DE_ARG, "a bulk load is already in progress");
+    TRACE_RUN(de_commit(de));
+
+    sqlite3_stmt *stmt;
+    if (SQLITE_OK != sqlite3_prepare_v2(de->db, "PRAGMA synchronous;", -1, &stmt, NULL))
+        return db_error(de);
+    int rc = sqlite3_step(stmt);
+    int sync = sqlite3_column_int(stmt, 0);
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_ROW)
+        return rc_error(rc);
+
+    TRACE_RUN(_exec(de, (options & bulk_no_sync) ? "PRAGMA foreign_keys = OFF; PRAGMA synchronous = OFF;"
+                                                   : "PRAGMA foreign_keys = OFF;"));
+    de->bulk.on = true;
+    de->bulk.options = options;
+    de->bulk.sync = sync;
+    de->bulk.defer_info = de->defer_info;
+    de->defer_info = true;
+    rc = de_begin_transaction(de);
+    if (rc == DE_SUCCESS && (options & bulk_drop_indexes))
+        rc = _drop_indexes(de);
+    if (rc != DE_SUCCESS)
+    {
+        _restore(de, true);
+        return trace_error();
+    }
+    return DE_SUCCESS;
+}
+
+int de_bulk_end(de_file de)
+{
+    if (de == NULL)
+        return error(DE_NULL);
+    if (!de->bulk.on)
+        return error1(DE_ARG, "no bulk load in progress");
+    int rc = _fill_object_info(de);
+    if (rc == DE_SUCCESS && (de->bulk.options & bulk_drop_indexes))
+        rc = _build_indexes(de);
+    if (rc == DE_SUCCESS)
+        rc = _check_foreign_keys(de);
+    if (rc == DE_SUCCESS)
+    {
+        de->bulk.on = false;
+        rc = de_commit(de);
+    }
+    _restore(de, rc != DE_SUCCESS);
+    if (rc != DE_SUCCESS)
+        return trace_error();
+    return DE_SUCCESS;
+}
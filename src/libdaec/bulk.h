@@ -0,0 +1,40 @@
+#ifndef __BULK_H__
+#define __BULK_H__
+
+#include "file.h"
+
+/* ========================================================================= */
+/* API */
+
+/* options of a bulk load, which may be combined with | */
+typedef enum
+{
+    bulk_no_sync = 1,      /* do not wait for the disk when the load is committed */
+    bulk_drop_indexes = 2, /* drop the indexes that only serve foreign keys and build them again at the end */
+} bulk_option_t;
+
+/*
+    begin a bulk load, e.g. the first population of a new file. Until
+    de_bulk_end, foreign keys are not checked and object info is deferred
+    (see de_set_defer_info).
+    NOTES:
+    * pending changes are committed first. The load is one transaction.
+    * deleting objects during the load goes through de_delete_subtree,
+      because ON DELETE CASCADE is off with the foreign keys.
+    * functions that commit, e.g. de_copy_subtree or de_save_as, return
+      DE_ARG until the load ends. de_close ends it.
+*/
+int de_bulk_begin(de_file de, int options);
+
+/*
+    end the bulk load: fill in the object info, build the dropped indexes,
+    check the foreign keys and commit. If anything fails, e.g. a value refers
+    to an axis that does not exist, everything since de_bulk_begin is rolled
+    back. Either way, the file is back to its usual settings.
+*/
+int de_bulk_end(de_file de);
+
+/* ========================================================================= */
+/* internal */
+
+#endif
@@ -0,0 +1,155 @@
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "error.h"
+#include "file.h"
+#include "object.h"
+#include "dates.h"
+#include "calendar.h"
+#include "convert.h"
+#include "sql.h"
+
+int de_store_calendar(de_file de, const char *name, date_t first, date_t last,
+                      int64_t nholidays, const date_t *holidays, calendar_id_t *id)
+{
+    if (de == NULL || name == NULL || (nholidays > 0 && holidays == NULL))
+        return error(DE_NULL);
+    if (!_check_name(name))
+        return trace_error();
+    if (last < first || last - first >= INT32_MAX || nholidays < 0)
+        return error(DE_RANGE);
+    int rc = sql_find_calendar(de, name, NULL);
+    if (rc == DE_SUCCESS)
+        return error1(DE_EXISTS, name);
+    if (rc != DE_OBJ_DNE)
+        return trace_error();
+    de_clear_error();
+    TRACE_RUN(_swap_value(de, type_date, nholidays, nholidays * (int64_t)sizeof(date_t), (const void **)&holidays));
+    TRACE_RUN(de_begin_transaction(de));
+    TRACE_RUN(sql_new_calendar(de, name, first, last, nholidays, holidays, id));
+    return DE_SUCCESS;
+}
+
+int de_find_calendar(de_file de, const char *name, calendar_id_t *id)
+{
+    if (de == NULL || name == NULL || id == NULL)
+        return error(DE_NULL);
+    TRACE_RUN(sql_find_calendar(de, name, id));
+    return DE_SUCCESS;
+}
+
+int de_load_calendar(de_file de, calendar_id_t id, de_calendar *pcal)
+{
+    if (de == NULL || pcal == NULL)
+        return error(DE_NULL);
+    date_t first, last;
+    int64_t nholidays;
+    const date_t *holidays;
+    TRACE_RUN(sql_load_calendar(de, id, &first, &last, &nholidays, &holidays));
+    TRACE_RUN(_swap_value(de, type_date, nholidays, nholidays * (int64_t)sizeof(date_t), (const void **)&holidays));
+    if (last < first || last - first >= INT32_MAX)
+        return error(DE_BAD_OBJ);
+    const int64_t ndays = last - first + 1;
+
+    de_calendar cal = calloc(1, sizeof(de_calendar_t));
+    if (cal == NULL)
+        return error(DE_ERR_ALLOC);
+    cal->index = malloc((ndays + 1) * sizeof(int32_t));
+    cal->days = malloc(ndays * sizeof(int32_t));
+    if (cal->index == NULL || cal->days == NULL)
+    {
+        de_finalize_calendar(cal);
+        return error(DE_ERR_ALLOC);
+    }
+    cal->id = id;
+    cal->first = first;
+    cal->last = last;
+
+    /* first mark business days with 1, ... */
+    int32_t *mark = cal->index;
+    for (int64_t k = 0; k < ndays; ++k)
+    {
+        uint32_t weekend;
+        _rata_die_to_profesto(first + k, &weekend);
+        mark[k] = (weekend == 0);
+    }
+    for (int64_t h = 0; h < nholidays; ++h)
+        if (first <= holidays[h] && holidays[h] <= last)
+            mark[holidays[h] - first] = 0;
+
+    /* ... then replace the marks with the cumulative count and record the business days */
+    int32_t count = 0;
+    for (int64_t k = 0; k < ndays; ++k)
+    {
+        const int32_t is_bday = mark[k];
+        mark[k] = count;
+        if (is_bday)
+            cal->days[count++] = k;
+    }
+    mark[ndays] = count;
+    cal->count = count;
+
+    *pcal = cal;
+    return DE_SUCCESS;
+}
+
+int de_finalize_calendar(de_calendar cal)
+{
+    if (cal == NULL)
+        return DE_SUCCESS;
+    free(cal->index);
+    free(cal->days);
+    free(cal);
+    return DE_SUCCESS;
+}
+
+int de_calendar_info(de_calendar cal, date_t *first, date_t *last, int64_t *count)
+{
+    if (cal == NULL)
+        return error(DE_NULL);
+    if (first != NULL)
+        *first = cal->first;
+    if (last != NULL)
+        *last = cal->last;
+    if (count != NULL)
+        *count = cal->count;
+    return DE_SUCCESS;
+}
+
+int de_calendar_index(de_calendar cal, frequency_t freq, date_t date, int64_t *index)
+{
+    if (cal == NULL || index == NULL)
+        return error(DE_NULL);
+    if (freq == freq_bdaily)
+        date = _rata_die_from_profesto(date);
+    else if (freq != freq_daily)
+        return error(DE_BAD_FREQ);
+    if (date < cal->first || date > cal->last)
+        return error(DE_RANGE);
+    const int64_t k = date - cal->first;
+    if (cal->index[k + 1] != cal->index[k])
+    {
+        *index = cal->index[k];
+        return DE_SUCCESS;
+    }
+    /* the following business day may be past the end of the calendar */
+    if (cal->index[k] >= cal->count)
+        return error1(DE_RANGE, "no business day after the date in the calendar");
+    *index = cal->index[k];
+    return error(DE_INEXACT);
+}
+
+int de_calendar_date(de_calendar cal, frequency_t freq, int64_t index, date_t *date)
+{
+    if (cal == NULL || date == NULL)
+        return error(DE_NULL);
+    if (freq != freq_daily && freq != freq_bdaily)
+        return error(DE_BAD_FREQ);
+    if (index < 0 || index >= cal->count)
+        return error(DE_RANGE);
+    const date_t day = cal->first + cal->days[index];
+    *date = (freq == freq_bdaily) ? _rata_die_to_profesto(day, NULL) : day;
+    return DE_SUCCESS;
+}
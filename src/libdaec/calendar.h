@@ -0,0 +1,63 @@
+#ifndef __CALENDAR_H__
+#define __CALENDAR_H__
+
+#include <stdint.h>
+
+#include "file.h"
+#include "dates.h"
+
+/* ========================================================================= */
+/* API */
+
+typedef int64_t calendar_id_t;
+
+struct de_calendar_s;
+typedef struct de_calendar_s de_calendar_t;
+typedef de_calendar_t *de_calendar;
+
+/* create a new business-day calendar with the given name. It covers the days
+   from `first` to `last` (freq_daily dates). Days in this range that fall on
+   a weekend or are listed in `holidays` (freq_daily dates) are not business
+   days. Return DE_EXISTS if a calendar with this name already exists. */
+int de_store_calendar(de_file de, const char *name, date_t first, date_t last,
+                      int64_t nholidays, const date_t *holidays, calendar_id_t *id);
+
+/* find the id of a calendar from its name */
+int de_find_calendar(de_file de, const char *name, calendar_id_t *id);
+
+/* load a calendar and prepare it for date conversions. The calendar is
+   independent of the file and must be released with de_finalize_calendar. */
+int de_load_calendar(de_file de, calendar_id_t id, de_calendar *cal);
+
+/* release the resources of a calendar */
+int de_finalize_calendar(de_calendar cal);
+
+/* get the range of days covered by the calendar and the number of business days in it */
+int de_calendar_info(de_calendar cal, date_t *first, date_t *last, int64_t *count);
+
+/* convert a date of frequency freq_daily or freq_bdaily to the index of the
+   business day in the calendar. Index 0 is the first business day in the
+   calendar. If the date is not a business day, `index` is set to the
+   following business day and we return DE_INEXACT. Return DE_RANGE if the
+   date is not covered by the calendar, or if it is not a business day and
+   none follows it in the calendar; `index` is then left unchanged. */
+int de_calendar_index(de_calendar cal, frequency_t freq, date_t date, int64_t *index);
+
+/* convert the index of a business day in the calendar to a date of frequency
+   freq_daily or freq_bdaily. Return DE_RANGE if the index is not valid. */
+int de_calendar_date(de_calendar cal, frequency_t freq, int64_t index, date_t *date);
+
+/* ========================================================================= */
+/* internal */
+
+struct de_calendar_s
+{
+    calendar_id_t id;
+    date_t first;   /* first day covered, freq_daily */
+    date_t last;    /* last day covered, freq_daily */
+    int64_t count;  /* number of business days */
+    int32_t *index; /* index[k] = number of business days before day first + k, k = 0..last - first + 1 */
+    int32_t *days;  /* days[i] = day of the i-th business day, as offset from first */
+};
+
+#endif
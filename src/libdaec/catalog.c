@@ -7,6 +7,8 @@
 #include "file.h"
 #include "object.h"
 #include "catalog.h"
+#include "sql.h"
+#include "misc.h"
 
 int de_new_catalog(de_file de, obj_id_t pid, const char *name, obj_id_t *id)
 {
@@ -15,3 +17,46 @@ int de_new_catalog(de_file de, obj_id_t pid, const char *name, obj_id_t *id)
     TRACE_RUN(_new_object(de, pid, class_catalog, type_none, name, id));
     return DE_SUCCESS;
 }
+
+int de_catalog_stats(de_file de, obj_id_t id, catalog_stats_t *stats)
+{
+    if (de == NULL || stats == NULL)
+        return error(DE_NULL);
+    bool found, stale;
+    TRACE_RUN(sql_load_catalog_stats(de, id, stats, &found, &stale));
+    if (!found)
+    {
+        /* the statistics are not kept, or `id` is not a catalog */
+        object_t object;
+        TRACE_RUN(sql_load_object(de, id, &object));
+        if (object.obj_class != class_catalog)
+            return error1(DE_BAD_CLASS, _id2str(id));
+        TRACE_RUN(sql_catalog_totals(de, id, stats));
+        return DE_SUCCESS;
+    }
+    if (stale)
+    {
+        TRACE_RUN(sql_catalog_days(de, id, stats));
+        /* don't start a transaction, which would lock the file, for this */
+        if (de->transaction)
+        {
+            TRACE_RUN(sql_store_catalog_days(de, id, stats));
+        }
+    }
+    return DE_SUCCESS;
+}
+
+int de_set_catalog_stats(de_file de, int enable)
+{
+    if (de == NULL)
+        return error(DE_NULL);
+    bool on;
+    TRACE_RUN(_catalog_stats_on(de, &on));
+    if (on == (enable != 0))
+        return DE_SUCCESS;
+    TRACE_RUN(de_begin_transaction(de));
+    /* changes to the schema fail while statements are in progress */
+    _reset_stmts(de);
+    TRACE_RUN(_set_catalog_stats(de, enable != 0));
+    return DE_SUCCESS;
+}
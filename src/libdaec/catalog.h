@@ -10,6 +10,42 @@
 /* create new catalog. return error if catalog already exists */
 int de_new_catalog(de_file de, obj_id_t pid, const char *name, obj_id_t *id);
 
+/* statistics of the objects under a catalog, at any depth */
+typedef struct
+{
+    int64_t count;     /* number of objects */
+    int64_t nbytes;    /* total size of their values */
+    int dated;         /* 0 if none of them has a date axis */
+    int64_t first_day; /* first and last day (dates of frequency freq_daily) */
+    int64_t last_day;  /* covered by their date axes, if `dated` */
+} catalog_stats_t;
+
+/*
+    return the statistics of catalog `id`.
+    NOTES:
+    * unless they are kept in the file (see de_set_catalog_stats), the
+      statistics are computed from every object under the catalog.
+    * shared values (see de_set_dedup) count in full for each object using them.
+    * if they are kept, after objects are deleted the date coverage may need
+      to be recomputed, which takes a look at every object under the catalog.
+      The result is saved, if there are changes to the file that are not yet
+      committed.
+*/
+int de_catalog_stats(de_file de, obj_id_t id, catalog_stats_t *stats);
+
+/*
+    keep the statistics of all catalogs (enable != 0) in the file, or stop
+    keeping them.
+    NOTES:
+    * while they are kept, de_catalog_stats is fast however many objects are
+      under the catalog, but every change to the objects updates the
+      statistics of all the catalogs above them, which makes writes slower.
+    * the setting is saved in the file. It is off in new files and in files
+      upgraded from versions that did not keep statistics. Turning it on
+      computes the statistics of the objects already in the file.
+*/
+int de_set_catalog_stats(de_file de, int enable);
+
 /* ========================================================================= */
 /* internal */
 
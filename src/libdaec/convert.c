@@ -0,0 +1,320 @@
+
+#include <stdint.h>
+#include <string.h>
+
+#include "error.h"
+#include "file.h"
+#include "object.h"
+#include "convert.h"
+
+/*
+    One kernel for each pair of source and destination types. Each is a
+    simple loop that the compiler can vectorize. Instead of branching on
+    elements that are out of range, the kernels accumulate a flag that tells
+    whether all elements were converted exactly. Narrowing conversions first
+    run a check kernel with the same flag and no output, so that we can reject
+    the value before writing anything.
+*/
+
+typedef int (*_kernel_t)(int64_t n, const void *src, void *dst);
+typedef int (*_check_t)(int64_t n, const void *src);
+
+/* integer types as (name, C type, lo, hi). A float x can be converted to the
+   type if lo <= x < hi */
+#define _INT_TYPES(K, D)                       \
+    D(K, i1, int8_t, -0x1p7, 0x1p7)            \
+    D(K, i2, int16_t, -0x1p15, 0x1p15)         \
+    D(K, i4, int32_t, -0x1p31, 0x1p31)         \
+    D(K, i8, int64_t, -0x1p63, 0x1p63)         \
+    D(K, u1, uint8_t, 0.0, 0x1p8)              \
+    D(K, u2, uint16_t, 0.0, 0x1p16)            \
+    D(K, u4, uint32_t, 0.0, 0x1p32)            \
+    D(K, u8, uint64_t, 0.0, 0x1p64)
+
+#define _FLOAT_TYPES(K, D)                     \
+    D(K, f4, float, 0.0, 0.0)                  \
+    D(K, f8, double, 0.0, 0.0)
+
+/* expand K for every destination type */
+#define _TO_INT(K, sn, st, slo, shi)           \
+    K(sn, st, i1, int8_t, -0x1p7, 0x1p7)       \
+    K(sn, st, i2, int16_t, -0x1p15, 0x1p15)    \
+    K(sn, st, i4, int32_t, -0x1p31, 0x1p31)    \
+    K(sn, st, i8, int64_t, -0x1p63, 0x1p63)    \
+    K(sn, st, u1, uint8_t, 0.0, 0x1p8)         \
+    K(sn, st, u2, uint16_t, 0.0, 0x1p16)       \
+    K(sn, st, u4, uint32_t, 0.0, 0x1p32)       \
+    K(sn, st, u8, uint64_t, 0.0, 0x1p64)
+
+#define _TO_FLOAT(K, sn, st, slo, shi)         \
+    K(sn, st, f4, float, 0.0, 0.0)             \
+    K(sn, st, f8, double, 0.0, 0.0)
+
+/* the check kernel of every pair */
+#define _CHECK(sn, st, dn, dt, OK)                                    \
+    static int _check_##sn##_##dn(int64_t n, const void *src)         \
+    {                                                                 \
+        const st *restrict s = src;                                   \
+        int ok = 1;                                                   \
+        for (int64_t i = 0; i < n; ++i)                               \
+        {                                                             \
+            const st x = s[i];                                        \
+            ok &= OK(st, dt, x);                                      \
+        }                                                             \
+        return ok;                                                    \
+    }
+
+/* integer to integer: exact if the value survives the round trip with its sign */
+#define _OK_II(st, dt, x) (((st)(dt)(x) == (x)) & (((x) > 0) == ((dt)(x) > 0)))
+#define _KERNEL_II(sn, st, dn, dt, dlo, dhi)                          \
+    _CHECK(sn, st, dn, dt, _OK_II)                                    \
+    static int _conv_##sn##_##dn(int64_t n, const void *src, void *dst) \
+    {                                                                 \
+        const st *restrict s = src;                                   \
+        dt *restrict d = dst;                                         \
+        int ok = 1;                                                   \
+        for (int64_t i = 0; i < n; ++i)                               \
+        {                                                             \
+            const st x = s[i];                                        \
+            d[i] = (dt)x;                                             \
+            ok &= _OK_II(st, dt, x);                                  \
+        }                                                             \
+        return ok;                                                    \
+    }
+
+/* integer to float: always in range, possibly rounded */
+#define _OK_IF(st, dt, x) ((void)(x), 1)
+#define _KERNEL_IF(sn, st, dn, dt, dlo, dhi)                          \
+    _CHECK(sn, st, dn, dt, _OK_IF)                                    \
+    static int _conv_##sn##_##dn(int64_t n, const void *src, void *dst) \
+    {                                                                 \
+        const st *restrict s = src;                                   \
+        dt *restrict d = dst;                                         \
+        for (int64_t i = 0; i < n; ++i)                               \
+            d[i] = (dt)s[i];                                          \
+        return 1;                                                     \
+    }
+
+/* float to integer: NaN fails both comparisons */
+#define _KERNEL_FI(sn, st, dn, dt, dlo, dhi)                          \
+    static int _check_##sn##_##dn(int64_t n, const void *src)         \
+    {                                                                 \
+        const st *restrict s = src;                                   \
+        int ok = 1;                                                   \
+        for (int64_t i = 0; i < n; ++i)                               \
+            ok &= (s[i] >= dlo) & (s[i] < dhi);                       \
+        return ok;                                                    \
+    }                                                                 \
+    static int _conv_##sn##_##dn(int64_t n, const void *src, void *dst) \
+    {                                                                 \
+        const st *restrict s = src;                                   \
+        dt *restrict d = dst;                                         \
+        int ok = 1;                                                   \
+        for (int64_t i = 0; i < n; ++i)                               \
+        {                                                             \
+            const st x = s[i];                                        \
+            const int in = (x >= dlo) & (x < dhi);                    \
+            d[i] = in ? (dt)x : 0;                                    \
+            ok &= in;                                                 \
+        }                                                             \
+        return ok;                                                    \
+    }
+
+/* float to float: fails if a finite value becomes infinite */
+#define _OK_FF(st, dt, x) ((((dt)(x)) - ((dt)(x)) == 0) | ((x) - (x) != 0))
+#define _KERNEL_FF(sn, st, dn, dt, dlo, dhi)                          \
+    _CHECK(sn, st, dn, dt, _OK_FF)                                    \
+    static int _conv_##sn##_##dn(int64_t n, const void *src, void *dst) \
+    {                                                                 \
+        const st *restrict s = src;                                   \
+        dt *restrict d = dst;                                         \
+        int ok = 1;                                                   \
+        for (int64_t i = 0; i < n; ++i)                               \
+        {                                                             \
+            const st x = s[i];                                        \
+            d[i] = (dt)x;                                             \
+            ok &= _OK_FF(st, dt, x);                                  \
+        }                                                             \
+        return ok;                                                    \
+    }
+
+_INT_TYPES(_KERNEL_II, _TO_INT)
+_INT_TYPES(_KERNEL_IF, _TO_FLOAT)
+_FLOAT_TYPES(_KERNEL_FI, _TO_INT)
+_FLOAT_TYPES(_KERNEL_FF, _TO_FLOAT)
+
+#define _KERNEL_PTR(sn, st, dn, dt, dlo, dhi) _conv_##sn##_##dn,
+#define _KERNEL_ROW(K, sn, st, slo, shi) {_TO_INT(K, sn, st, slo, shi) _TO_FLOAT(K, sn, st, slo, shi)},
+
+/* rows are source types, columns are destination types, in the order of _type_index */
+static const _kernel_t _kernels[10][10] = {
+    _INT_TYPES(_KERNEL_PTR, _KERNEL_ROW)
+    _FLOAT_TYPES(_KERNEL_PTR, _KERNEL_ROW)
+};
+
+#define _CHECK_PTR(sn, st, dn, dt, dlo, dhi) _check_##sn##_##dn,
+
+static const _check_t _checks[10][10] = {
+    _INT_TYPES(_CHECK_PTR, _KERNEL_ROW)
+    _FLOAT_TYPES(_CHECK_PTR, _KERNEL_ROW)
+};
+
+/* true if every value of type `si` is exactly representable in type `di`,
+   where integers to floats count as exact (they may be rounded but are
+   always in range) */
+static int _is_widening(int si, int di)
+{
+    if (si < 8 && di >= 8)
+        return 1;
+    if (si >= 8 || di >= 8)
+        return si == 8 && di == 9;
+    const int ssigned = si < 4, dsigned = di < 4;
+    const int sk = si % 4, dk = di % 4;
+    if (ssigned == dsigned)
+        return dk >= sk;
+    return !ssigned && dk > sk;
+}
+
+/* position of the type in the kernel table */
+static int _type_index(type_t type, int64_t size, int *index)
+{
+    int k;
+    switch (size)
+    {
+    case 1:
+        k = 0;
+        break;
+    case 2:
+        k = 1;
+        break;
+    case 4:
+        k = 2;
+        break;
+    case 8:
+        k = 3;
+        break;
+    default:
+        return error(DE_ARG);
+    }
+    switch (type)
+    {
+    case type_signed:
+        *index = k;
+        return DE_SUCCESS;
+    case type_unsigned:
+        *index = 4 + k;
+        return DE_SUCCESS;
+    case type_float:
+        if (size < 4)
+            return error(DE_ARG);
+        *index = 8 + k - 2;
+        return DE_SUCCESS;
+    default:
+        return error(DE_BAD_ELTYPE);
+    }
+}
+
+int _convert_elements(type_t src_type, int64_t src_size, type_t dst_type, int64_t dst_size,
+                      int64_t n, const void *src, void *dst)
+{
+    int si = 0, di = 0;
+    TRACE_RUN(_type_index(src_type, src_size, &si));
+    TRACE_RUN(_type_index(dst_type, dst_size, &di));
+    if (n <= 0)
+        return DE_SUCCESS;
+    if (si == di)
+    {
+        memcpy(dst, src, n * src_size);
+        return DE_SUCCESS;
+    }
+    if (!_is_widening(si, di) && !_checks[si][di](n, src))
+        return error(DE_RANGE);
+    if (!_kernels[si][di](n, src, dst))
+        return error(DE_RANGE);
+    return DE_SUCCESS;
+}
+
+/*****************************************************************************************/
+/* byte order */
+
+const char *_host_byte_order(void)
+{
+    const uint16_t one = 1;
+    return (*(const uint8_t *)&one == 1) ? "little" : "big";
+}
+
+/* the compiler recognizes these as byte swap instructions and vectorizes the loops */
+static void _swap2(int64_t n, const uint16_t *src, uint16_t *dst)
+{
+    for (int64_t i = 0; i < n; ++i)
+    {
+        const uint16_t x = src[i];
+        dst[i] = (uint16_t)((x >> 8) | (x << 8));
+    }
+}
+
+static void _swap4(int64_t n, const uint32_t *src, uint32_t *dst)
+{
+    for (int64_t i = 0; i < n; ++i)
+    {
+        const uint32_t x = src[i];
+        dst[i] = (x >> 24) | ((x >> 8) & 0xff00u) | ((x << 8) & 0xff0000u) | (x << 24);
+    }
+}
+
+static void _swap8(int64_t n, const uint64_t *src, uint64_t *dst)
+{
+    for (int64_t i = 0; i < n; ++i)
+    {
+        uint64_t x = src[i];
+        x = ((x >> 8) & 0x00ff00ff00ff00ffull) | ((x & 0x00ff00ff00ff00ffull) << 8);
+        x = ((x >> 16) & 0x0000ffff0000ffffull) | ((x & 0x0000ffff0000ffffull) << 16);
+        dst[i] = (x >> 32) | (x << 32);
+    }
+}
+
+void _swap_elements(type_t eltype, int64_t elsize, int64_t nbytes, const void *src, void *dst)
+{
+    switch (eltype)
+    {
+    case type_signed:
+    case type_unsigned:
+    case type_date:
+    case type_float:
+        break;
+    case type_complex:
+        elsize /= 2;
+        break;
+    default:
+        elsize = 1;
+        break;
+    }
+    switch (elsize)
+    {
+    case 2:
+        _swap2(nbytes / 2, src, dst);
+        break;
+    case 4:
+        _swap4(nbytes / 4, src, dst);
+        break;
+    case 8:
+        _swap8(nbytes / 8, src, dst);
+        break;
+    default:
+        if (dst != src)
+            memcpy(dst, src, nbytes);
+        break;
+    }
+}
+
+int _swap_value(de_file de, type_t eltype, int64_t nelem, int64_t nbytes, const void **value)
+{
+    if (!de->swap || nelem <= 0 || nbytes <= 0 || *value == NULL)
+        return DE_SUCCESS;
+    void *buf = _get_scratch(de, nbytes);
+    if (buf == NULL)
+        return trace_error();
+    _swap_elements(eltype, nbytes / nelem, nbytes, *value, buf);
+    *value = buf;
+    return DE_SUCCESS;
+}
@@ -0,0 +1,46 @@
+#ifndef __CONVERT_H__
+#define __CONVERT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "file.h"
+#include "object.h"
+
+/* ========================================================================= */
+/* internal */
+
+/*
+    convert `n` numeric elements from type `src_type` of size `src_size` bytes
+    to type `dst_type` of size `dst_size` bytes.
+    NOTES:
+    * the types are type_signed, type_unsigned (sizes 1, 2, 4 or 8) and
+      type_float (sizes 4 or 8). Return DE_BAD_ELTYPE for other types and
+      DE_ARG for other sizes.
+    * floats are truncated towards zero when converted to integers.
+    * if any element can't be represented in the destination type we return
+      DE_RANGE and `dst` is not written. This includes NaN, i.e. missing
+      values, when converting from float to integer, and finite floats that
+      overflow float32. NaN stays NaN when converting between floats.
+    * `src` and `dst` must not overlap.
+*/
+int _convert_elements(type_t src_type, int64_t src_size, type_t dst_type, int64_t dst_size,
+                      int64_t n, const void *src, void *dst);
+
+/* "little" or "big", the byte order of the host. Files record the byte order
+   of the host that created them in the DE_BYTE_ORDER attribute of the root
+   catalog. */
+const char *_host_byte_order(void);
+
+/* reverse the bytes of each element of type `eltype` and size `elsize` in
+   the `nbytes` bytes at `src`, writing the result in `dst`. `src` and `dst`
+   may be the same. Complex numbers are swapped as pairs of floats. Elements
+   that are not numbers (e.g. strings) are copied unchanged. */
+void _swap_elements(type_t eltype, int64_t elsize, int64_t nbytes, const void *src, void *dst);
+
+/* if the byte order of the file is not that of the host, replace `*value`,
+   made of `nelem` elements, with a swapped copy in the scratch memory of the
+   de_file. Otherwise do nothing. */
+int _swap_value(de_file de, type_t eltype, int64_t nelem, int64_t nbytes, const void **value);
+
+#endif
@@ -0,0 +1,503 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <sqlite3.h>
+
+#include "error.h"
+#include "file.h"
+#include "object.h"
+#include "copy.h"
+#include "sql.h"
+#include "misc.h"
+
+/* the name under which the source file is attached to the destination */
+#define _SRC_SCHEMA "de_copy_src"
+
+/* values of the named parameters of the statements below */
+typedef struct
+{
+    obj_id_t src_id;
+    obj_id_t dst_pid;
+    const char *name;
+    int64_t base;
+    int64_t mode;
+    obj_id_t new_id; /* id of the copy of src_id */
+} copy_args_t;
+
+/*
+    The statements of the copy, run in this order. "{src}" stands for the
+    schema of the source (main, if it is the same file). Table `de_copy_roots`
+    lists the objects to copy, each with the catalog and the name of its copy.
+    The other temporary tables map the ids of objects, axes and shared values
+    in the source to their ids in the destination. New ids follow :base, the
+    largest id in use in the destination, in the order of the old ones, so
+    that repeated copies don't make ids grow faster than the number of rows.
+*/
+
+static const char *_sql_objects_map =
+    "WITH RECURSIVE `sub`(`id`, `root`, `depth`) AS ("
+    "   SELECT `old`, `old`, 0 FROM temp.`de_copy_roots`"
+    "   UNION ALL"
+    "   SELECT o.`id`, s.`root`, s.`depth` + 1 FROM {src}.`objects` AS o JOIN `sub` AS s ON o.`pid` = s.`id` WHERE o.`id` <> 0"
+    ") INSERT INTO temp.`de_copy_objects` (`old`, `new`, `root`, `depth`) SELECT `id`, :base + ROW_NUMBER() OVER (ORDER BY `id`), `root`, `depth` FROM `sub`;";
+
+static const char *_sql_objects =
+    "INSERT INTO main.`objects` (`id`, `pid`, `class`, `type`, `name`) "
+    "SELECT m.`new`, IIF(m.`depth` = 0, r.`pid`, p.`new`), o.`class`, o.`type`, IIF(m.`depth` = 0, r.`name`, o.`name`) "
+    "FROM temp.`de_copy_objects` AS m JOIN {src}.`objects` AS o ON o.`id` = m.`old` "
+    "JOIN temp.`de_copy_roots` AS r ON r.`old` = m.`root` LEFT JOIN temp.`de_copy_objects` AS p ON p.`old` = o.`pid` "
+    "ORDER BY m.`depth`;";
+
+static const char *_sql_objects_info =
+    "INSERT INTO main.`objects_info` (`id`, `created`, `depth`, `fullpath`) "
+    "SELECT m.`new`, unixepoch('now'), pi.`depth` + 1 + m.`depth`, "
+    "       format('%s/%s%s', pi.`fullpath`, r.`name`, substr(si.`fullpath`, length(ri.`fullpath`) + 1)) "
+    "FROM temp.`de_copy_objects` AS m JOIN {src}.`objects_info` AS si ON si.`id` = m.`old` "
+    "JOIN temp.`de_copy_roots` AS r ON r.`old` = m.`root` "
+    "JOIN {src}.`objects_info` AS ri ON ri.`id` = r.`old` JOIN main.`objects_info` AS pi ON pi.`id` = r.`pid`;";
+
+static const char *_sql_attributes =
+    "INSERT INTO main.`attributes` (`id`, `name`, `value`) "
+    "SELECT m.`new`, a.`name`, a.`value` FROM {src}.`attributes` AS a JOIN temp.`de_copy_objects` AS m ON a.`id` = m.`old`;";
+
+static const char *_sql_scalars =
+    "INSERT INTO main.`scalars` (`id`, `frequency`, `value`) "
+    "SELECT m.`new`, s.`frequency`, s.`value` FROM {src}.`scalars` AS s JOIN temp.`de_copy_objects` AS m ON s.`id` = m.`old`;";
+
+/* axes used by the copied objects, matched with equal axes in the destination */
+static const char *_sql_axes_map =
+    "INSERT INTO temp.`de_copy_axes` (`old`, `new`) "
+    "SELECT a.`id`, (SELECT d.`id` FROM main.`axes` AS d WHERE d.`ax_type` = a.`ax_type` AND d.`length` = a.`length` "
+    "                AND d.`frequency` = a.`frequency` AND d.`data` IS a.`data` ORDER BY d.`id` LIMIT 1) "
+    "FROM {src}.`axes` AS a WHERE a.`id` IN ("
+    "   SELECT t.`axis_id` FROM {src}.`tseries` AS t JOIN temp.`de_copy_objects` AS m ON t.`id` = m.`old`"
+    "   UNION SELECT t.`axis1_id` FROM {src}.`mvtseries` AS t JOIN temp.`de_copy_objects` AS m ON t.`id` = m.`old`"
+    "   UNION SELECT t.`axis2_id` FROM {src}.`mvtseries` AS t JOIN temp.`de_copy_objects` AS m ON t.`id` = m.`old`"
+    "   UNION SELECT n.`axis_id` FROM {src}.`ndaxes` AS n JOIN temp.`de_copy_objects` AS m ON n.`obj_id` = m.`old`"
+    "   UNION SELECT v.`axis_id` FROM {src}.`vintages` AS v JOIN temp.`de_copy_objects` AS m ON v.`obj_id` = m.`old`);";
+
+static const char *_sql_axes_base =
+    "SELECT MAX(IFNULL((SELECT `seq` FROM main.`sqlite_sequence` WHERE `name` = 'axes'), 0), "
+    "           IFNULL((SELECT MAX(`id`) FROM main.`axes`), 0));";
+
+/* the new ids of the axes without a match, all larger than :base */
+static const char *_sql_axes_new =
+    "UPDATE temp.`de_copy_axes` AS m SET `new` = :base + r.`rank` "
+    "FROM (SELECT `old`, ROW_NUMBER() OVER (ORDER BY `old`) AS `rank` FROM temp.`de_copy_axes` WHERE `new` IS NULL) AS r "
+    "WHERE m.`old` = r.`old`;";
+
+static const char *_sql_axes =
+    "INSERT INTO main.`axes` (`id`, `ax_type`, `length`, `frequency`, `data`, `first_day`, `last_day`) "
+    "SELECT m.`new`, a.`ax_type`, a.`length`, a.`frequency`, a.`data`, a.`first_day`, a.`last_day` "
+    "FROM temp.`de_copy_axes` AS m JOIN {src}.`axes` AS a ON a.`id` = m.`old` WHERE m.`new` > :base;";
+
+/* shared values of the copied objects, matched with equal ones in the destination */
+static const char *_sql_blobs_map =
+    "INSERT INTO temp.`de_copy_blobs` (`old`, `new`) "
+    "SELECT b.`id`, (SELECT d.`id` FROM main.`blobs` AS d WHERE d.`hash` = b.`hash` AND d.`value` = b.`value` LIMIT 1) "
+    "FROM {src}.`blobs` AS b WHERE b.`id` IN ("
+    "   SELECT t.`blob_id` FROM {src}.`tseries` AS t JOIN temp.`de_copy_objects` AS m ON t.`id` = m.`old`"
+    "   UNION SELECT t.`blob_id` FROM {src}.`mvtseries` AS t JOIN temp.`de_copy_objects` AS m ON t.`id` = m.`old`"
+    "   UNION SELECT t.`blob_id` FROM {src}.`ndtseries` AS t JOIN temp.`de_copy_objects` AS m ON t.`id` = m.`old`);";
+
+static const char *_sql_blobs_base =
+    "SELECT IFNULL((SELECT MAX(`id`) FROM main.`blobs`), 0);";
+
+static const char *_sql_blobs_new =
+    "UPDATE temp.`de_copy_blobs` AS m SET `new` = :base + r.`rank` "
+    "FROM (SELECT `old`, ROW_NUMBER() OVER (ORDER BY `old`) AS `rank` FROM temp.`de_copy_blobs` WHERE `new` IS NULL) AS r "
+    "WHERE m.`old` = r.`old`;";
+
+static const char *_sql_blobs =
+    "INSERT INTO main.`blobs` (`id`, `hash`, `refcount`, `value`) "
+    "SELECT m.`new`, b.`hash`, 0, b.`value` "
+    "FROM temp.`de_copy_blobs` AS m JOIN {src}.`blobs` AS b ON b.`id` = m.`old` WHERE m.`new` > :base;";
+
+static const char *_sql_tseries =
+    "INSERT INTO main.`tseries` (`id`, `eltype`, `elfreq`, `axis_id`, `value`, `blob_id`) "
+    "SELECT m.`new`, t.`eltype`, t.`elfreq`, a.`new`, t.`value`, b.`new` "
+    "FROM {src}.`tseries` AS t JOIN temp.`de_copy_objects` AS m ON t.`id` = m.`old` "
+    "JOIN temp.`de_copy_axes` AS a ON a.`old` = t.`axis_id` LEFT JOIN temp.`de_copy_blobs` AS b ON b.`old` = t.`blob_id`;";
+
+static const char *_sql_mvtseries =
+    "INSERT INTO main.`mvtseries` (`id`, `eltype`, `elfreq`, `axis1_id`, `axis2_id`, `value`, `order`, `blob_id`) "
+    "SELECT m.`new`, t.`eltype`, t.`elfreq`, a1.`new`, a2.`new`, t.`value`, t.`order`, b.`new` "
+    "FROM {src}.`mvtseries` AS t JOIN temp.`de_copy_objects` AS m ON t.`id` = m.`old` "
+    "JOIN temp.`de_copy_axes` AS a1 ON a1.`old` = t.`axis1_id` JOIN temp.`de_copy_axes` AS a2 ON a2.`old` = t.`axis2_id` "
+    "LEFT JOIN temp.`de_copy_blobs` AS b ON b.`old` = t.`blob_id`;";
+
+static const char *_sql_ndtseries =
+    "INSERT INTO main.`ndtseries` (`id`, `eltype`, `elfreq`, `value`, `blob_id`) "
+    "SELECT m.`new`, t.`eltype`, t.`elfreq`, t.`value`, b.`new` "
+    "FROM {src}.`ndtseries` AS t JOIN temp.`de_copy_objects` AS m ON t.`id` = m.`old` "
+    "LEFT JOIN temp.`de_copy_blobs` AS b ON b.`old` = t.`blob_id`;";
+
+static const char *_sql_ndaxes =
+    "INSERT INTO main.`ndaxes` (`obj_id`, `axis_index`, `axis_id`) "
+    "SELECT m.`new`, n.`axis_index`, a.`new` "
+    "FROM {src}.`ndaxes` AS n JOIN temp.`de_copy_objects` AS m ON n.`obj_id` = m.`old` "
+    "JOIN temp.`de_copy_axes` AS a ON a.`old` = n.`axis_id`;";
+
+static const char *_sql_chunk_layouts =
+    "INSERT INTO main.`chunk_layouts` (`id`, `elsize`, `ndims`, `chunk_shape`) "
+    "SELECT m.`new`, c.`elsize`, c.`ndims`, c.`chunk_shape` "
+    "FROM {src}.`chunk_layouts` AS c JOIN temp.`de_copy_objects` AS m ON c.`id` = m.`old`;";
+
+static const char *_sql_chunks =
+    "INSERT INTO main.`chunks` (`obj_id`, `chunk_index`, `value`) "
+    "SELECT m.`new`, c.`chunk_index`, c.`value` "
+    "FROM {src}.`chunks` AS c JOIN temp.`de_copy_objects` AS m ON c.`obj_id` = m.`old`;";
+
+static const char *_sql_vintages =
+    "INSERT INTO main.`vintages` (`obj_id`, `timestamp`, `axis_id`, `snapshot`, `value`) "
+    "SELECT m.`new`, v.`timestamp`, a.`new`, v.`snapshot`, v.`value` "
+    "FROM {src}.`vintages` AS v JOIN temp.`de_copy_objects` AS m ON v.`obj_id` = m.`old` "
+    "JOIN temp.`de_copy_axes` AS a ON a.`old` = v.`axis_id`;";
+
+/* prepare the statement made from `tmpl` with each "{src}" replaced by
+   `schema`, bind the parameters it uses and run it. If `result` is not
+   NULL, it receives the first column of the first row. */
+static int _run(de_file de, const char *schema, const char *tmpl, const copy_args_t *args, int64_t *result)
+{
+    static const char token[] = "{src}";
+    const size_t tlen = sizeof token - 1, slen = strlen(schema);
+    size_t count = 0;
+    for (const char *p = strstr(tmpl, token); p != NULL; p = strstr(p + tlen, token))
+        ++count;
+    char *sql = malloc(strlen(tmpl) + count * slen + 1);
+    if (sql == NULL)
+        return error(DE_ERR_ALLOC);
+    char *q = sql;
+    for (const char *p = tmpl, *t; *p != '\0'; p = t + tlen)
+    {
+        if (NULL == (t = strstr(p, token)))
+        {
+            strcpy(q, p);
+            q += strlen(p);
+            break;
+        }
+        memcpy(q, p, t - p);
+        q += t - p;
+        memcpy(q, schema, slen);
+        q += slen;
+    }
+    *q = '\0';
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(de->db, sql, -1, &stmt, NULL);
+    free(sql);
+    if (rc != SQLITE_OK)
+        return db_error(de);
+    int i;
+    rc = SQLITE_OK;
+    if (rc == SQLITE_OK && 0 < (i = sqlite3_bind_parameter_index(stmt, ":src_id")))
+        rc = sqlite3_bind_int64(stmt, i, args->src_id);
+    if (rc == SQLITE_OK && 0 < (i = sqlite3_bind_parameter_index(stmt, ":dst_pid")))
+        rc = sqlite3_bind_int64(stmt, i, args->dst_pid);
+    if (rc == SQLITE_OK && 0 < (i = sqlite3_bind_parameter_index(stmt, ":name")))
+        rc = sqlite3_bind_text(stmt, i, args->name, -1, SQLITE_STATIC);
+    if (rc == SQLITE_OK && 0 < (i = sqlite3_bind_parameter_index(stmt, ":base")))
+        rc = sqlite3_bind_int64(stmt, i, args->base);
+    if (rc == SQLITE_OK && 0 < (i = sqlite3_bind_parameter_index(stmt, ":mode")))
+        rc = sqlite3_bind_int64(stmt, i, args->mode);
+    if (rc == SQLITE_OK)
+    {
+        rc = sqlite3_step(stmt);
+        if (rc == SQLITE_ROW && result != NULL)
+            *result = sqlite3_column_int64(stmt, 0);
+        if (rc == SQLITE_ROW || rc == SQLITE_DONE)
+            rc = SQLITE_OK;
+    }
+    if (rc != SQLITE_OK)
+    {
+        rc = db_error(de);
+        sqlite3_finalize(stmt);
+        return rc;
+    }
+    sqlite3_finalize(stmt);
+    return DE_SUCCESS;
+}
+
+#define RUN_COPY(tmpl, result) TRACE_RUN(_run(dst, schema, (tmpl), args, (result)))
+
+/* run the statements of the copy in order */
+static int _copy(de_file dst, const char *schema, bool same_file, copy_args_t *args)
+{
+    int64_t base;
+    RUN_COPY("SELECT MAX(IFNULL((SELECT `seq` FROM main.`sqlite_sequence` WHERE `name` = 'objects'), 0), "
+             "           IFNULL((SELECT MAX(`id`) FROM main.`objects`), 0));",
+             &base);
+    args->base = base;
+    RUN_COPY(_sql_objects_map, NULL);
+    RUN_COPY("SELECT `new` FROM temp.`de_copy_objects` WHERE `old` = :src_id;", &args->new_id);
+    if (same_file)
+    {
+        int64_t inside = 0;
+        RUN_COPY("SELECT COUNT(*) FROM temp.`de_copy_roots` AS r JOIN temp.`de_copy_objects` AS m ON m.`old` = r.`pid`;",
+                 &inside);
+        if (inside)
+            return error1(DE_ARG, "cannot copy a catalog into itself");
+    }
+    RUN_COPY(_sql_objects, NULL);
+    RUN_COPY(_sql_objects_info, NULL);
+    RUN_COPY(_sql_attributes, NULL);
+    RUN_COPY(_sql_scalars, NULL);
+
+    RUN_COPY(_sql_axes_map, NULL);
+    RUN_COPY(_sql_axes_base, &base);
+    args->base = base;
+    RUN_COPY(_sql_axes_new, NULL);
+    RUN_COPY(_sql_axes, NULL);
+
+    RUN_COPY(_sql_blobs_map, NULL);
+    RUN_COPY(_sql_blobs_base, &base);
+    args->base = base;
+    RUN_COPY(_sql_blobs_new, NULL);
+    RUN_COPY(_sql_blobs, NULL);
+
+    RUN_COPY(_sql_tseries, NULL);
+    RUN_COPY(_sql_mvtseries, NULL);
+    RUN_COPY(_sql_ndtseries, NULL);
+    RUN_COPY(_sql_ndaxes, NULL);
+    RUN_COPY(_sql_chunk_layouts, NULL);
+    RUN_COPY(_sql_chunks, NULL);
+    RUN_COPY(_sql_vintages, NULL);
+    return DE_SUCCESS;
+}
+
+/* commit pending changes in both files and, if they are different, attach
+   the source to the destination. `schema` receives the schema name of the
+   source in statements run on the destination. */
+static int _attach(de_file src, de_file dst, const char **schema)
+{
+    if (src == dst)
+    {
+        *schema = "main";
+        TRACE_RUN(de_commit(dst));
+        _reset_stmts(dst);
+        return DE_SUCCESS;
+    }
+    *schema = _SRC_SCHEMA;
+    const char *fname = sqlite3_db_filename(src->db, "main");
+    if (fname == NULL || *fname == '\0')
+        return error1(DE_ARG, "the source must be a file on disk");
+    if (src->swap != dst->swap)
+        return error1(DE_ARG, "the files have different byte orders");
+
+    /* files can be attached only outside of transactions */
+    TRACE_RUN(de_commit(src));
+    TRACE_RUN(de_commit(dst));
+    _reset_stmts(dst);
+    TRACE_RUN(_run(dst, *schema, "ATTACH DATABASE :name AS " _SRC_SCHEMA ";",
+                   &(copy_args_t){0, 0, fname, 0, 0, 0}, NULL));
+    int64_t version = 0;
+    int rc = _run(dst, *schema, "PRAGMA {src}.user_version;", &(copy_args_t){0}, &version);
+    if (rc == DE_SUCCESS && version != DE_SCHEMA_VERSION)
+        rc = error1(DE_ARG, "the files have different versions");
+    if (rc != DE_SUCCESS)
+    {
+        sqlite3_exec(dst->db, "DETACH DATABASE " _SRC_SCHEMA ";", NULL, NULL, NULL);
+        return trace_error();
+    }
+    return DE_SUCCESS;
+}
+
+/* undo _attach. The result of the work done in between is in `rc` */
+static int _detach(de_file src, de_file dst, int rc)
+{
+    if (src != dst && SQLITE_OK != sqlite3_exec(dst->db, "DETACH DATABASE " _SRC_SCHEMA ";", NULL, NULL, NULL) &&
+        rc == DE_SUCCESS)
+        rc = db_error(dst);
+    return rc;
+}
+
+/* start the copy in a savepoint and create the temporary tables */
+static int _begin(de_file dst)
+{
+    if (SQLITE_OK != sqlite3_exec(dst->db,
+                                  "SAVEPOINT `de_copy`;"
+                                  "CREATE TEMP TABLE `de_copy_roots` (`old` INTEGER PRIMARY KEY, `pid` INTEGER NOT NULL, `name` TEXT NOT NULL);"
+                                  "CREATE TEMP TABLE `de_copy_objects` (`old` INTEGER PRIMARY KEY, `new` INTEGER NOT NULL, `root` INTEGER NOT NULL, `depth` INTEGER NOT NULL);"
+                                  "CREATE TEMP TABLE `de_copy_axes` (`old` INTEGER PRIMARY KEY, `new` INTEGER);"
+                                  "CREATE TEMP TABLE `de_copy_blobs` (`old` INTEGER PRIMARY KEY, `new` INTEGER);",
+                                  NULL, NULL, NULL))
+    {
+        int rc = db_error(dst);
+        sqlite3_exec(dst->db, "ROLLBACK TO `de_copy`; RELEASE `de_copy`;", NULL, NULL, NULL);
+        return rc;
+    }
+    return DE_SUCCESS;
+}
+
+/* finish the copy started by _begin, keeping the changes if `rc` is DE_SUCCESS */
+static int _end(de_file dst, int rc)
+{
+    if (rc == DE_SUCCESS)
+    {
+        if (SQLITE_OK != sqlite3_exec(dst->db,
+                                      "DROP TABLE temp.`de_copy_roots`;"
+                                      "DROP TABLE temp.`de_copy_objects`;"
+                                      "DROP TABLE temp.`de_copy_axes`;"
+                                      "DROP TABLE temp.`de_copy_blobs`;"
+                                      "DROP TABLE IF EXISTS temp.`de_merge`;"
+                                      "RELEASE `de_copy`;",
+                                      NULL, NULL, NULL))
+            rc = db_error(dst);
+    }
+    if (rc != DE_SUCCESS)
+    {
+        /* the temporary tables go away with the rest */
+        sqlite3_exec(dst->db, "ROLLBACK TO `de_copy`; RELEASE `de_copy`;", NULL, NULL, NULL);
+    }
+    return rc;
+}
+
+int de_copy_subtree(de_file src, obj_id_t src_id, de_file dst, obj_id_t dst_pid,
+                    const char *name, obj_id_t *id)
+{
+    if (src == NULL || dst == NULL || name == NULL)
+        return error(DE_NULL);
+    object_t object;
+    TRACE_RUN(sql_load_object(src, src_id, &object));
+    TRACE_RUN(sql_load_object(dst, dst_pid, &object));
+    if (object.obj_class != class_catalog)
+        return error1(DE_BAD_CLASS, _id2str(dst_pid));
+    if (!_check_name(name))
+        return trace_error();
+    int rc = sql_find_object(dst, dst_pid, name, NULL);
+    if (rc == DE_SUCCESS)
+        return error1(DE_EXISTS, name);
+    if (rc != DE_OBJ_DNE)
+        return trace_error();
+    de_clear_error();
+
+    const char *schema;
+    TRACE_RUN(_attach(src, dst, &schema));
+    copy_args_t args = {src_id, dst_pid, name, 0, 0, 0};
+    rc = _begin(dst);
+    if (rc == DE_SUCCESS)
+    {
+        rc = _run(dst, schema, "INSERT INTO temp.`de_copy_roots` (`old`, `pid`, `name`) VALUES (:src_id, :dst_pid, :name);",
+                  &args, NULL);
+        if (rc == DE_SUCCESS)
+            rc = _copy(dst, schema, src == dst, &args);
+        rc = _end(dst, rc);
+    }
+    if (_detach(src, dst, rc) != DE_SUCCESS)
+        return trace_error();
+    if (id != NULL)
+        *id = args.new_id;
+    return DE_SUCCESS;
+}
+
+/*
+    The statements of the merge. Table `de_merge` matches the objects of the
+    source with those at the same path in the destination. A catalog merges
+    with a catalog, and the objects to copy are those inside merged catalogs
+    that are not merged themselves; some of them (`root` and `match`) are in
+    conflict with an object in the destination.
+*/
+
+static const char *_sql_merge_paths =
+    "INSERT INTO temp.`de_merge` (`old`, `pid`, `class`, `name`, `match`, `match_class`) "
+    "SELECT o.`id`, o.`pid`, o.`class`, o.`name`, d.`id`, do.`class` "
+    "FROM {src}.`objects` AS o JOIN {src}.`objects_info` AS si ON si.`id` = o.`id` "
+    "LEFT JOIN main.`objects_info` AS d ON d.`fullpath` = si.`fullpath` "
+    "LEFT JOIN main.`objects` AS do ON do.`id` = d.`id` WHERE o.`id` <> 0;";
+
+#define _MERGED(x) "(" x ".`class` = 0 AND " x ".`match_class` IS 0)"
+
+static const char *_sql_merge_roots =
+    "UPDATE temp.`de_merge` AS c SET `root` = 1 WHERE NOT " _MERGED("c") " AND (c.`pid` = 0 OR EXISTS ("
+    "   SELECT 1 FROM temp.`de_merge` AS p WHERE p.`old` = c.`pid` AND " _MERGED("p") "));";
+
+static const char *_sql_merge_conflicts =
+    "SELECT COUNT(*) FROM temp.`de_merge` WHERE `root` AND `match` IS NOT NULL;";
+
+static const char *_sql_merge_delete =
+    "DELETE FROM main.`objects` WHERE `id` IN (SELECT `match` FROM temp.`de_merge` WHERE `root` AND `match` IS NOT NULL);";
+
+static const char *_sql_merge_copy_roots =
+    "INSERT INTO temp.`de_copy_roots` (`old`, `pid`, `name`) "
+    "SELECT c.`old`, IIF(c.`pid` = 0, 0, p.`match`), c.`name` "
+    "FROM temp.`de_merge` AS c LEFT JOIN temp.`de_merge` AS p ON p.`old` = c.`pid` "
+    "WHERE c.`root` AND (c.`match` IS NULL OR :mode <> 0);";
+
+/* the copies in conflict get the name of the original followed by "~" and
+   a number, :base, that goes up until their names are free in the
+   destination and among the other copies */
+#define _TAKEN(r) "(EXISTS (SELECT 1 FROM main.`objects` AS o WHERE o.`pid` = " r ".`pid` AND o.`name` = " r ".`name`) "   \
+                  " OR EXISTS (SELECT 1 FROM temp.`de_copy_roots` AS q JOIN temp.`de_merge` AS c ON c.`old` = q.`old` " \
+                  "            WHERE c.`match` IS NULL AND q.`pid` = " r ".`pid` AND q.`name` = " r ".`name` AND q.`old` <> " r ".`old`))"
+
+static const char *_sql_merge_taken =
+    "SELECT COUNT(*) FROM temp.`de_copy_roots` AS r WHERE " _TAKEN("r") ";";
+
+static const char *_sql_merge_rename =
+    "UPDATE temp.`de_copy_roots` AS r SET `name` = format('%s~%d', "
+    "   (SELECT c.`name` FROM temp.`de_merge` AS c WHERE c.`old` = r.`old`), :base) "
+    "WHERE " _TAKEN("r") ";";
+
+/* attributes of the source catalogs go to the catalogs they merge with,
+   replacing those with the same name if the mode is merge_overwrite */
+static const char *_sql_merge_attributes =
+    "INSERT OR IGNORE INTO main.`attributes` (`id`, `name`, `value`) "
+    "SELECT c.`match`, a.`name`, a.`value` FROM {src}.`attributes` AS a JOIN temp.`de_merge` AS c ON a.`id` = c.`old` "
+    "WHERE " _MERGED("c") ";";
+
+static const char *_sql_merge_attributes_replace =
+    "INSERT OR REPLACE INTO main.`attributes` (`id`, `name`, `value`) "
+    "SELECT c.`match`, a.`name`, a.`value` FROM {src}.`attributes` AS a JOIN temp.`de_merge` AS c ON a.`id` = c.`old` "
+    "WHERE " _MERGED("c") ";";
+
+static int _merge(de_file dst, const char *schema, copy_args_t *args, int64_t *nconflicts)
+{
+    RUN_COPY("CREATE TEMP TABLE `de_merge` (`old` INTEGER PRIMARY KEY, `pid` INTEGER NOT NULL, `class` INTEGER NOT NULL, "
+             "`name` TEXT NOT NULL, `match` INTEGER, `match_class` INTEGER, `root` INTEGER NOT NULL DEFAULT 0);",
+             NULL);
+    RUN_COPY(_sql_merge_paths, NULL);
+    RUN_COPY(_sql_merge_roots, NULL);
+    RUN_COPY(_sql_merge_conflicts, nconflicts);
+    if (args->mode == merge_overwrite)
+    {
+        RUN_COPY(_sql_merge_delete, NULL);
+    }
+    RUN_COPY(_sql_merge_copy_roots, NULL);
+    if (args->mode == merge_rename)
+    {
+        int64_t taken = *nconflicts;
+        for (args->base = 1; taken > 0; ++(args->base))
+        {
+            RUN_COPY(_sql_merge_rename, NULL);
+            RUN_COPY(_sql_merge_taken, &taken);
+        }
+    }
+    RUN_COPY(args->mode == merge_overwrite ? _sql_merge_attributes_replace : _sql_merge_attributes, NULL);
+    TRACE_RUN(_copy(dst, schema, false, args));
+    return DE_SUCCESS;
+}
+
+int de_merge(de_file src, de_file dst, merge_mode_t mode, int64_t *nconflicts)
+{
+    if (src == NULL || dst == NULL)
+        return error(DE_NULL);
+    if (src == dst)
+        return error1(DE_ARG, "cannot merge a file into itself");
+    if (mode != merge_skip && mode != merge_overwrite && mode != merge_rename)
+        return error1(DE_ARG, "unknown merge mode");
+
+    const char *schema;
+    TRACE_RUN(_attach(src, dst, &schema));
+    copy_args_t args = {0, 0, NULL, 0, mode, 0};
+    int64_t count = 0;
+    int rc = _begin(dst);
+    if (rc == DE_SUCCESS)
+        rc = _end(dst, _merge(dst, schema, &args, &count));
+    if (_detach(src, dst, rc) != DE_SUCCESS)
+        return trace_error();
+    if (nconflicts != NULL)
+        *nconflicts = count;
+    return DE_SUCCESS;
+}
@@ -0,0 +1,54 @@
+#ifndef __COPY_H__
+#define __COPY_H__
+
+#include "file.h"
+#include "object.h"
+
+/* ========================================================================= */
+/* API */
+
+/*
+    copy object `src_id` of file `src`, and everything under it if it is a
+    catalog, into catalog `dst_pid` of file `dst` under the given name.
+    NOTES:
+    * the copy is done by the database engine, table by table. Values are
+      copied as they are stored, without going through the memory of the
+      caller. Axes are matched with those already in `dst`, and shared values
+      (see de_set_dedup) with those in its store.
+    * `src` and `dst` may be the same file, but then `dst_pid` must not be
+      in the copied subtree (DE_ARG).
+    * pending changes in both files are committed first. If `src` and `dst`
+      are different, `src` must be a file on disk (not in memory) with the
+      same version and byte order as `dst`, otherwise we return DE_ARG.
+    * the new objects get new creation times. `id` (may be NULL) receives the
+      id of the copy of `src_id`.
+*/
+int de_copy_subtree(de_file src, obj_id_t src_id, de_file dst, obj_id_t dst_pid,
+                    const char *name, obj_id_t *id);
+
+/* what to do with an object of the source that is at the same path as one in
+   the destination, unless both are catalogs, which are merged */
+typedef enum
+{
+    merge_skip = 0,  /* keep the object in the destination */
+    merge_overwrite, /* replace the object in the destination */
+    merge_rename,    /* copy the object under a new name, e.g. "name~1" */
+} merge_mode_t;
+
+/*
+    merge everything in file `src` into file `dst`. Catalogs at the same path
+    in both files are merged and the other objects of `src` are copied as
+    with de_copy_subtree. `mode` settles conflicts, whose number `nconflicts`
+    (may be NULL) receives.
+    NOTES:
+    * the attributes of merged catalogs are added to those in `dst`. Those
+      with the same name are replaced only in mode merge_overwrite.
+    * attributes of the root catalog are not merged.
+    * the merge is one transaction: if it fails, `dst` is left unchanged.
+*/
+int de_merge(de_file src, de_file dst, merge_mode_t mode, int64_t *nconflicts);
+
+/* ========================================================================= */
+/* internal */
+
+#endif
@@ -384,3 +384,27 @@ int de_unpack_calendar_date(frequency_t freq, date_t date, int32_t *year, uint32
     }
     return DE_SUCCESS;
 }
+
+/*****************************************************************************************/
+/* days covered by a range of dates */
+
+bool _range_days(frequency_t freq, date_t first, int64_t length, date_t *first_day, date_t *last_day)
+{
+    const bool dated = _has_ppy(freq) || freq == freq_daily || freq == freq_bdaily ||
+                       (freq_weekly <= freq && freq <= freq_weekly_sun7);
+    if (!dated || length <= 0)
+        return false;
+    int32_t Y;
+    uint32_t M, D;
+    /* the day after the last day of the previous period */
+    if (DE_SUCCESS != de_unpack_calendar_date(freq, first - 1, &Y, &M, &D) ||
+        DE_SUCCESS != de_pack_calendar_date(freq_daily, Y, M, D, first_day) ||
+        DE_SUCCESS != de_unpack_calendar_date(freq, first + length - 1, &Y, &M, &D) ||
+        DE_SUCCESS != de_pack_calendar_date(freq_daily, Y, M, D, last_day))
+    {
+        de_clear_error();
+        return false;
+    }
+    *first_day += 1;
+    return true;
+}
@@ -99,4 +99,19 @@ int de_unpack_year_period_date(frequency_t freq, date_t date, int32_t *year, uin
 int de_pack_calendar_date(frequency_t freq, int32_t year, uint32_t month, uint32_t day, date_t *date);
 int de_unpack_calendar_date(frequency_t freq, date_t date, int32_t *year, uint32_t *month, uint32_t *day);
 
+/* ========================================================================= */
+/* internal */
+
+/* convert day number to business-day number */
+/* weekend, if not NULL, returns 0 - weekday, 1 - Saturday, 2 - Sunday */
+int32_t _rata_die_to_profesto(int32_t N_U, uint32_t *weekend);
+
+/* convert business-day number to day number */
+int32_t _rata_die_from_profesto(int32_t Nb_U);
+
+/* the first and the last day, as dates of frequency freq_daily, of the
+   `length` periods of frequency `freq` starting at `first`. Return false if
+   `freq` is not a frequency of dates or the range is empty. */
+bool _range_days(frequency_t freq, date_t first, int64_t length, date_t *first_day, date_t *last_day);
+
 #endif
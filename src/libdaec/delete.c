@@ -0,0 +1,155 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <sqlite3.h>
+
+#include "error.h"
+#include "file.h"
+#include "object.h"
+#include "delete.h"
+#include "sql.h"
+
+/*
+    The objects to delete are listed once in a temporary table. The rows
+    that refer to them are deleted from each table in one statement, then
+    the objects themselves, the deepest first, so that no row is left for
+    ON DELETE CASCADE to find. The object at the top goes last, which takes
+    the whole subtree out of the statistics of the catalogs above it (see
+    `catalog_stats` in file.c).
+*/
+
+static const char *_sql_objects =
+    "WITH RECURSIVE `sub`(`id`, `depth`) AS ("
+    "   SELECT ?1, 0"
+    "   UNION ALL"
+    "   SELECT o.`id`, s.`depth` + 1 FROM `objects` AS o JOIN `sub` AS s ON o.`pid` = s.`id` WHERE o.`id` <> 0"
+    ") INSERT INTO temp.`de_delete_objects` (`id`, `depth`) SELECT `id`, `depth` FROM `sub`;";
+
+/* tables with rows of the objects, by the name of the column with their id */
+static const char *_tables[][2] = {
+    {"attributes", "id"},
+    {"objects_info", "id"},
+    {"scalars", "id"},
+    {"tseries", "id"},
+    {"mvtseries", "id"},
+    {"ndaxes", "obj_id"},
+    {"ndtseries", "id"},
+    {"chunk_layouts", "id"},
+    {"chunks", "obj_id"},
+    {"vintages", "obj_id"},
+    {"catalog_stats", "id"},
+};
+
+#define _NTABLES ((int64_t)(sizeof _tables / sizeof _tables[0]))
+
+/* prepare `sql`, bind `a` and `b` to its parameters and run it. If `result`
+   is not NULL, it receives the first column of the first row. */
+static int _run(de_file de, const char *sql, int64_t a, int64_t b, int64_t *result)
+{
+    sqlite3_stmt *stmt;
+    if (SQLITE_OK != sqlite3_prepare_v2(de->db, sql, -1, &stmt, NULL))
+        return db_error(de);
+    int rc = SQLITE_OK;
+    if (sqlite3_bind_parameter_count(stmt) >= 1)
+        rc = sqlite3_bind_int64(stmt, 1, a);
+    if (rc == SQLITE_OK && sqlite3_bind_parameter_count(stmt) >= 2)
+        rc = sqlite3_bind_int64(stmt, 2, b);
+    if (rc == SQLITE_OK)
+    {
+        rc = sqlite3_step(stmt);
+        if (rc == SQLITE_ROW && result != NULL)
+            *result = sqlite3_column_int64(stmt, 0);
+        if (rc == SQLITE_ROW || rc == SQLITE_DONE)
+            rc = SQLITE_OK;
+    }
+    if (rc != SQLITE_OK)
+    {
+        rc = db_error(de);
+        sqlite3_finalize(stmt);
+        return rc;
+    }
+    sqlite3_finalize(stmt);
+    return DE_SUCCESS;
+}
+
+/* run the statements of the delete in order */
+static int _delete(de_file de, obj_id_t id, de_progress_t progress, int64_t *ndeleted)
+{
+    int64_t count, depth;
+    TRACE_RUN(_run(de, _sql_objects, id, 0, NULL));
+    TRACE_RUN(_run(de, "SELECT COUNT(*) FROM temp.`de_delete_objects`;", 0, 0, &count));
+    TRACE_RUN(_run(de, "SELECT MAX(`depth`) FROM temp.`de_delete_objects`;", 0, 0, &depth));
+    *ndeleted = count;
+
+    /* a step for each table, each level of the subtree and the top object */
+    const int64_t nsteps = _NTABLES + depth + 1;
+    int64_t step = 0;
+    for (int64_t i = 0; i < _NTABLES; ++i)
+    {
+        char sql[256];
+        snprintf(sql, sizeof sql,
+                 "DELETE FROM `%s` WHERE `%s` IN (SELECT `id` FROM temp.`de_delete_objects` WHERE `depth` > 0);",
+                 _tables[i][0], _tables[i][1]);
+        TRACE_RUN(_run(de, sql, 0, 0, NULL));
+        if (progress != NULL)
+            progress(++step, nsteps);
+    }
+    for (int64_t level = depth; level > 0; --level)
+    {
+        TRACE_RUN(_run(de, "DELETE FROM `objects` WHERE `id` IN "
+                           "(SELECT `id` FROM temp.`de_delete_objects` WHERE `depth` = ?1);",
+                       level, 0, NULL));
+        if (progress != NULL)
+            progress(++step, nsteps);
+    }
+    TRACE_RUN(sql_delete_object(de, id));
+    /* its own rows are gone with it, unless the foreign keys are off (see
+       de_bulk_begin) */
+    for (int64_t i = 0; i < _NTABLES; ++i)
+    {
+        char sql[256];
+        snprintf(sql, sizeof sql, "DELETE FROM `%s` WHERE `%s` = ?1;", _tables[i][0], _tables[i][1]);
+        TRACE_RUN(_run(de, sql, id, 0, NULL));
+    }
+    if (progress != NULL)
+        progress(++step, nsteps);
+    return DE_SUCCESS;
+}
+
+int de_delete_subtree(de_file de, obj_id_t id, de_progress_t progress, int64_t *ndeleted)
+{
+    if (de == NULL)
+        return error(DE_NULL);
+    if (id == 0)
+        return error(DE_DEL_ROOT);
+    object_t object;
+    TRACE_RUN(sql_load_object(de, id, &object));
+
+    if (SQLITE_OK != sqlite3_exec(de->db,
+                                  "SAVEPOINT `de_delete`;"
+                                  "CREATE TEMP TABLE `de_delete_objects` (`id` INTEGER PRIMARY KEY, `depth` INTEGER NOT NULL);",
+                                  NULL, NULL, NULL))
+    {
+        int rc = db_error(de);
+        sqlite3_exec(de->db, "ROLLBACK TO `de_delete`; RELEASE `de_delete`;", NULL, NULL, NULL);
+        return rc;
+    }
+    int64_t count = 0;
+    int rc = _delete(de, id, progress, &count);
+    /* tables can't be dropped while statements are in progress */
+    _reset_stmts(de);
+    if (rc == DE_SUCCESS &&
+        SQLITE_OK != sqlite3_exec(de->db, "DROP TABLE temp.`de_delete_objects`; RELEASE `de_delete`;", NULL, NULL, NULL))
+        rc = db_error(de);
+    if (rc != DE_SUCCESS)
+    {
+        /* the temporary table goes away with the rest */
+        sqlite3_exec(de->db, "ROLLBACK TO `de_delete`; RELEASE `de_delete`;", NULL, NULL, NULL);
+        return rc;
+    }
+    if (ndeleted != NULL)
+        *ndeleted = count;
+    return DE_SUCCESS;
+}
@@ -0,0 +1,29 @@
+#ifndef __DELETE_H__
+#define __DELETE_H__
+
+#include <stdint.h>
+
+#include "file.h"
+#include "object.h"
+#include "backup.h"
+
+/* ========================================================================= */
+/* API */
+
+/*
+    delete object `id` and everything under it if it is a catalog, as with
+    de_delete_object, but table by table rather than object by object, which
+    is much faster for large catalogs.
+    NOTES:
+    * `progress` (may be NULL) is called after each step with the number of
+      steps done so far and the number of steps.
+    * `ndeleted` (may be NULL) receives the number of objects deleted,
+      including `id` itself.
+    * the delete is one transaction: if it fails, nothing is deleted.
+*/
+int de_delete_subtree(de_file de, obj_id_t id, de_progress_t progress, int64_t *ndeleted);
+
+/* ========================================================================= */
+/* internal */
+
+#endif
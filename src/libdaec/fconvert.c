@@ -0,0 +1,373 @@
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "error.h"
+#include "file.h"
+#include "object.h"
+#include "dates.h"
+#include "axis.h"
+#include "tseries.h"
+#include "fconvert.h"
+
+/*
+    Frequency conversion is based on mapping each period of the higher
+    frequency to the period of the lower frequency that contains its last day.
+    The mapping is monotone, so each period of the lower frequency corresponds
+    to a contiguous range of periods of the higher frequency, which starts with
+    the period that contains the first day of the lower frequency period.
+*/
+
+/* approximate number of periods in a year, used to decide the direction of the conversion */
+static int _get_rank(frequency_t freq, int *rank)
+{
+    if (freq == freq_daily)
+        *rank = 365;
+    else if (freq == freq_bdaily)
+        *rank = 260;
+    else if (freq_weekly <= freq && freq <= freq_weekly_sun7)
+        *rank = 52;
+    else if ((freq & ~15) == freq_monthly && freq % 16 <= 12)
+        *rank = 12;
+    else if ((freq & ~15) == freq_quarterly && freq % 16 <= 12)
+        *rank = 4;
+    else if ((freq & ~15) == freq_halfyearly && freq % 16 <= 12)
+        *rank = 2;
+    else if ((freq & ~15) == freq_yearly && freq % 16 <= 12)
+        *rank = 1;
+    else
+        return error(DE_BAD_FREQ);
+    return DE_SUCCESS;
+}
+
+/* true if each period of the higher frequency `fh` lies within one period of
+   the lower frequency `fl`. Days lie within any longer period, except that
+   daily and business daily are not nested in each other. Weeks straddle
+   months. Months always nest; quarters and half-years do when the longer
+   periods end in a month where the shorter ones end (freq % 16 is the end
+   month, with 0 for December). */
+static bool _nested(frequency_t fh, int rank_h, frequency_t fl, int rank_l)
+{
+    if (rank_h >= 260)
+        return rank_l < 260;
+    if (rank_h == 52)
+        return false;
+    if (rank_h == 12)
+        return true;
+    return ((int)(fl % 16) - (int)(fh % 16)) % (12 / rank_h) == 0;
+}
+
+/* the period of the lower frequency `fl` that contains the last day of period `h` of frequency `fh` */
+static int _lower(frequency_t fh, date_t h, frequency_t fl, date_t *l)
+{
+    int32_t Y;
+    uint32_t M, D;
+    TRACE_RUN(de_unpack_calendar_date(fh, h, &Y, &M, &D));
+    TRACE_RUN(de_pack_calendar_date(fl, Y, M, D, l));
+    return DE_SUCCESS;
+}
+
+/* the first period of the higher frequency `fh` that belongs to period `l` of frequency `fl` */
+static int _first_higher(frequency_t fl, date_t l, frequency_t fh, date_t *h)
+{
+    int32_t Y;
+    uint32_t M, D;
+    date_t day;
+    /* the day after the last day of the previous period */
+    TRACE_RUN(de_unpack_calendar_date(fl, l - 1, &Y, &M, &D));
+    TRACE_RUN(de_pack_calendar_date(freq_daily, Y, M, D, &day));
+    while (1)
+    {
+        TRACE_RUN(de_unpack_calendar_date(freq_daily, ++day, &Y, &M, &D));
+        int rc = de_pack_calendar_date(fh, Y, M, D, h);
+        if (rc == DE_SUCCESS)
+            return DE_SUCCESS;
+        if (rc != DE_INEXACT)
+            return trace_error();
+        /* business daily and the day is on a weekend - try the next day */
+        de_clear_error();
+    }
+}
+
+/* check the frequencies and the method and return the direction of the conversion:
+   1 - aggregation, -1 - interpolation, 0 - same frequency */
+static int _get_direction(frequency_t freq, frequency_t to_freq, fconv_method_t method, int *dir)
+{
+    int rank = 0, to_rank = 0;
+    TRACE_RUN(_get_rank(freq, &rank));
+    TRACE_RUN(_get_rank(to_freq, &to_rank));
+    if (freq == to_freq)
+        *dir = 0;
+    else if (rank == to_rank)
+        return error(DE_BAD_FREQ);
+    else if (rank > to_rank ? !_nested(freq, rank, to_freq, to_rank) : !_nested(to_freq, to_rank, freq, rank))
+        return error1(DE_BAD_FREQ, "periods don't nest");
+    else
+        *dir = (rank > to_rank) ? 1 : -1;
+    switch (method)
+    {
+    case fconv_mean:
+    case fconv_sum:
+    case fconv_first:
+    case fconv_last:
+    case fconv_eop:
+        if (*dir < 0)
+            return error(DE_ARG);
+        return DE_SUCCESS;
+    case fconv_const:
+    case fconv_even:
+    case fconv_linear:
+        if (*dir > 0)
+            return error(DE_ARG);
+        return DE_SUCCESS;
+    default:
+        return error(DE_ARG);
+    }
+}
+
+static int _fconvert_range(frequency_t freq, date_t first, int64_t length, frequency_t to_freq,
+                           int dir, date_t *to_first, int64_t *to_length)
+{
+    if (length < 0)
+        return error(DE_RANGE);
+    if (dir == 0)
+    {
+        *to_first = first;
+        *to_length = length;
+        return DE_SUCCESS;
+    }
+    if (dir < 0)
+    {
+        /* interpolation - all sub-periods of the given periods */
+        date_t end;
+        TRACE_RUN(_first_higher(freq, first, to_freq, to_first));
+        TRACE_RUN(_first_higher(freq, first + length, to_freq, &end));
+        *to_length = end - *to_first;
+        return DE_SUCCESS;
+    }
+    /* aggregation - only periods whose sub-periods are all in the range */
+    date_t l0, l1, h;
+    TRACE_RUN(_lower(freq, first, to_freq, &l0));
+    TRACE_RUN(_first_higher(to_freq, l0, freq, &h));
+    if (h < first)
+        ++l0;
+    *to_first = l0;
+    if (length == 0)
+    {
+        *to_length = 0;
+        return DE_SUCCESS;
+    }
+    TRACE_RUN(_lower(freq, first + length - 1, to_freq, &l1));
+    TRACE_RUN(_first_higher(to_freq, l1 + 1, freq, &h));
+    if (h > first + length)
+        --l1;
+    *to_length = (l1 < l0) ? 0 : l1 - l0 + 1;
+    return DE_SUCCESS;
+}
+
+int de_fconvert_range(frequency_t freq, date_t first, int64_t length,
+                      frequency_t to_freq, fconv_method_t method,
+                      date_t *to_first, int64_t *to_length)
+{
+    if (to_first == NULL || to_length == NULL)
+        return error(DE_NULL);
+    int dir = 0;
+    TRACE_RUN(_get_direction(freq, to_freq, method, &dir));
+    TRACE_RUN(_fconvert_range(freq, first, length, to_freq, dir, to_first, to_length));
+    return DE_SUCCESS;
+}
+
+/*****************************************************************************************/
+/* reading elements as double */
+
+typedef double (*_getter_t)(const void *value, int64_t i);
+
+static double _get_f8(const void *value, int64_t i) { return ((const double *)value)[i]; }
+static double _get_f4(const void *value, int64_t i) { return ((const float *)value)[i]; }
+static double _get_i8(const void *value, int64_t i) { return ((const int64_t *)value)[i]; }
+static double _get_i4(const void *value, int64_t i) { return ((const int32_t *)value)[i]; }
+static double _get_i2(const void *value, int64_t i) { return ((const int16_t *)value)[i]; }
+static double _get_i1(const void *value, int64_t i) { return ((const int8_t *)value)[i]; }
+static double _get_u8(const void *value, int64_t i) { return ((const uint64_t *)value)[i]; }
+static double _get_u4(const void *value, int64_t i) { return ((const uint32_t *)value)[i]; }
+static double _get_u2(const void *value, int64_t i) { return ((const uint16_t *)value)[i]; }
+static double _get_u1(const void *value, int64_t i) { return ((const uint8_t *)value)[i]; }
+
+static _getter_t _get_getter(type_t eltype, int64_t elsize)
+{
+    if (elsize <= 0 || elsize > 8)
+        return NULL;
+    switch (eltype * 16 + elsize)
+    {
+    case type_float * 16 + 8:
+        return _get_f8;
+    case type_float * 16 + 4:
+        return _get_f4;
+    case type_signed * 16 + 8:
+        return _get_i8;
+    case type_signed * 16 + 4:
+        return _get_i4;
+    case type_signed * 16 + 2:
+        return _get_i2;
+    case type_signed * 16 + 1:
+        return _get_i1;
+    case type_unsigned * 16 + 8:
+        return _get_u8;
+    case type_unsigned * 16 + 4:
+        return _get_u4;
+    case type_unsigned * 16 + 2:
+        return _get_u2;
+    case type_unsigned * 16 + 1:
+        return _get_u1;
+    default:
+        return NULL;
+    }
+}
+
+/*****************************************************************************************/
+/* aggregation and interpolation */
+
+static double _aggregate(_getter_t get, const void *value, int64_t begin, int64_t end, fconv_method_t method)
+{
+    double acc = 0;
+    switch (method)
+    {
+    case fconv_mean:
+    case fconv_sum:
+        for (int64_t i = begin; i < end; ++i)
+            acc += get(value, i);
+        return method == fconv_sum ? acc : acc / (end - begin);
+    case fconv_first:
+        for (int64_t i = begin; i < end; ++i)
+            if (!isnan(acc = get(value, i)))
+                return acc;
+        return NAN;
+    case fconv_last:
+        for (int64_t i = end - 1; i >= begin; --i)
+            if (!isnan(acc = get(value, i)))
+                return acc;
+        return NAN;
+    case fconv_eop:
+        return get(value, end - 1);
+    default:
+        return NAN;
+    }
+}
+
+static int _fconvert_values(frequency_t freq, date_t first, int64_t length,
+                            _getter_t get, const void *value,
+                            frequency_t to_freq, fconv_method_t method, int dir,
+                            date_t to_first, int64_t to_length, double *to_value)
+{
+    if (dir == 0)
+    {
+        for (int64_t i = 0; i < length; ++i)
+            to_value[i] = get(value, i);
+        return DE_SUCCESS;
+    }
+    if (dir > 0)
+    {
+        date_t begin, end;
+        TRACE_RUN(_first_higher(to_freq, to_first, freq, &begin));
+        for (int64_t k = 0; k < to_length; ++k, begin = end)
+        {
+            TRACE_RUN(_first_higher(to_freq, to_first + k + 1, freq, &end));
+            to_value[k] = _aggregate(get, value, begin - first, end - first, method);
+        }
+        return DE_SUCCESS;
+    }
+    /* interpolation: sub-periods of period k are to_value[begin:end-1] */
+    int64_t begin = 0, end = 0;
+    date_t next;
+    double slope = 0;
+    for (int64_t k = 0; k < length; ++k, begin = end)
+    {
+        TRACE_RUN(_first_higher(freq, first + k + 1, to_freq, &next));
+        end = next - to_first;
+        const double v = get(value, k);
+        switch (method)
+        {
+        case fconv_const:
+            for (int64_t i = begin; i < end; ++i)
+                to_value[i] = v;
+            break;
+        case fconv_even:
+            for (int64_t i = begin; i < end; ++i)
+                to_value[i] = v / (end - begin);
+            break;
+        case fconv_linear:
+            /* the end of period k is where the value is known exactly; we
+            fill the sub-periods between the previous end and this one */
+            if (k == 0)
+            {
+                to_value[end - 1] = v;
+                break;
+            }
+            {
+                const int64_t prev = begin - 1;
+                slope = (v - to_value[prev]) / (end - 1 - prev);
+                for (int64_t i = begin; i < end; ++i)
+                    to_value[i] = to_value[prev] + slope * (i - prev);
+            }
+            if (k == 1)
+            {
+                /* extrapolate backwards the sub-periods of the first period */
+                for (int64_t i = begin - 2; i >= 0; --i)
+                    to_value[i] = to_value[begin - 1] - slope * (begin - 1 - i);
+            }
+            break;
+        default:
+            return error(DE_ARG);
+        }
+    }
+    if (method == fconv_linear && length == 1)
+    {
+        /* a single value - nothing to interpolate, so it's constant */
+        for (int64_t i = 0; i < end - 1; ++i)
+            to_value[i] = to_value[end - 1];
+    }
+    return DE_SUCCESS;
+}
+
+int de_fconvert_tseries(const tseries_t *tseries, frequency_t to_freq, fconv_method_t method,
+                        date_t *to_first, int64_t *to_length, double *value)
+{
+    if (tseries == NULL || to_first == NULL || to_length == NULL)
+        return error(DE_NULL);
+    const axis_t *axis = &tseries->axis;
+    if (axis->ax_type != axis_range)
+        return error(DE_BAD_AXIS_TYPE);
+    int dir = 0;
+    TRACE_RUN(_get_direction(axis->frequency, to_freq, method, &dir));
+    int64_t capacity = *to_length;
+    TRACE_RUN(_fconvert_range(axis->frequency, axis->first, axis->length, to_freq, dir, to_first, to_length));
+    if (capacity < 0)
+        return DE_SUCCESS;
+    if (capacity < *to_length)
+        return error(DE_SHORT_BUF);
+    if (axis->length == 0 || *to_length == 0)
+        return DE_SUCCESS;
+    if (value == NULL || tseries->value == NULL)
+        return error(DE_NULL);
+    if (tseries->nbytes % axis->length != 0)
+        return error(DE_BAD_OBJ);
+    _getter_t get = _get_getter(tseries->eltype, tseries->nbytes / axis->length);
+    if (get == NULL)
+        return error(DE_BAD_ELTYPE);
+    TRACE_RUN(_fconvert_values(axis->frequency, axis->first, axis->length, get, tseries->value,
+                               to_freq, method, dir, *to_first, *to_length, value));
+    return DE_SUCCESS;
+}
+
+int de_load_tseries_fconvert(de_file de, obj_id_t id, frequency_t to_freq, fconv_method_t method,
+                             date_t *to_first, int64_t *to_length, double *value)
+{
+    if (de == NULL)
+        return error(DE_NULL);
+    tseries_t tseries;
+    TRACE_RUN(de_load_tseries(de, id, &tseries));
+    TRACE_RUN(de_fconvert_tseries(&tseries, to_freq, method, to_first, to_length, value));
+    return DE_SUCCESS;
+}
@@ -0,0 +1,58 @@
+#ifndef __FCONVERT_H__
+#define __FCONVERT_H__
+
+#include "file.h"
+#include "object.h"
+#include "dates.h"
+#include "tseries.h"
+
+/* ========================================================================= */
+/* API */
+
+typedef enum
+{
+    /* from higher to lower frequency (aggregation) */
+    fconv_mean = 0, /* average of the values in each period */
+    fconv_sum,      /* sum of the values in each period */
+    fconv_first,    /* first non-missing value in each period */
+    fconv_last,     /* last non-missing value in each period */
+    fconv_eop,      /* value in the last sub-period, i.e. end of period */
+    /* from lower to higher frequency (interpolation) */
+    fconv_const,  /* repeat the value in each sub-period */
+    fconv_even,   /* divide the value evenly among the sub-periods */
+    fconv_linear, /* linear interpolation between end-of-period values */
+} fconv_method_t;
+
+/* compute the range of dates that results from converting the range
+   `first:first+length-1` of frequency `freq` to frequency `to_freq`. When
+   aggregating, only periods fully covered by the given range are included. */
+int de_fconvert_range(frequency_t freq, date_t first, int64_t length,
+                      frequency_t to_freq, fconv_method_t method,
+                      date_t *to_first, int64_t *to_length);
+
+/*
+    convert the values of a tseries to a different frequency.
+    NOTES:
+    * the tseries must have a range axis and numeric elements (signed,
+      unsigned or float). The result is always written as double.
+    * each period of the higher frequency must lie within one period of the
+      lower frequency, otherwise we return DE_BAD_FREQ. E.g. weeks don't nest
+      in months, nor quarters ending in January in years ending in December.
+    * missing values are NaN; they propagate into mean and sum and are skipped
+      by first and last.
+    * on entry `*to_length` must contain the number of doubles available in
+      `value`. If it is negative, `value` is not accessed and only the range of
+      the result is calculated. If it is too small, the required length is
+      written in `*to_length` and we return DE_SHORT_BUF.
+*/
+int de_fconvert_tseries(const tseries_t *tseries, frequency_t to_freq, fconv_method_t method,
+                        date_t *to_first, int64_t *to_length, double *value);
+
+/* same as de_fconvert_tseries, but the tseries is loaded from the file by its id */
+int de_load_tseries_fconvert(de_file de, obj_id_t id, frequency_t to_freq, fconv_method_t method,
+                             date_t *to_first, int64_t *to_length, double *value);
+
+/* ========================================================================= */
+/* internal */
+
+#endif
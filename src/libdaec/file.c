@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <sqlite3.h>
 
@@ -9,6 +10,10 @@
 #include "file.h"
 #include "sql.h"
 #include "misc.h"
+#include "convert.h"
+#include "axis.h"
+#include "dates.h"
+#include "bulk.h"
 
 /* https://www.cprogramming.com/tutorial/unicode.html */
 
@@ -119,6 +124,586 @@ int _init_file(de_file de)
             "       VALUES (0, 'DE_VERSION', '" DE_VERSION "');"
             "");
 
+    TRACE_RUN(_upgrade_file(de));
+    TRACE_RUN(sql_set_attribute(de, 0, "DE_BYTE_ORDER", _host_byte_order()));
+    de->swap = false;
+    return DE_SUCCESS;
+}
+
+/* compare the byte order of the file with that of the host */
+static int _init_byte_order(de_file de)
+{
+    const char *order;
+    int rc = sql_get_attribute(de, 0, "DE_BYTE_ORDER", &order);
+    if (rc == DE_MIS_ATTR)
+    {
+        /* a file made by an earlier version, whose byte order we don't know
+           until the caller tells us (see de_set_byte_order) */
+        de_clear_error();
+        de->swap = false;
+        return DE_SUCCESS;
+    }
+    if (rc != DE_SUCCESS)
+        return trace_error();
+    de->swap = strcmp(order, _host_byte_order()) != 0;
+    return DE_SUCCESS;
+}
+
+/* a column referring to the shared value of a row in the given table, with
+   triggers that keep count of the references to each blob and delete the
+   blobs that are no longer referenced */
+#define _BLOB_REFS(tbl)                                                                             \
+    "ALTER TABLE `" tbl "` ADD COLUMN `blob_id` INTEGER REFERENCES `blobs` (`id`);"                 \
+    "CREATE TRIGGER `" tbl "_ref` AFTER INSERT ON `" tbl "` WHEN NEW.`blob_id` IS NOT NULL BEGIN"   \
+    "   UPDATE `blobs` SET `refcount` = `refcount` + 1 WHERE `id` = NEW.`blob_id`;"                 \
+    "END;"                                                                                          \
+    "CREATE TRIGGER `" tbl "_unref` AFTER DELETE ON `" tbl "` WHEN OLD.`blob_id` IS NOT NULL BEGIN" \
+    "   UPDATE `blobs` SET `refcount` = `refcount` - 1 WHERE `id` = OLD.`blob_id`;"                 \
+    "   DELETE FROM `blobs` WHERE `id` = OLD.`blob_id` AND `refcount` <= 0;"                        \
+    "END;"                                                                                          \
+    "CREATE TRIGGER `" tbl "_reref` AFTER UPDATE OF `blob_id` ON `" tbl "`"                         \
+    "   WHEN OLD.`blob_id` IS NOT NEW.`blob_id` BEGIN"                                              \
+    "   UPDATE `blobs` SET `refcount` = `refcount` + 1 WHERE `id` = NEW.`blob_id`;"                 \
+    "   UPDATE `blobs` SET `refcount` = `refcount` - 1 WHERE `id` = OLD.`blob_id`;"                 \
+    "   DELETE FROM `blobs` WHERE `id` = OLD.`blob_id` AND `refcount` <= 0;"                        \
+    "END;"
+
+/* the catalogs above object `id`, from its parent up to the root */
+#define _ANCESTORS(id)                                                                           \
+    "(WITH RECURSIVE `anc`(`id`) AS ("                                                           \
+    "   SELECT `pid` FROM `objects` WHERE `id` = " id " AND `id` <> 0"                           \
+    "   UNION ALL"                                                                               \
+    "   SELECT o.`pid` FROM `objects` AS o JOIN `anc` AS a ON o.`id` = a.`id` WHERE a.`id` <> 0" \
+    ") SELECT `id` FROM `anc`)"
+
+/* the catalog of object `id` */
+#define _PARENT(id) "(SELECT `pid` FROM `objects` WHERE `id` = " id ")"
+
+/* size of the value in a new or old row of a table with shared values */
+#define _ROW_BYTES(row) \
+    "IFNULL(LENGTH(" row ".`value`), IFNULL((SELECT LENGTH(`value`) FROM `blobs` WHERE `id` = " row ".`blob_id`), 0))"
+
+/*
+    When they are on (see de_set_catalog_stats), table `catalog_stats` keeps,
+    for each catalog, the number of objects under it, the total size of their
+    values and the days covered by their date axes. Triggers on the other
+    tables update the catalog of the changed object and a trigger on
+    `catalog_stats` passes the changes on to the catalog above it, which
+    needs PRAGMA recursive_triggers. The coverage only grows on its own; when
+    an object that may have been at its edge is deleted the coverage is
+    marked `stale` and recomputed when it is asked for (see
+    de_catalog_stats). When they are off, the table is empty and none of the
+    triggers exist, so writes don't pay for them.
+*/
+
+/* the size of the values and the days covered by the axes of each object */
+#define _VALUE_VIEWS(temp)                                                                                      \
+    "CREATE " temp "VIEW `value_bytes` (`id`, `nbytes`) AS"                                                     \
+    "   SELECT `id`, LENGTH(`value`) FROM `scalars`"                                                            \
+    "   UNION ALL SELECT t.`id`, IFNULL(LENGTH(t.`value`), LENGTH(b.`value`))"                                  \
+    "             FROM `tseries` AS t LEFT JOIN `blobs` AS b ON t.`blob_id` = b.`id`"                           \
+    "   UNION ALL SELECT t.`id`, IFNULL(LENGTH(t.`value`), LENGTH(b.`value`))"                                  \
+    "             FROM `mvtseries` AS t LEFT JOIN `blobs` AS b ON t.`blob_id` = b.`id`"                         \
+    "   UNION ALL SELECT t.`id`, IFNULL(LENGTH(t.`value`), LENGTH(b.`value`))"                                  \
+    "             FROM `ndtseries` AS t LEFT JOIN `blobs` AS b ON t.`blob_id` = b.`id`"                         \
+    "   UNION ALL SELECT `obj_id`, LENGTH(`value`) FROM `chunks`;"                                              \
+    "CREATE " temp "VIEW `value_days` (`id`, `first_day`, `last_day`) AS"                                       \
+    "   SELECT t.`id`, a.`first_day`, a.`last_day` FROM `tseries` AS t JOIN `axes` AS a ON t.`axis_id` = a.`id`" \
+    "   UNION ALL SELECT t.`id`, a.`first_day`, a.`last_day`"                                                   \
+    "             FROM `mvtseries` AS t JOIN `axes` AS a ON a.`id` IN (t.`axis1_id`, t.`axis2_id`)"             \
+    "   UNION ALL SELECT n.`obj_id`, a.`first_day`, a.`last_day`"                                               \
+    "             FROM `ndaxes` AS n JOIN `axes` AS a ON n.`axis_id` = a.`id`;"
+
+/* the table of the statistics, empty while they are off */
+#define _CATALOG_STATS                                                    \
+    "CREATE TABLE `catalog_stats` ("                                      \
+    "   `id` INTEGER PRIMARY KEY,"                                        \
+    "   `count` INTEGER NOT NULL DEFAULT 0,"                              \
+    "   `nbytes` INTEGER NOT NULL DEFAULT 0,"                             \
+    "   `first_day` INTEGER,"                                             \
+    "   `last_day` INTEGER,"                                              \
+    "   `stale` INTEGER NOT NULL DEFAULT 0,"                              \
+    "   FOREIGN KEY (`id`) REFERENCES `objects` (`id`) ON DELETE CASCADE" \
+    ") STRICT;"
+
+/* the statistics of the objects already in the file */
+#define _CATALOG_STATS_FILL                                                                               \
+    "WITH RECURSIVE `sub`(`cat`, `id`) AS ("                                                              \
+    "   SELECT `id`, `id` FROM `objects` WHERE `class` = 0"                                               \
+    "   UNION ALL"                                                                                        \
+    "   SELECT s.`cat`, o.`id` FROM `objects` AS o JOIN `sub` AS s ON o.`pid` = s.`id` WHERE o.`id` <> 0" \
+    ") INSERT INTO `catalog_stats` (`id`, `count`, `nbytes`, `first_day`, `last_day`)"                    \
+    "   SELECT `cat`, COUNT(*) - 1,"                                                                      \
+    "          IFNULL(SUM((SELECT SUM(`nbytes`) FROM `value_bytes` AS v WHERE v.`id` = s.`id`)), 0),"     \
+    "          MIN((SELECT MIN(`first_day`) FROM `value_days` AS d WHERE d.`id` = s.`id`)),"              \
+    "          MAX((SELECT MAX(`last_day`) FROM `value_days` AS d WHERE d.`id` = s.`id`))"                \
+    "   FROM `sub` AS s GROUP BY `cat`;"
+
+/* changes to the statistics of a catalog go on to the catalog above it */
+#define _CATALOG_STATS_UP                                                                                  \
+    "CREATE TRIGGER `catalog_stats_up` AFTER UPDATE ON `catalog_stats` WHEN NEW.`id` <> 0"                 \
+    "   AND (NEW.`count` <> OLD.`count` OR NEW.`nbytes` <> OLD.`nbytes`"                                   \
+    "        OR NEW.`first_day` IS NOT OLD.`first_day` OR NEW.`last_day` IS NOT OLD.`last_day`) BEGIN"      \
+    "   UPDATE `catalog_stats` SET `count` = `count` + NEW.`count` - OLD.`count`,"                         \
+    "          `nbytes` = `nbytes` + NEW.`nbytes` - OLD.`nbytes`,"                                         \
+    "          `first_day` = MIN(IFNULL(`first_day`, NEW.`first_day`), IFNULL(NEW.`first_day`, `first_day`))," \
+    "          `last_day` = MAX(IFNULL(`last_day`, NEW.`last_day`), IFNULL(NEW.`last_day`, `last_day`))"   \
+    "   WHERE `id` = " _PARENT("NEW.`id`") ";"                                                             \
+    "END;"
+
+/* new objects count in their catalog, and new catalogs get their statistics */
+#define _OBJECTS_STATS                                                                  \
+    "CREATE TRIGGER `objects_stats` AFTER INSERT ON `objects` WHEN NEW.`id` <> 0 BEGIN" \
+    "   INSERT INTO `catalog_stats` (`id`) SELECT NEW.`id` WHERE NEW.`class` = 0;"      \
+    "   UPDATE `catalog_stats` SET `count` = `count` + 1 WHERE `id` = NEW.`pid`;"       \
+    "END;"
+
+/* take object OLD.`id`, its value and, if it is a catalog, everything under
+   it out of the statistics of its catalog */
+#define _TAKE_OUT                                                                                               \
+    "   UPDATE `catalog_stats` SET `stale` = 1"                                                                 \
+    "   FROM (SELECT MIN(`first_day`) AS `f`, MAX(`last_day`) AS `l`"                                           \
+    "         FROM (SELECT `first_day`, `last_day` FROM `value_days` WHERE `id` = OLD.`id`"                     \
+    "               UNION ALL SELECT `first_day`, `last_day` FROM `catalog_stats` WHERE `id` = OLD.`id`)) AS o" \
+    "   WHERE o.`f` IS NOT NULL AND `catalog_stats`.`id` IN " _ANCESTORS("OLD.`id`")                            \
+    "         AND (o.`f` <= `first_day` OR o.`l` >= `last_day`);"                                               \
+    "   UPDATE `catalog_stats` SET"                                                                             \
+    "          `count` = `count` - 1 - IFNULL((SELECT `count` FROM `catalog_stats` WHERE `id` = OLD.`id`), 0),"  \
+    "          `nbytes` = `nbytes` - IFNULL((SELECT `nbytes` FROM `catalog_stats` WHERE `id` = OLD.`id`), 0)"   \
+    "                     - (SELECT IFNULL(SUM(`nbytes`), 0) FROM `value_bytes` WHERE `id` = OLD.`id`)"         \
+    "   WHERE `id` = OLD.`pid`;"
+
+/* a deleted object takes itself out. The objects under it are deleted after
+   it, when its catalog is gone, and have nothing more to take away. The same
+   goes for objects whose catalog has lost its statistics (see
+   de_delete_subtree). */
+#define _OBJECTS_UNSTATS                                                                        \
+    "CREATE TRIGGER `objects_unstats` BEFORE DELETE ON `objects`"                               \
+    "   WHEN EXISTS (SELECT 1 FROM `objects` AS p JOIN `catalog_stats` AS s ON s.`id` = p.`id`" \
+    "                WHERE p.`id` = OLD.`pid`) BEGIN" _TAKE_OUT                                 \
+    "END;"
+
+/* a moved object takes itself out of its old catalog and puts itself, with
+   everything under it, in the new one. A stale coverage stays stale. */
+#define _OBJECTS_MOVE_OUT                                                                       \
+    "CREATE TRIGGER `objects_move_out` BEFORE UPDATE OF `pid` ON `objects`"                     \
+    "   WHEN OLD.`pid` <> NEW.`pid` BEGIN" _TAKE_OUT                                            \
+    "END;"
+#define _OBJECTS_MOVE_IN                                                                                        \
+    "CREATE TRIGGER `objects_move_in` AFTER UPDATE OF `pid` ON `objects`"                                       \
+    "   WHEN OLD.`pid` <> NEW.`pid` BEGIN"                                                                      \
+    "   UPDATE `catalog_stats` SET `stale` = 1"                                                                 \
+    "   WHERE EXISTS (SELECT 1 FROM `catalog_stats` WHERE `id` = NEW.`id` AND `stale` <> 0)"                    \
+    "         AND `id` IN " _ANCESTORS("NEW.`id`") ";"                                                          \
+    "   UPDATE `catalog_stats` SET"                                                                             \
+    "          `count` = `count` + 1 + IFNULL((SELECT `count` FROM `catalog_stats` WHERE `id` = NEW.`id`), 0),"  \
+    "          `nbytes` = `nbytes` + IFNULL((SELECT `nbytes` FROM `catalog_stats` WHERE `id` = NEW.`id`), 0)"   \
+    "                     + (SELECT IFNULL(SUM(`nbytes`), 0) FROM `value_bytes` WHERE `id` = NEW.`id`),"        \
+    "          `first_day` = MIN(IFNULL(`first_day`, o.`f`), IFNULL(o.`f`, `first_day`)),"                      \
+    "          `last_day` = MAX(IFNULL(`last_day`, o.`l`), IFNULL(o.`l`, `last_day`))"                          \
+    "   FROM (SELECT MIN(`first_day`) AS `f`, MAX(`last_day`) AS `l`"                                           \
+    "         FROM (SELECT `first_day`, `last_day` FROM `value_days` WHERE `id` = NEW.`id`"                     \
+    "               UNION ALL SELECT `first_day`, `last_day` FROM `catalog_stats` WHERE `id` = NEW.`id`)) AS o" \
+    "   WHERE `catalog_stats`.`id` = NEW.`pid`;"                                                                \
+    "END;"
+
+/* a new value adds its size to the statistics of the catalog of its object */
+#define _ADD_BYTES(tbl, id, bytes)                                            \
+    "CREATE TRIGGER `" tbl "_stats` AFTER INSERT ON `" tbl "` BEGIN"          \
+    "   UPDATE `catalog_stats` SET `nbytes` = `nbytes` + " bytes              \
+    "   WHERE `id` = " _PARENT("NEW.`" id "`") ";"                            \
+    "END;"
+
+/* same, with the days covered by the given axes */
+#define _ADD_VALUE(tbl, id, bytes, axes)                                                                 \
+    "CREATE TRIGGER `" tbl "_stats` AFTER INSERT ON `" tbl "` BEGIN"                                     \
+    "   UPDATE `catalog_stats` SET `nbytes` = `nbytes` + " bytes ","                                     \
+    "          `first_day` = MIN(IFNULL(`first_day`, a.`f`), IFNULL(a.`f`, `first_day`)),"               \
+    "          `last_day` = MAX(IFNULL(`last_day`, a.`l`), IFNULL(a.`l`, `last_day`))"                   \
+    "   FROM (SELECT MIN(`first_day`) AS `f`, MAX(`last_day`) AS `l` FROM `axes` WHERE `id` IN (" axes ")) AS a" \
+    "   WHERE `catalog_stats`.`id` = " _PARENT("NEW.`" id "`") ";"                                       \
+    "END;"
+
+/* a changed value applies the change of its size */
+#define _UPDATE_BYTES(tbl)                                                                          \
+    "CREATE TRIGGER `" tbl "_restats` BEFORE UPDATE OF `value`, `blob_id` ON `" tbl "` BEGIN"       \
+    "   UPDATE `catalog_stats` SET `nbytes` = `nbytes` + " _ROW_BYTES("NEW") " - " _ROW_BYTES("OLD") \
+    "   WHERE `id` = " _PARENT("NEW.`id`") ";"                                                      \
+    "END;"
+
+/* a tseries moved to another axis may no longer cover the edge of the
+   coverage of the catalogs above it */
+#define _TSERIES_REDAYS                                                                                  \
+    "CREATE TRIGGER `tseries_redays` AFTER UPDATE OF `axis_id` ON `tseries`"                             \
+    "   WHEN OLD.`axis_id` <> NEW.`axis_id` BEGIN"                                                       \
+    "   UPDATE `catalog_stats` SET `stale` = 1"                                                          \
+    "   FROM (SELECT `first_day` AS `f`, `last_day` AS `l` FROM `axes` WHERE `id` = OLD.`axis_id`) AS a" \
+    "   WHERE a.`f` IS NOT NULL AND `catalog_stats`.`id` IN " _ANCESTORS("NEW.`id`")                     \
+    "         AND (a.`f` <= `first_day` OR a.`l` >= `last_day`);"                                        \
+    "   UPDATE `catalog_stats` SET"                                                                      \
+    "          `first_day` = MIN(IFNULL(`first_day`, a.`f`), IFNULL(a.`f`, `first_day`)),"               \
+    "          `last_day` = MAX(IFNULL(`last_day`, a.`l`), IFNULL(a.`l`, `last_day`))"                   \
+    "   FROM (SELECT `first_day` AS `f`, `last_day` AS `l` FROM `axes` WHERE `id` = NEW.`axis_id`) AS a" \
+    "   WHERE `catalog_stats`.`id` = " _PARENT("NEW.`id`") ";"                                           \
+    "END;"
+
+/* all the triggers that keep the statistics, as they were in any version */
+#define _DROP_STATS_TRIGGERS                              \
+    "DROP TRIGGER IF EXISTS `catalog_stats_up`;"          \
+    "DROP TRIGGER IF EXISTS `objects_stats`;"             \
+    "DROP TRIGGER IF EXISTS `objects_unstats`;"           \
+    "DROP TRIGGER IF EXISTS `objects_move_out`;"          \
+    "DROP TRIGGER IF EXISTS `objects_move_in`;"           \
+    "DROP TRIGGER IF EXISTS `scalars_stats`;"             \
+    "DROP TRIGGER IF EXISTS `chunks_stats`;"              \
+    "DROP TRIGGER IF EXISTS `tseries_stats`;"             \
+    "DROP TRIGGER IF EXISTS `mvtseries_stats`;"           \
+    "DROP TRIGGER IF EXISTS `ndtseries_stats`;"           \
+    "DROP TRIGGER IF EXISTS `ndaxes_stats`;"              \
+    "DROP TRIGGER IF EXISTS `tseries_restats`;"           \
+    "DROP TRIGGER IF EXISTS `mvtseries_restats`;"         \
+    "DROP TRIGGER IF EXISTS `ndtseries_restats`;"         \
+    "DROP TRIGGER IF EXISTS `tseries_redays`;"
+
+/* the triggers that keep the statistics, in this version */
+static int _create_stats_triggers(de_file de)
+{
+    RUN_SQL(de, _CATALOG_STATS_UP);
+    RUN_SQL(de, _OBJECTS_STATS);
+    RUN_SQL(de, _OBJECTS_UNSTATS);
+    RUN_SQL(de, _OBJECTS_MOVE_OUT);
+    RUN_SQL(de, _OBJECTS_MOVE_IN);
+    RUN_SQL(de, _ADD_BYTES("scalars", "id", "IFNULL(LENGTH(NEW.`value`), 0)"));
+    RUN_SQL(de, _ADD_BYTES("chunks", "obj_id", "IFNULL(LENGTH(NEW.`value`), 0)"));
+    RUN_SQL(de, _ADD_VALUE("tseries", "id", _ROW_BYTES("NEW"), "NEW.`axis_id`"));
+    RUN_SQL(de, _ADD_VALUE("mvtseries", "id", _ROW_BYTES("NEW"), "NEW.`axis1_id`, NEW.`axis2_id`"));
+    RUN_SQL(de, _ADD_BYTES("ndtseries", "id", _ROW_BYTES("NEW")));
+    RUN_SQL(de, _ADD_VALUE("ndaxes", "obj_id", "0", "NEW.`axis_id`"));
+    RUN_SQL(de, _UPDATE_BYTES("tseries"));
+    RUN_SQL(de, _UPDATE_BYTES("mvtseries"));
+    RUN_SQL(de, _UPDATE_BYTES("ndtseries"));
+    RUN_SQL(de, _TSERIES_REDAYS);
+    return DE_SUCCESS;
+}
+
+int _catalog_stats_on(de_file de, bool *on)
+{
+    int rc;
+    sqlite3_stmt *stmt;
+    if (SQLITE_OK != (rc = sqlite3_prepare_v2(de->db,
+                                              "SELECT 1 FROM main.`sqlite_schema` "
+                                              "WHERE `type` = 'trigger' AND `name` = 'objects_stats';",
+                                              -1, &stmt, NULL)))
+        return rc_error(rc);
+    rc = sqlite3_step(stmt);
+    *on = (rc == SQLITE_ROW);
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_ROW && rc != SQLITE_DONE)
+        return rc_error(rc);
+    return DE_SUCCESS;
+}
+
+int _set_catalog_stats(de_file de, bool on)
+{
+    if (on)
+    {
+        RUN_SQL(de, _CATALOG_STATS_FILL);
+        TRACE_RUN(_create_stats_triggers(de));
+    }
+    else
+    {
+        RUN_SQL(de, _DROP_STATS_TRIGGERS "DELETE FROM `catalog_stats`;");
+    }
+    return DE_SUCCESS;
+}
+
+/* fill in the days covered by the range axes of a file made by an earlier version */
+static int _init_axis_days(de_file de)
+{
+    sqlite3_stmt *stmt, *update;
+    int rc;
+    if (SQLITE_OK != (rc = sqlite3_prepare_v2(de->db, "SELECT `id`, `frequency`, `data`, `length` FROM `axes` WHERE `ax_type` = ?;", -1, &stmt, NULL)))
+        return rc_error(rc);
+    if (SQLITE_OK != (rc = sqlite3_prepare_v2(de->db, "UPDATE `axes` SET `first_day` = ?, `last_day` = ? WHERE `id` = ?;", -1, &update, NULL)))
+    {
+        sqlite3_finalize(stmt);
+        return rc_error(rc);
+    }
+    sqlite3_bind_int(stmt, 1, axis_range);
+    while (SQLITE_ROW == (rc = sqlite3_step(stmt)))
+    {
+        date_t first_day, last_day;
+        if (!_range_days(sqlite3_column_int(stmt, 1), sqlite3_column_int64(stmt, 2), sqlite3_column_int64(stmt, 3),
+                         &first_day, &last_day))
+            continue;
+        sqlite3_reset(update);
+        sqlite3_bind_int64(update, 1, first_day);
+        sqlite3_bind_int64(update, 2, last_day);
+        sqlite3_bind_int64(update, 3, sqlite3_column_int64(stmt, 0));
+        if (SQLITE_DONE != (rc = sqlite3_step(update)))
+            break;
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_finalize(update);
+    if (rc != SQLITE_DONE)
+        return rc_error(rc);
+    return DE_SUCCESS;
+}
+
+/* the version of the schema of the file, kept in PRAGMA user_version */
+static int _schema_version(de_file de, int *version)
+{
+    int rc;
+    sqlite3_stmt *stmt;
+    if (SQLITE_OK != (rc = sqlite3_prepare_v2(de->db, "PRAGMA user_version;", -1, &stmt, NULL)))
+        return rc_error(rc);
+    *version = (SQLITE_ROW == sqlite3_step(stmt)) ? sqlite3_column_int(stmt, 0) : 0;
+    if (SQLITE_OK != (rc = sqlite3_finalize(stmt)))
+        return rc_error(rc);
+    return DE_SUCCESS;
+}
+
+/* bring the schema from the given version to the current one */
+static int _upgrade_schema(de_file de, int version)
+{
+    /* each case brings the schema from version `case` to the next one */
+    switch (version)
+    {
+    case 0:
+        RUN_SQL(de,
+                "CREATE TABLE `calendars` ("
+                "   `id` INTEGER PRIMARY KEY AUTOINCREMENT,"
+                "   `name` TEXT NOT NULL UNIQUE CHECK(LENGTH(`name`) > 0),"
+                "   `first` INTEGER NOT NULL,"
+                "   `last` INTEGER NOT NULL CHECK(`last` >= `first`),"
+                "   `holidays` BLOB"
+                ") STRICT;");
+        /* fall through */
+    case 1:
+        RUN_SQL(de,
+                "CREATE TABLE `chunk_layouts` ("
+                "   `id` INTEGER PRIMARY KEY,"
+                "   `elsize` INTEGER NOT NULL CHECK(`elsize` > 0),"
+                "   `ndims` INTEGER NOT NULL,"
+                "   `chunk_shape` BLOB NOT NULL,"
+                "   FOREIGN KEY (`id`) REFERENCES `objects` (`id`) ON DELETE CASCADE"
+                ") STRICT;");
+        RUN_SQL(de,
+                "CREATE TABLE `chunks` ("
+                "   `id` INTEGER PRIMARY KEY,"
+                "   `obj_id` INTEGER NOT NULL,"
+                "   `chunk_index` INTEGER NOT NULL,"
+                "   `value` BLOB,"
+                "   UNIQUE (`obj_id`, `chunk_index`),"
+                "   FOREIGN KEY (`obj_id`) REFERENCES `objects` (`id`) ON DELETE CASCADE"
+                ") STRICT;");
+        /* fall through */
+    case 2:
+        RUN_SQL(de, "ALTER TABLE `mvtseries` ADD COLUMN `order` INTEGER NOT NULL DEFAULT 0;");
+        /* fall through */
+    case 3:
+        /* files made by earlier versions are in the byte order of the host that
+           made them, which may not be this one. They don't get DE_BYTE_ORDER
+           until the caller states it with de_set_byte_order. */
+        /* fall through */
+    case 4:
+        RUN_SQL(de,
+                "CREATE TABLE `blobs` ("
+                "   `id` INTEGER PRIMARY KEY,"
+                "   `hash` INTEGER NOT NULL,"
+                "   `refcount` INTEGER NOT NULL DEFAULT 0,"
+                "   `value` BLOB NOT NULL"
+                ") STRICT;");
+        RUN_SQL(de, "CREATE INDEX `blobs_1` ON `blobs`(`hash`);");
+        RUN_SQL(de, _BLOB_REFS("tseries"));
+        RUN_SQL(de, _BLOB_REFS("mvtseries"));
+        RUN_SQL(de, _BLOB_REFS("ndtseries"));
+        /* fall through */
+    case 5:
+        RUN_SQL(de,
+                "CREATE TABLE `vintages` ("
+                "   `id` INTEGER PRIMARY KEY,"
+                "   `obj_id` INTEGER NOT NULL,"
+                "   `timestamp` INTEGER NOT NULL,"
+                "   `axis_id` INTEGER NOT NULL,"
+                "   `snapshot` INTEGER NOT NULL,"
+                "   `value` BLOB,"
+                "   UNIQUE (`obj_id`, `timestamp`),"
+                "   FOREIGN KEY (`obj_id`) REFERENCES `objects` (`id`) ON DELETE CASCADE,"
+                "   FOREIGN KEY (`axis_id`) REFERENCES `axes` (`id`) ON DELETE RESTRICT"
+                ") STRICT;");
+        RUN_SQL(de, "CREATE INDEX `vintages_1` ON `vintages`(`obj_id`, `snapshot`, `timestamp`);");
+        /* fall through */
+    case 6:
+        RUN_SQL(de,
+                "ALTER TABLE `axes` ADD COLUMN `first_day` INTEGER;"
+                "ALTER TABLE `axes` ADD COLUMN `last_day` INTEGER;");
+        TRACE_RUN(_init_axis_days(de));
+        RUN_SQL(de, _VALUE_VIEWS(""));
+        /* the statistics are off until they are asked for */
+        RUN_SQL(de, _CATALOG_STATS);
+        /* fall through */
+    case 7:
+        /* for the foreign keys to `axes`, checked when axes are deleted */
+        RUN_SQL(de,
+                "CREATE INDEX `tseries_1` ON `tseries`(`axis_id`);"
+                "CREATE INDEX `mvtseries_1` ON `mvtseries`(`axis1_id`);"
+                "CREATE INDEX `mvtseries_2` ON `mvtseries`(`axis2_id`);"
+                "CREATE INDEX `ndaxes_1` ON `ndaxes`(`axis_id`);"
+                "CREATE INDEX `vintages_2` ON `vintages`(`axis_id`);");
+        /* fall through */
+    case 8:
+        /* for the foreign keys to `blobs`, checked when the last reference to a blob is deleted */
+        RUN_SQL(de,
+                "CREATE INDEX `tseries_2` ON `tseries`(`blob_id`);"
+                "CREATE INDEX `mvtseries_3` ON `mvtseries`(`blob_id`);"
+                "CREATE INDEX `ndtseries_1` ON `ndtseries`(`blob_id`);");
+        /* objects deleted with their catalog's statistics are skipped (see below) */
+        /* fall through */
+    case 9:
+        /* moved objects update the statistics (see below) */
+        /* fall through */
+    default:
+        break;
+    }
+
+    /* files made with the statistics on get the triggers of this version */
+    bool on;
+    TRACE_RUN(_catalog_stats_on(de, &on));
+    if (on)
+    {
+        RUN_SQL(de, _DROP_STATS_TRIGGERS);
+        TRACE_RUN(_create_stats_triggers(de));
+    }
+
+    RUN_SQL(de, "PRAGMA user_version = " _STR(DE_SCHEMA_VERSION) ";");
+    return DE_SUCCESS;
+}
+
+int _upgrade_file(de_file de)
+{
+    int version;
+    TRACE_RUN(_schema_version(de, &version));
+    if (version >= DE_SCHEMA_VERSION)
+        return DE_SUCCESS;
+    /* some steps go through every object of the file, with temporary tables
+       as large as the file */
+    TRACE_RUN(_temp_store_file(de, true));
+    /* all the steps and the new version are written together or not at all.
+       The version is read again in case another connection upgraded the file
+       in the meantime. */
+    int rc = DE_SUCCESS;
+    if (SQLITE_OK != sqlite3_exec(de->db, "SAVEPOINT `de_upgrade`;", NULL, NULL, NULL))
+        rc = db_error(de);
+    else if (DE_SUCCESS != _schema_version(de, &version) ||
+             (version < DE_SCHEMA_VERSION && DE_SUCCESS != _upgrade_schema(de, version)))
+    {
+        rc = trace_error();
+        sqlite3_exec(de->db, "ROLLBACK TO `de_upgrade`; RELEASE `de_upgrade`;", NULL, NULL, NULL);
+    }
+    else if (SQLITE_OK != sqlite3_exec(de->db, "RELEASE `de_upgrade`;", NULL, NULL, NULL))
+        rc = db_error(de);
+    /* back to the setting of _open, whatever happened */
+    if (DE_SUCCESS != _temp_store_file(de, false) && rc == DE_SUCCESS)
+        rc = trace_error();
+    return rc;
+}
+
+/*
+    Present the schema of a file made by an earlier version, which we can't
+    upgrade because it is read-only, as the current one. Missing tables are
+    made empty in the `temp` schema, and tables with missing columns are
+    shadowed by views of the same name in `temp`, which SQLite searches before
+    `main`. Nothing is written to the file, and since the file can't be
+    changed, neither are the tables and views in `temp`.
+*/
+static int _compat_schema(de_file de)
+{
+    int version;
+    TRACE_RUN(_schema_version(de, &version));
+    if (version >= DE_SCHEMA_VERSION)
+        return DE_SUCCESS;
+    if (version < 1)
+    {
+        /* no calendars (case 0) */
+        RUN_SQL(de,
+                "CREATE TEMP TABLE `calendars` ("
+                "   `id` INTEGER PRIMARY KEY,"
+                "   `name` TEXT NOT NULL UNIQUE,"
+                "   `first` INTEGER NOT NULL,"
+                "   `last` INTEGER NOT NULL,"
+                "   `holidays` BLOB"
+                ");");
+    }
+    if (version < 2)
+    {
+        /* no values in chunks (case 1) */
+        RUN_SQL(de,
+                "CREATE TEMP TABLE `chunk_layouts` ("
+                "   `id` INTEGER PRIMARY KEY,"
+                "   `elsize` INTEGER NOT NULL,"
+                "   `ndims` INTEGER NOT NULL,"
+                "   `chunk_shape` BLOB NOT NULL"
+                ");"
+                "CREATE TEMP TABLE `chunks` ("
+                "   `id` INTEGER PRIMARY KEY,"
+                "   `obj_id` INTEGER NOT NULL,"
+                "   `chunk_index` INTEGER NOT NULL,"
+                "   `value` BLOB,"
+                "   UNIQUE (`obj_id`, `chunk_index`)"
+                ");");
+    }
+    if (version < 5)
+    {
+        /* no shared values (case 4 of _upgrade_file) */
+        RUN_SQL(de,
+                "CREATE TEMP TABLE `blobs` ("
+                "   `id` INTEGER PRIMARY KEY,"
+                "   `hash` INTEGER NOT NULL,"
+                "   `refcount` INTEGER NOT NULL DEFAULT 0,"
+                "   `value` BLOB NOT NULL"
+                ");"
+                "CREATE TEMP VIEW `tseries` AS SELECT *, NULL AS `blob_id` FROM main.`tseries`;"
+                "CREATE TEMP VIEW `ndtseries` AS SELECT *, NULL AS `blob_id` FROM main.`ndtseries`;");
+        /* values of mvtseries were all in column-major order before case 2 */
+        if (version < 3)
+        {
+            RUN_SQL(de, "CREATE TEMP VIEW `mvtseries` AS SELECT *, 0 AS `order`, NULL AS `blob_id` FROM main.`mvtseries`;");
+        }
+        else
+        {
+            RUN_SQL(de, "CREATE TEMP VIEW `mvtseries` AS SELECT *, NULL AS `blob_id` FROM main.`mvtseries`;");
+        }
+    }
+    if (version < 6)
+    {
+        /* no vintages (case 5) */
+        RUN_SQL(de,
+                "CREATE TEMP TABLE `vintages` ("
+                "   `id` INTEGER PRIMARY KEY,"
+                "   `obj_id` INTEGER NOT NULL,"
+                "   `timestamp` INTEGER NOT NULL,"
+                "   `axis_id` INTEGER NOT NULL,"
+                "   `snapshot` INTEGER NOT NULL,"
+                "   `value` BLOB,"
+                "   UNIQUE (`obj_id`, `timestamp`)"
+                ");");
+    }
+    if (version < 7)
+    {
+        /* no statistics and no days of axes, so no date coverage (case 6) */
+        RUN_SQL(de,
+                "CREATE TEMP VIEW `axes` AS SELECT *, NULL AS `first_day`, NULL AS `last_day` FROM main.`axes`;"
+                "CREATE TEMP TABLE `catalog_stats` ("
+                "   `id` INTEGER PRIMARY KEY,"
+                "   `count` INTEGER NOT NULL DEFAULT 0,"
+                "   `nbytes` INTEGER NOT NULL DEFAULT 0,"
+                "   `first_day` INTEGER,"
+                "   `last_day` INTEGER,"
+                "   `stale` INTEGER NOT NULL DEFAULT 0"
+                ");");
+        RUN_SQL(de, _VALUE_VIEWS("TEMP "));
+    }
     return DE_SUCCESS;
 }
 
@@ -127,23 +712,36 @@ const char *_get_statement_sql(stmt_name_t stmt_name)
     switch (stmt_name)
     {
     case stmt_new_object:
-        return "INSERT INTO `objects` (`pid`,`class`,`type`,`name`) VALUES (?,?,?,?);";
+        /* OR ABORT fails only this statement on a duplicate name, rather
+           than the whole transaction as ON CONFLICT ROLLBACK in the table */
+        return "INSERT OR ABORT INTO `objects` (`pid`,`class`,`type`,`name`) VALUES (?,?,?,?) RETURNING `id`;";
     case stmt_new_object_info:
         return "INSERT INTO `objects_info` (`id`,`created`,`depth`,`fullpath`) "
                "SELECT o.`id`, unixepoch('now'), po.`depth` + 1, format('%s/%s', po.`fullpath`, o.`name`) "
                "FROM `objects` as o LEFT JOIN `objects_info` as po on o.`pid` = po.`id` WHERE o.`id` = ?;";
+    case stmt_fill_object_info:
+        /* new objects in catalogs that have their info, then those under them */
+        return "WITH RECURSIVE `new`(`id`, `depth`, `fullpath`) AS ("
+               "   SELECT o.`id`, p.`depth` + 1, format('%s/%s', p.`fullpath`, o.`name`)"
+               "   FROM `objects` AS o JOIN `objects_info` AS p ON p.`id` = o.`pid`"
+               "   WHERE o.`id` >= ? AND NOT EXISTS (SELECT 1 FROM `objects_info` WHERE `id` = o.`id`)"
+               "   UNION ALL"
+               "   SELECT o.`id`, n.`depth` + 1, format('%s/%s', n.`fullpath`, o.`name`)"
+               "   FROM `objects` AS o JOIN `new` AS n ON o.`pid` = n.`id`"
+               ") INSERT INTO `objects_info` (`id`, `created`, `depth`, `fullpath`)"
+               "   SELECT `id`, unixepoch('now'), `depth`, `fullpath` FROM `new`;";
     case stmt_store_scalar:
         return "INSERT INTO `scalars` (`id`, `frequency`, `value`) VALUES (?,?,?);";
     case stmt_store_tseries:
-        return "INSERT INTO `tseries` (`id`, `eltype`, `elfreq`, `axis_id`, `value`) VALUES (?,?,?,?,?);";
+        return "INSERT INTO `tseries` (`id`, `eltype`, `elfreq`, `axis_id`, `value`, `blob_id`) VALUES (?,?,?,?,?,?);";
     case stmt_store_mvtseries:
-        return "INSERT INTO `mvtseries` (`id`, `eltype`, `elfreq`, `axis1_id`, `axis2_id`, `value`) VALUES (?,?,?,?,?,?);";
+        return "INSERT INTO `mvtseries` (`id`, `eltype`, `elfreq`, `axis1_id`, `axis2_id`, `value`, `order`, `blob_id`) VALUES (?,?,?,?,?,?,?,?);";
     case stmt_store_ndtseries:
-        return "INSERT INTO `ndtseries` (`id`, `eltype`, `elfreq`, `value`) VALUES (?,?,?,?);";
+        return "INSERT INTO `ndtseries` (`id`, `eltype`, `elfreq`, `value`, `blob_id`) VALUES (?,?,?,?,?);";
     case stmt_store_ndaxes:
         return "INSERT INTO `ndaxes` (`obj_id`, `axis_index`, `axis_id`) VALUES (?,?,?);";
     case stmt_new_axis:
-        return "INSERT INTO `axes` (`ax_type`, `length`, `frequency`, `data`) VALUES (?,?,?,?);";
+        return "INSERT INTO `axes` (`ax_type`, `length`, `frequency`, `data`, `first_day`, `last_day`) VALUES (?,?,?,?,?,?);";
     case stmt_find_object:
         return "SELECT `id` FROM `objects` WHERE `pid` = ? AND `name` = ?;";
     case stmt_find_fullpath:
@@ -155,17 +753,20 @@ const char *_get_statement_sql(stmt_name_t stmt_name)
     case stmt_load_scalar:
         return "SELECT `id`, `frequency`, `value` FROM `scalars` WHERE `id` = ?;";
     case stmt_load_tseries:
-        return "SELECT `id`, `eltype`, `elfreq`, `axis_id`, `value` FROM `tseries` WHERE `id` = ?;";
+        return "SELECT t.`id`, t.`eltype`, t.`elfreq`, t.`axis_id`, IFNULL(t.`value`, b.`value`) "
+               "FROM `tseries` AS t LEFT JOIN `blobs` AS b ON t.`blob_id` = b.`id` WHERE t.`id` = ?;";
     case stmt_load_mvtseries:
-        return "SELECT `id`, `eltype`, `elfreq`, `axis1_id`, `axis2_id`, `value` FROM `mvtseries` WHERE `id` = ?;";
+        return "SELECT t.`id`, t.`eltype`, t.`elfreq`, t.`axis1_id`, t.`axis2_id`, IFNULL(t.`value`, b.`value`), t.`order` "
+               "FROM `mvtseries` AS t LEFT JOIN `blobs` AS b ON t.`blob_id` = b.`id` WHERE t.`id` = ?;";
     case stmt_load_ndtseries:
-        return "SELECT `id`, `eltype`, `elfreq`, `value` FROM `ndtseries` WHERE `id` = ?;";
+        return "SELECT t.`id`, t.`eltype`, t.`elfreq`, IFNULL(t.`value`, b.`value`) "
+               "FROM `ndtseries` AS t LEFT JOIN `blobs` AS b ON t.`blob_id` = b.`id` WHERE t.`id` = ?;";
     case stmt_load_ndaxes:
-        return "SELECT `axes`.*, `ndaxes`.`axis_index` "
-               "FROM `ndaxes` LEFT JOIN `axes` ON `ndaxes`.`axis_id` = `axes`.`id` "
-               "WHERE `ndaxes`.`obj_id` = ? ORDER BY `ndaxes`.`axis_index`";
+        return "SELECT a.`id`, a.`ax_type`, a.`length`, a.`frequency`, a.`data`, n.`axis_index` "
+               "FROM `ndaxes` AS n LEFT JOIN `axes` AS a ON n.`axis_id` = a.`id` "
+               "WHERE n.`obj_id` = ? ORDER BY n.`axis_index`";
     case stmt_load_axis:
-        return "SELECT * FROM `axes` WHERE `id` = ?;";
+        return "SELECT `id`, `ax_type`, `length`, `frequency`, `data` FROM `axes` WHERE `id` = ?;";
     case stmt_delete_object:
         return "DELETE FROM `objects` WHERE `id` = ?;";
     case stmt_set_attribute:
@@ -180,6 +781,105 @@ const char *_get_statement_sql(stmt_name_t stmt_name)
         return "SELECT `fullpath`, `depth`, `created` FROM `objects_info` WHERE `id` = ?;";
     case stmt_count_objects:
         return "SELECT COUNT(*) from `objects` WHERE `pid` = ?;";
+    case stmt_new_calendar:
+        return "INSERT INTO `calendars` (`name`, `first`, `last`, `holidays`) VALUES (?,?,?,?);";
+    case stmt_find_calendar:
+        return "SELECT `id` FROM `calendars` WHERE `name` = ?;";
+    case stmt_load_calendar:
+        return "SELECT `id`, `first`, `last`, `holidays` FROM `calendars` WHERE `id` = ?;";
+    case stmt_load_tseries_meta:
+        return "SELECT t.`id`, t.`eltype`, t.`elfreq`, IFNULL(LENGTH(t.`value`), LENGTH(b.`value`)), "
+               "a.`id`, a.`ax_type`, a.`length`, a.`frequency`, a.`data` "
+               "FROM `tseries` AS t JOIN `axes` AS a ON t.`axis_id` = a.`id` LEFT JOIN `blobs` AS b ON t.`blob_id` = b.`id` "
+               "WHERE t.`id` = ?;";
+    case stmt_load_ndtseries_meta:
+        return "SELECT t.`id`, t.`eltype`, t.`elfreq`, IFNULL(LENGTH(t.`value`), LENGTH(b.`value`)) "
+               "FROM `ndtseries` AS t LEFT JOIN `blobs` AS b ON t.`blob_id` = b.`id` WHERE t.`id` = ?;";
+    case stmt_load_mvtseries_meta:
+        return "SELECT t.`id`, t.`eltype`, t.`elfreq`, t.`axis1_id`, t.`axis2_id`, IFNULL(LENGTH(t.`value`), LENGTH(b.`value`)), t.`order` "
+               "FROM `mvtseries` AS t LEFT JOIN `blobs` AS b ON t.`blob_id` = b.`id` WHERE t.`id` = ?;";
+    case stmt_store_chunk_layout:
+        return "INSERT INTO `chunk_layouts` (`id`, `elsize`, `ndims`, `chunk_shape`) VALUES (?,?,?,?);";
+    case stmt_load_chunk_layout:
+        return "SELECT `elsize`, `ndims`, `chunk_shape` FROM `chunk_layouts` WHERE `id` = ?;";
+    case stmt_store_chunk:
+        return "INSERT INTO `chunks` (`obj_id`, `chunk_index`, `value`) VALUES (?,?,?);";
+    case stmt_find_chunk:
+        return "SELECT `id` FROM `chunks` WHERE `obj_id` = ? AND `chunk_index` = ?;";
+    case stmt_reserve_tseries:
+        return "UPDATE `tseries` SET `value` = zeroblob(?) WHERE `id` = ?;";
+    case stmt_reserve_mvtseries:
+        return "UPDATE `mvtseries` SET `value` = zeroblob(?) WHERE `id` = ?;";
+    case stmt_reserve_ndtseries:
+        return "UPDATE `ndtseries` SET `value` = zeroblob(?) WHERE `id` = ?;";
+    case stmt_find_blob:
+        return "SELECT `id` FROM `blobs` WHERE `hash` = ? AND `value` = ?;";
+    case stmt_new_blob:
+        return "INSERT INTO `blobs` (`hash`, `value`) VALUES (?,?);";
+    case stmt_find_tseries_blob:
+        return "SELECT `blob_id` FROM `tseries` WHERE `id` = ?;";
+    case stmt_find_mvtseries_blob:
+        return "SELECT `blob_id` FROM `mvtseries` WHERE `id` = ?;";
+    case stmt_find_ndtseries_blob:
+        return "SELECT `blob_id` FROM `ndtseries` WHERE `id` = ?;";
+    case stmt_blob_stats:
+        return "SELECT COUNT(*), IFNULL(SUM(LENGTH(`value`)), 0), IFNULL(SUM(`refcount`), 0) FROM `blobs`;";
+    case stmt_update_tseries:
+        return "UPDATE `tseries` SET `axis_id` = ?, `value` = ?, `blob_id` = ? WHERE `id` = ?;";
+    case stmt_store_vintage:
+        return "INSERT INTO `vintages` (`obj_id`, `timestamp`, `axis_id`, `snapshot`, `value`) VALUES (?,?,?,?,?);";
+    case stmt_last_vintage:
+        return "SELECT MAX(`timestamp`), COUNT(*) FROM `vintages` WHERE `obj_id` = ?1 AND `timestamp` >= "
+               "(SELECT MAX(`timestamp`) FROM `vintages` WHERE `obj_id` = ?1 AND `snapshot` = 1);";
+    case stmt_load_vintages:
+        return "SELECT `timestamp`, `axis_id`, `snapshot`, `value` FROM `vintages` "
+               "WHERE `obj_id` = ?1 AND `timestamp` <= ?2 AND `timestamp` >= "
+               "(SELECT MAX(`timestamp`) FROM `vintages` WHERE `obj_id` = ?1 AND `timestamp` <= ?2 AND `snapshot` = 1) "
+               "ORDER BY `timestamp`;";
+    case stmt_storage_pages:
+        return "SELECT s.`page_size`, c.`page_count`, f.`freelist_count`, v.`auto_vacuum` "
+               "FROM pragma_page_size AS s, pragma_page_count AS c, pragma_freelist_count AS f, pragma_auto_vacuum AS v;";
+    case stmt_storage_tables:
+        return "SELECT `name`, SUM(`pgsize`), SUM(`unused`) FROM `dbstat` WHERE `schema` = 'main' "
+               "GROUP BY `name` ORDER BY `name`;";
+    case stmt_load_catalog_stats:
+        return "SELECT `count`, `nbytes`, `first_day`, `last_day`, `stale` FROM `catalog_stats` WHERE `id` = ?;";
+    case stmt_catalog_days:
+        return "WITH RECURSIVE `sub`(`id`) AS ("
+               "   SELECT ?1 UNION ALL"
+               "   SELECT o.`id` FROM `objects` AS o JOIN `sub` AS s ON o.`pid` = s.`id` WHERE o.`id` <> 0"
+               ") SELECT MIN((SELECT MIN(`first_day`) FROM `value_days` AS d WHERE d.`id` = s.`id`)),"
+               "         MAX((SELECT MAX(`last_day`) FROM `value_days` AS d WHERE d.`id` = s.`id`)) FROM `sub` AS s;";
+    case stmt_catalog_totals:
+        return "WITH RECURSIVE `sub`(`id`) AS ("
+               "   SELECT ?1 UNION ALL"
+               "   SELECT o.`id` FROM `objects` AS o JOIN `sub` AS s ON o.`pid` = s.`id` WHERE o.`id` <> 0"
+               ") SELECT COUNT(*) - 1, IFNULL(SUM((SELECT SUM(`nbytes`) FROM `value_bytes` AS v WHERE v.`id` = s.`id`)), 0),"
+               "         MIN((SELECT MIN(`first_day`) FROM `value_days` AS d WHERE d.`id` = s.`id`)),"
+               "         MAX((SELECT MAX(`last_day`) FROM `value_days` AS d WHERE d.`id` = s.`id`)) FROM `sub` AS s;";
+    case stmt_store_catalog_days:
+        return "UPDATE `catalog_stats` SET `first_day` = ?, `last_day` = ?, `stale` = 0 WHERE `id` = ?;";
+    case stmt_gc_axes:
+        return "DELETE FROM `axes` AS a WHERE"
+               "   NOT EXISTS (SELECT 1 FROM `tseries` WHERE `axis_id` = a.`id`) AND"
+               "   NOT EXISTS (SELECT 1 FROM `mvtseries` WHERE `axis1_id` = a.`id`) AND"
+               "   NOT EXISTS (SELECT 1 FROM `mvtseries` WHERE `axis2_id` = a.`id`) AND"
+               "   NOT EXISTS (SELECT 1 FROM `ndaxes` WHERE `axis_id` = a.`id`) AND"
+               "   NOT EXISTS (SELECT 1 FROM `vintages` WHERE `axis_id` = a.`id`);";
+    case stmt_rename_object:
+        return "UPDATE `objects` SET `name` = ? WHERE `id` = ?;";
+    case stmt_move_object:
+        return "UPDATE `objects` SET `pid` = ? WHERE `id` = ?;";
+    case stmt_update_fullpaths:
+        /* the paths under the object are made again from the names */
+        return "WITH RECURSIVE `sub`(`id`, `fullpath`, `depth`) AS ("
+               "   SELECT o.`id`, format('%s/%s', p.`fullpath`, o.`name`), p.`depth` + 1"
+               "   FROM `objects` AS o JOIN `objects_info` AS p ON p.`id` = o.`pid` WHERE o.`id` = ?"
+               "   UNION ALL"
+               "   SELECT o.`id`, format('%s/%s', s.`fullpath`, o.`name`), s.`depth` + 1"
+               "   FROM `objects` AS o JOIN `sub` AS s ON o.`pid` = s.`id`"
+               ") UPDATE `objects_info` SET `fullpath` = s.`fullpath`, `depth` = s.`depth`"
+               "   FROM `sub` AS s WHERE `objects_info`.`id` = s.`id`;";
     default:
         error1(DE_INTERNAL, "invalid stmt_name");
         return NULL;
@@ -211,7 +911,20 @@ sqlite3_stmt *_get_statement(de_file de, stmt_name_t stmt_name)
     return stmt;
 }
 
-int _open(const char *fname, de_file *pde, int flags)
+/* copy the whole content of database `source` into that of the de_file */
+static int _load_db(de_file de, sqlite3 *source)
+{
+    sqlite3_backup *backup = sqlite3_backup_init(de->db, "main", source, "main");
+    if (backup == NULL)
+        return db_error(de);
+    sqlite3_backup_step(backup, -1);
+    int rc = sqlite3_backup_finish(backup);
+    if (rc != SQLITE_OK)
+        return rc_error(rc);
+    return DE_SUCCESS;
+}
+
+int _open(const char *fname, de_file *pde, int flags, sqlite3 *source)
 {
 
     if (pde == NULL)
@@ -222,9 +935,12 @@ int _open(const char *fname, de_file *pde, int flags)
         return error(DE_ERR_ALLOC);
 
     int rc;
-    bool file_exists = ((flags & SQLITE_OPEN_MEMORY) == 0) && _isfile(fname);
+    bool file_exists = (source != NULL) || ((flags & SQLITE_OPEN_URI) != 0) ||
+                       (((flags & SQLITE_OPEN_MEMORY) == 0) && _isfile(fname));
 
-    if (SQLITE_OK != (rc = sqlite3_open_v2(fname, &de->db, flags, NULL)))
+    /* the name ":memory:" is enough for an in-memory database. With the flag,
+       files attached to it later would also be opened in memory */
+    if (SQLITE_OK != (rc = sqlite3_open_v2(fname, &de->db, flags & ~SQLITE_OPEN_MEMORY, NULL)))
     {
         sqlite3_close(de->db);
         free(de);
@@ -233,6 +949,7 @@ int _open(const char *fname, de_file *pde, int flags)
     }
 
     const char *sql_config_db = "PRAGMA foreign_keys = ON;"
+                                "PRAGMA recursive_triggers = ON;"
                                 "PRAGMA temp_store = MEMORY;";
     if (SQLITE_OK != sqlite3_exec(de->db, sql_config_db, NULL, NULL, NULL))
     {
@@ -244,10 +961,28 @@ int _open(const char *fname, de_file *pde, int flags)
     }
 
     if (file_exists)
+    {
+        /* bring files made by earlier versions up to date, or make them look
+           so if we can't write to them */
+        if ((source != NULL && DE_SUCCESS != _load_db(de, source)) ||
+            DE_SUCCESS != (sqlite3_db_readonly(de->db, "main") == 0 ? _upgrade_file(de) : _compat_schema(de)) ||
+            DE_SUCCESS != _init_byte_order(de))
+        {
+            rc = trace_error();
+            _fin_stmts(de);
+            sqlite3_close(de->db);
+            free(de);
+            *pde = NULL;
+            return rc;
+        }
+        /* don't hold a read lock on the file until it is used */
+        _reset_stmts(de);
         return DE_SUCCESS;
+    }
 
     if (DE_SUCCESS != _init_file(de))
     {
+        _fin_stmts(de);
         sqlite3_close(de->db);
         free(de);
         *pde = NULL;
@@ -260,26 +995,158 @@ int _open(const char *fname, de_file *pde, int flags)
 
 int de_open(const char *fname, de_file *pde)
 {
-    TRACE_RUN(_open(fname, pde, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE));
+    TRACE_RUN(_open(fname, pde, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL));
     return DE_SUCCESS;
 }
 
 int de_open_readonly(const char *fname, de_file *pde)
 {
-    TRACE_RUN(_open(fname, pde, SQLITE_OPEN_READONLY));
+    TRACE_RUN(_open(fname, pde, SQLITE_OPEN_READONLY, NULL));
     return DE_SUCCESS;
 }
 
 int de_open_memory(de_file *pde)
 {
-    TRACE_RUN(_open(":memory:", pde, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_MEMORY));
+    TRACE_RUN(_open(":memory:", pde, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_MEMORY, NULL));
+    return DE_SUCCESS;
+}
+
+/* return the URI of a file with the given query parameters. The caller must
+   free the memory. */
+static char *_file_uri(const char *fname, const char *query)
+{
+    char *uri = malloc(3 * strlen(fname) + strlen(query) + 8);
+    if (uri == NULL)
+    {
+        error(DE_ERR_ALLOC);
+        return NULL;
+    }
+    char *q = uri + sprintf(uri, "file:");
+    for (const char *p = fname; *p != '\0'; ++p)
+    {
+        if (*p == '%' || *p == '?' || *p == '#')
+            q += sprintf(q, "%%%02X", (unsigned char)*p);
+        else
+            *q++ = *p;
+    }
+    sprintf(q, "?%s", query);
+    return uri;
+}
+
+int de_open_immutable(const char *fname, int in_memory, de_file *pde)
+{
+    if (fname == NULL || pde == NULL)
+        return error(DE_NULL);
+    char *uri = _file_uri(fname, "immutable=1");
+    if (uri == NULL)
+        return trace_error();
+    const int flags = SQLITE_OPEN_READONLY | SQLITE_OPEN_URI | SQLITE_OPEN_SHAREDCACHE;
+    if (!in_memory)
+    {
+        int rc = _open(uri, pde, flags, NULL);
+        free(uri);
+        TRACE_RUN(rc);
+        return DE_SUCCESS;
+    }
+
+    sqlite3 *source;
+    int rc = sqlite3_open_v2(uri, &source, flags, NULL);
+    free(uri);
+    if (rc != SQLITE_OK)
+    {
+        sqlite3_close(source);
+        return rc_error(rc);
+    }
+    rc = _open(":memory:", pde, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_MEMORY, source);
+    sqlite3_close(source);
+    TRACE_RUN(rc);
+    /* the copy is as read-only as the file */
+    if (SQLITE_OK != sqlite3_exec((*pde)->db, "PRAGMA query_only = ON;", NULL, NULL, NULL))
+    {
+        rc = db_error(*pde);
+        de_close(*pde);
+        *pde = NULL;
+        return rc;
+    }
+    return DE_SUCCESS;
+}
+
+void *_get_scratch(de_file de, int64_t nbytes)
+{
+    if (nbytes <= de->scratch_size)
+        return de->scratch;
+    void *scratch = realloc(de->scratch, nbytes);
+    if (scratch == NULL)
+    {
+        error(DE_ERR_ALLOC);
+        return NULL;
+    }
+    de->scratch = scratch;
+    de->scratch_size = nbytes;
+    return scratch;
+}
+
+int de_set_byte_order(de_file de, const char *order)
+{
+    if (de == NULL || order == NULL)
+        return error(DE_NULL);
+    if (strcmp(order, "little") != 0 && strcmp(order, "big") != 0)
+        return error1(DE_ARG, order);
+    const char *current;
+    int rc = sql_get_attribute(de, 0, "DE_BYTE_ORDER", &current);
+    if (rc == DE_SUCCESS)
+        return error1(DE_EXISTS, "DE_BYTE_ORDER");
+    if (rc != DE_MIS_ATTR)
+        return trace_error();
+    de_clear_error();
+    TRACE_RUN(de_begin_transaction(de));
+    TRACE_RUN(sql_set_attribute(de, 0, "DE_BYTE_ORDER", order));
+    de->swap = strcmp(order, _host_byte_order()) != 0;
+    return DE_SUCCESS;
+}
+
+int de_set_dedup(de_file de, int enable)
+{
+    if (de == NULL)
+        return error(DE_NULL);
+    de->dedup = (enable != 0);
+    return DE_SUCCESS;
+}
+
+int de_dedup_stats(de_file de, int64_t *nblobs, int64_t *nbytes, int64_t *nrefs)
+{
+    if (de == NULL)
+        return error(DE_NULL);
+    TRACE_RUN(sql_blob_stats(de, nblobs, nbytes, nrefs));
+    return DE_SUCCESS;
+}
+
+int de_set_defer_info(de_file de, int enable)
+{
+    if (de == NULL)
+        return error(DE_NULL);
+    if (!enable)
+        TRACE_RUN(_fill_object_info(de));
+    de->defer_info = (enable != 0);
+    return DE_SUCCESS;
+}
+
+int _fill_object_info(de_file de)
+{
+    if (de->info_from == 0)
+        return DE_SUCCESS;
+    TRACE_RUN(sql_fill_object_info(de, de->info_from));
+    de->info_from = 0;
     return DE_SUCCESS;
 }
 
 int de_commit(de_file de)
 {
+    if (de->bulk.on)
+        return error1(DE_ARG, "a bulk load is in progress");
     if (de->transaction)
     {
+        TRACE_RUN(_fill_object_info(de));
         if (SQLITE_OK != sqlite3_exec(de->db, "COMMIT;", NULL, NULL, NULL))
             return db_error(de);
         de->transaction = false;
@@ -297,17 +1164,36 @@ int de_begin_transaction(de_file de)
     return DE_SUCCESS;
 }
 
+int64_t _statement_runs(de_file de)
+{
+    int64_t runs = 0;
+    for (stmt_name_t i = 0; i < stmt_last; ++i)
+        if (de->stmt[i] != NULL)
+            runs += sqlite3_stmt_status(de->stmt[i], SQLITE_STMTSTATUS_RUN, 0);
+    return runs;
+}
+
+int _temp_store_file(de_file de, bool file)
+{
+    RUN_SQL(de, file ? "PRAGMA temp_store = FILE;" : "PRAGMA temp_store = MEMORY;");
+    return DE_SUCCESS;
+}
+
+void _reset_stmts(de_file de)
+{
+    for (stmt_name_t i = 0; i < stmt_last; ++i)
+        if (de->stmt[i] != NULL)
+            sqlite3_reset(de->stmt[i]);
+}
+
 int _fin_stmts(de_file de)
 {
     for (stmt_name_t i = 0; i < stmt_last; ++i)
     {
-        int rc = sqlite3_finalize(de->stmt[i]);
-        if (SQLITE_OK == rc)
-        {
-            de->stmt[i] = NULL;
-            continue;
-        }
-        return rc_error(rc);
+        /* the statement is gone even if this returns the error of its last
+           run, which was reported then */
+        sqlite3_finalize(de->stmt[i]);
+        de->stmt[i] = NULL;
     }
     return DE_SUCCESS;
 }
@@ -316,12 +1202,22 @@ int de_close(de_file de)
 {
     if (de == NULL)
         return DE_SUCCESS;
-    TRACE_RUN(de_commit(de));
-    TRACE_RUN(_fin_stmts(de));
+    /* a bulk load that fails is rolled back by de_bulk_end, which restores
+       the settings. The file is closed all the same and the error returned. */
+    int rc = DE_SUCCESS;
+    if (de->bulk.on && DE_SUCCESS != de_bulk_end(de))
+        rc = trace_error();
+    else
+    {
+        TRACE_RUN(de_commit(de));
+    }
+    if (DE_SUCCESS != _fin_stmts(de) && rc == DE_SUCCESS)
+        rc = trace_error();
     if (SQLITE_OK != sqlite3_close(de->db))
         return db_error(de);
+    free(de->scratch);
     free(de);
-    return DE_SUCCESS;
+    return rc;
 }
 
 int de_truncate(de_file de)
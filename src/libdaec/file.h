@@ -2,6 +2,7 @@
 #define __FILE_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include <sqlite3.h>
 
@@ -18,15 +19,75 @@ int de_open(const char *fname, de_file *de);
 /* open daec file in read-only mode */
 int de_open_readonly(const char *fname, de_file *de);
 
+/*
+    open daec file in read-only mode, for files that never change while they
+    are open, e.g. published files on network storage.
+    NOTES:
+    * the file is opened without locking and without checking for changes by
+      other processes, which makes reading much faster on network file
+      systems. If the file does change, reads may fail or return wrong
+      results.
+    * connections to the same file in one process share their page cache.
+    * if `in_memory` is not 0, the whole file is copied into memory when it
+      is opened and the file itself is closed right away.
+*/
+int de_open_immutable(const char *fname, int in_memory, de_file *de);
+
 /* open a daec database in memory */
 int de_open_memory(de_file *pde);
 
-/* close a previously opened daec file */
+/* close a previously opened daec file. A bulk load in progress is ended
+   (see de_bulk_end); if that fails, the load is rolled back, the file is
+   closed anyway and the error is returned. */
 int de_close(de_file de);
 
 /* delete everything in the given daec file */
 int de_truncate(de_file de);
 
+/*
+    record the byte order, "little" or "big", of the values in the given daec
+    file, as the attribute DE_BYTE_ORDER of the root.
+    NOTES:
+    * new files record the byte order of the host that makes them. Files made
+      by versions of the library before the attribute don't, and their values
+      are read in the byte order of the host until it is recorded.
+    * return DE_EXISTS if the file already records its byte order.
+*/
+int de_set_byte_order(de_file de, const char *order);
+
+/*
+    turn deduplication of values on (enable != 0) or off for this de_file.
+    NOTES:
+    * while it is on, the values of new tseries, mvtseries and ndtseries are
+      kept in a store of blobs shared by all objects. A value that is already
+      in the store is not written again; the object only refers to it.
+    * each blob counts the objects that refer to it and is deleted together
+      with the last of them.
+    * the setting is not saved in the file; it is off when the file is opened.
+      Values stored either way are loaded the same way.
+    * chunked values and values written with de_open_*_writer are not shared.
+*/
+int de_set_dedup(de_file de, int enable);
+
+/* return the number of blobs in the shared store, their total size in bytes
+   and the number of references to them. Any of the outputs may be NULL. */
+int de_dedup_stats(de_file de, int64_t *nblobs, int64_t *nbytes, int64_t *nrefs);
+
+/*
+    turn deferred object info on (enable != 0) or off for this de_file.
+    NOTES:
+    * while it is on, new objects get their full path, depth and creation
+      time (see de_get_object_info) all at once, when the transaction is
+      committed, rather than one at a time. This makes loading many objects
+      faster.
+    * functions that need the info of new objects, e.g. de_find_fullpath,
+      fill it in before they run.
+    * the creation time of the new objects is the time their info is filled in.
+    * the setting is not saved in the file; it is off when the file is opened.
+      Turning it off fills in the info that is still missing.
+*/
+int de_set_defer_info(de_file de, int enable);
+
 /* ========================================================================= */
 /* internal */
 
@@ -57,6 +118,40 @@ typedef enum stmt_name
     stmt_get_all_attributes,
     stmt_get_object_info,
     stmt_count_objects,
+    stmt_new_calendar,
+    stmt_find_calendar,
+    stmt_load_calendar,
+    stmt_load_tseries_meta,
+    stmt_load_ndtseries_meta,
+    stmt_load_mvtseries_meta,
+    stmt_store_chunk_layout,
+    stmt_load_chunk_layout,
+    stmt_store_chunk,
+    stmt_find_chunk,
+    stmt_reserve_tseries,
+    stmt_reserve_mvtseries,
+    stmt_reserve_ndtseries,
+    stmt_find_blob,
+    stmt_new_blob,
+    stmt_find_tseries_blob,
+    stmt_find_mvtseries_blob,
+    stmt_find_ndtseries_blob,
+    stmt_blob_stats,
+    stmt_update_tseries,
+    stmt_store_vintage,
+    stmt_last_vintage,
+    stmt_load_vintages,
+    stmt_storage_pages,
+    stmt_storage_tables,
+    stmt_load_catalog_stats,
+    stmt_catalog_days,
+    stmt_catalog_totals,
+    stmt_store_catalog_days,
+    stmt_gc_axes,
+    stmt_rename_object,
+    stmt_move_object,
+    stmt_update_fullpaths,
+    stmt_fill_object_info,
     stmt_size,             /* sentinel, gives us the number of statements */
     stmt_last = stmt_size, /* alias, for readability */
 } stmt_name_t;
@@ -66,17 +161,76 @@ struct de_file_s
     sqlite3 *db;
     sqlite3_stmt *stmt[stmt_size];
     bool transaction;
+    bool swap;         /* true if the byte order of the file is not that of the host */
+    bool dedup;        /* true if new values go to the shared blob store */
+    bool defer_info;   /* true if objects_info of new objects is filled in at commit */
+    int64_t info_from; /* first object still without objects_info, 0 if none */
+    void *scratch;     /* memory for values assembled by the library */
+    struct
+    {
+        bool on;
+        int options;
+        int sync;        /* PRAGMA synchronous before it */
+        bool defer_info; /* setting of defer_info before it */
+    } bulk;              /* the bulk load in progress, see de_bulk_begin */
+    int64_t scratch_size;
 };
 
+/* version of the database schema, stored in `PRAGMA user_version` */
+#define DE_SCHEMA_VERSION 10
+
+#define _STR_(x) #x
+#define _STR(x) _STR_(x)
+
+/* open a de_file. If `source` is not NULL, the new database (usually in
+   memory) starts with a copy of its content. A URI (with SQLITE_OPEN_URI)
+   must name an existing file. */
+int _open(const char *fname, de_file *pde, int flags, sqlite3 *source);
+
 /* called when creating a new de_file. creates tables and indexes */
 int _init_file(de_file de);
 
+/* called when opening an existing de_file. adds tables and indexes introduced
+   after the file was created */
+int _upgrade_file(de_file de);
+
+/* whether the statistics of the catalogs are kept in the file */
+int _catalog_stats_on(de_file de, bool *on);
+
+/* start keeping the statistics of the catalogs, starting with those of the
+   objects already in the file, or stop keeping them */
+int _set_catalog_stats(de_file de, bool on);
+
 /* return a static buffer containing the SQL text for the given stmt_name */
 const char *_get_statement_sql(stmt_name_t stmt_name);
 
 /* return a prepared statement by the given name */
 sqlite3_stmt *_get_statement(de_file de, stmt_name_t stmt_name);
 
+/* number of times the prepared statements have been run, the triggers they
+   fire included, e.g. to count the statements of an operation (see prof.c) */
+int64_t _statement_runs(de_file de);
+
+/* finalize all prepared statements */
+int _fin_stmts(de_file de);
+
+/* reset all prepared statements, e.g. before changes to the schema, which
+   fail while statements are in progress */
+void _reset_stmts(de_file de);
+
+/* keep the temporary tables and indices of statements on disk (file != 0)
+   rather than in memory, as set when the file is opened. Statements that
+   rebuild the whole file, e.g. VACUUM, need as much temporary space as the
+   file takes. The setting can't change inside a transaction. */
+int _temp_store_file(de_file de, bool file);
+
+/* return a buffer of at least nbytes bytes owned by the de_file. Its content
+   is valid until the next library call. Return NULL if allocation fails. */
+void *_get_scratch(de_file de, int64_t nbytes);
+
+/* fill in objects_info for the objects created while it was deferred */
+int _fill_object_info(de_file de);
+
 /* functions that start and post transactions */
 int de_commit(de_file de);
 int de_begin_transaction(de_file de);
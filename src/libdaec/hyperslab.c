@@ -0,0 +1,453 @@
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "error.h"
+#include "file.h"
+#include "object.h"
+#include "hyperslab.h"
+#include "sql.h"
+#include "misc.h"
+#include "convert.h"
+
+/* column-major strides of an array with the given shape */
+static void _strides(int64_t ndims, const int64_t *shape, int64_t *strides)
+{
+    int64_t s = 1;
+    for (int64_t k = 0; k < ndims; ++k)
+    {
+        strides[k] = s;
+        s *= shape[k];
+    }
+}
+
+/* advance the multi-index `idx` within [lo, hi] along dimensions 1..ndims-1.
+   Dimension 0 is handled by the caller in whole runs. Return false when done. */
+static bool _next(int64_t ndims, int64_t *idx, const int64_t *lo, const int64_t *hi)
+{
+    for (int64_t k = 1; k < ndims; ++k)
+    {
+        if (idx[k] < hi[k])
+        {
+            ++idx[k];
+            return true;
+        }
+        idx[k] = lo[k];
+    }
+    return false;
+}
+
+int _init_layout(de_file de, obj_id_t id, const char *table, type_t eltype,
+                 int64_t ndims, const int64_t *dims, int64_t nbytes,
+                 array_layout_t *layout)
+{
+    if (ndims < 0 || ndims > DE_MAX_AXES)
+        return error(DE_BAD_NUM_AXES);
+    int64_t nelem = 1;
+    for (int64_t k = 0; k < ndims; ++k)
+    {
+        if (dims[k] < 0)
+            return error1(DE_BAD_OBJ, _id2str(id));
+        nelem *= dims[k];
+        layout->dims[k] = dims[k];
+        layout->chunk[k] = dims[k];
+    }
+    layout->id = id;
+    layout->table = table;
+    layout->eltype = eltype;
+    layout->ndims = ndims;
+    layout->chunked = false;
+    layout->elsize = 0;
+    if (nelem == 0)
+        return DE_SUCCESS;
+    if (nbytes > 0)
+    {
+        if (nbytes % nelem != 0)
+            return error1(DE_BAD_OBJ, _id2str(id));
+        layout->elsize = nbytes / nelem;
+        return DE_SUCCESS;
+    }
+    /* empty value: see if the elements are stored in chunks */
+    int64_t chunk_ndims;
+    int rc = sql_load_chunk_layout(de, id, &layout->elsize, &chunk_ndims, layout->chunk);
+    if (rc == DE_OBJ_DNE)
+    {
+        de_clear_error();
+        layout->elsize = 0;
+        return DE_SUCCESS;
+    }
+    if (rc != DE_SUCCESS)
+        return trace_error();
+    if (chunk_ndims != ndims)
+        return error1(DE_BAD_OBJ, _id2str(id));
+    layout->chunked = true;
+    return DE_SUCCESS;
+}
+
+int _init_chunked_layout(const char *table, type_t eltype, int64_t ndims, const int64_t *dims,
+                         const int64_t *chunk_shape, int64_t nbytes,
+                         array_layout_t *layout)
+{
+    if (chunk_shape == NULL)
+        return error(DE_NULL);
+    if (ndims < 1 || ndims > DE_MAX_AXES)
+        return error(DE_BAD_NUM_AXES);
+    int64_t nelem = 1;
+    for (int64_t k = 0; k < ndims; ++k)
+    {
+        if (chunk_shape[k] < 1)
+            return error(DE_ARG);
+        layout->dims[k] = dims[k];
+        /* no point in chunks longer than the axis */
+        layout->chunk[k] = (chunk_shape[k] < dims[k] || dims[k] == 0) ? chunk_shape[k] : dims[k];
+        nelem *= dims[k];
+    }
+    if ((nelem == 0 && nbytes != 0) || (nelem > 0 && (nbytes <= 0 || nbytes % nelem != 0)))
+        return error(DE_ARG);
+    layout->id = 0;
+    layout->table = table;
+    layout->eltype = eltype;
+    layout->chunked = true;
+    layout->ndims = ndims;
+    layout->elsize = (nelem > 0) ? nbytes / nelem : 0;
+    return DE_SUCCESS;
+}
+
+/* open the blob of the chunk with the given index */
+static int _open_chunk(de_file de, const array_layout_t *layout, int64_t chunk_index,
+                       sqlite3_blob **blob, bool *shared)
+{
+    if (!layout->chunked)
+        return sql_open_value_blob(de, layout->table, layout->id, false, blob, shared);
+    int64_t rowid;
+    TRACE_RUN(sql_find_chunk(de, layout->id, chunk_index, &rowid));
+    TRACE_RUN(sql_open_value_blob(de, "chunks", rowid, false, blob, NULL));
+    return DE_SUCCESS;
+}
+
+/* read the selected elements of one chunk. `c0` is the origin and `ext` the
+   extent of the chunk; `jlo` and `jhi` are the ranges of output indices that
+   fall inside it */
+static int _read_chunk(sqlite3_blob *blob, const array_layout_t *layout,
+                       const int64_t *start, const int64_t *stride, const int64_t *ostr,
+                       const int64_t *c0, const int64_t *ext, const int64_t *jlo, const int64_t *jhi,
+                       char *buf, char *value)
+{
+    const int64_t ndims = layout->ndims;
+    const int64_t es = layout->elsize;
+    int64_t cstr[DE_MAX_AXES];
+    _strides(ndims, ext, cstr);
+
+    const int64_t n0 = jhi[0] - jlo[0] + 1;
+    const int64_t i0 = start[0] + jlo[0] * stride[0] - c0[0];
+    const int64_t span = (n0 - 1) * stride[0] + 1;
+
+    int64_t j[DE_MAX_AXES];
+    memcpy(j, jlo, ndims * sizeof(int64_t));
+    do
+    {
+        int64_t coff = i0, ooff = jlo[0];
+        for (int64_t k = 1; k < ndims; ++k)
+        {
+            coff += (start[k] + j[k] * stride[k] - c0[k]) * cstr[k];
+            ooff += j[k] * ostr[k];
+        }
+        if (stride[0] == 1)
+        {
+            TRACE_RUN(sql_read_value_blob(blob, coff * es, n0 * es, value + ooff * es));
+        }
+        else
+        {
+            /* read the run that covers the selected elements and pick them out */
+            TRACE_RUN(sql_read_value_blob(blob, coff * es, span * es, buf));
+            for (int64_t i = 0; i < n0; ++i)
+                memcpy(value + (ooff + i) * es, buf + i * stride[0] * es, es);
+        }
+    } while (_next(ndims, j, jlo, jhi));
+    return DE_SUCCESS;
+}
+
+int _read_hyperslab(de_file de, const array_layout_t *layout,
+                    const int64_t *start, const int64_t *count, const int64_t *stride,
+                    void *value)
+{
+    const int64_t ndims = layout->ndims;
+    int64_t unit[DE_MAX_AXES];
+    if (stride == NULL)
+    {
+        for (int64_t k = 0; k < ndims; ++k)
+            unit[k] = 1;
+        stride = unit;
+    }
+    bool empty = false;
+    for (int64_t k = 0; k < ndims; ++k)
+    {
+        if (start[k] < 0 || count[k] < 0 || stride[k] < 1)
+            return error(DE_RANGE);
+        if (count[k] == 0)
+            empty = true;
+        else if (start[k] + (count[k] - 1) * stride[k] >= layout->dims[k])
+            return error(DE_RANGE);
+    }
+    if (empty || ndims == 0 || layout->elsize == 0)
+        return DE_SUCCESS;
+
+    /* strides of the output and of the grid of chunks; range of chunks to visit */
+    int64_t ostr[DE_MAX_AXES], nchunks[DE_MAX_AXES], gstr[DE_MAX_AXES];
+    int64_t glo[DE_MAX_AXES], ghi[DE_MAX_AXES], g[DE_MAX_AXES];
+    _strides(ndims, count, ostr);
+    for (int64_t k = 0; k < ndims; ++k)
+    {
+        nchunks[k] = (layout->dims[k] + layout->chunk[k] - 1) / layout->chunk[k];
+        glo[k] = start[k] / layout->chunk[k];
+        ghi[k] = (start[k] + (count[k] - 1) * stride[k]) / layout->chunk[k];
+    }
+    _strides(ndims, nchunks, gstr);
+
+    char *buf = NULL;
+    if (stride[0] > 1 && NULL == (buf = malloc(layout->chunk[0] * layout->elsize)))
+        return error(DE_ERR_ALLOC);
+
+    int rc = DE_SUCCESS;
+    sqlite3_blob *blob = NULL;
+    bool shared = false;
+    memcpy(g, glo, ndims * sizeof(int64_t));
+    while (1)
+    {
+        /* the chunks along dimension 0 are visited in the inner loop */
+        for (g[0] = glo[0]; g[0] <= ghi[0]; ++g[0])
+        {
+            int64_t c0[DE_MAX_AXES], ext[DE_MAX_AXES], jlo[DE_MAX_AXES], jhi[DE_MAX_AXES];
+            int64_t chunk_index = 0;
+            bool selected = true;
+            for (int64_t k = 0; k < ndims && selected; ++k)
+            {
+                c0[k] = g[k] * layout->chunk[k];
+                ext[k] = layout->dims[k] - c0[k];
+                if (ext[k] > layout->chunk[k])
+                    ext[k] = layout->chunk[k];
+                jlo[k] = (c0[k] > start[k]) ? (c0[k] - start[k] + stride[k] - 1) / stride[k] : 0;
+                jhi[k] = (c0[k] + ext[k] - 1 - start[k]) / stride[k];
+                if (jhi[k] > count[k] - 1)
+                    jhi[k] = count[k] - 1;
+                selected = jlo[k] <= jhi[k];
+                chunk_index += g[k] * gstr[k];
+            }
+            if (!selected)
+                continue;
+            if (DE_SUCCESS != (rc = _open_chunk(de, layout, chunk_index, &blob, &shared)) ||
+                DE_SUCCESS != (rc = _read_chunk(blob, layout, start, stride, ostr, c0, ext, jlo, jhi, buf, value)))
+            {
+                rc = trace_error();
+                goto done;
+            }
+        }
+        if (!_next(ndims, g, glo, ghi))
+            break;
+    }
+
+done:
+    if (blob != NULL && DE_SUCCESS != sql_close_value_blob(blob) && rc == DE_SUCCESS)
+        rc = trace_error();
+    free(buf);
+    return rc;
+}
+
+int _load_hyperslab(de_file de, const array_layout_t *layout,
+                    const int64_t *start, const int64_t *count, const int64_t *stride,
+                    int64_t *nbytes, void *value)
+{
+    int64_t needed = layout->elsize;
+    for (int64_t k = 0; k < layout->ndims; ++k)
+    {
+        if (start[k] < 0 || count[k] < 0 || (stride != NULL && stride[k] < 1) ||
+            (count[k] > 0 && start[k] + (count[k] - 1) * (stride ? stride[k] : 1) >= layout->dims[k]))
+            return error(DE_RANGE);
+        needed *= count[k];
+    }
+    if (layout->elsize == 0 && needed == 0)
+    {
+        /* elements of unknown size are selected when the object has no value */
+        int64_t nsel = 1;
+        for (int64_t k = 0; k < layout->ndims; ++k)
+            nsel *= count[k];
+        if (nsel > 0)
+            return error1(DE_BAD_OBJ, _id2str(layout->id));
+    }
+    if (*nbytes < 0)
+    {
+        *nbytes = needed;
+        return DE_SUCCESS;
+    }
+    if (*nbytes < needed)
+    {
+        *nbytes = needed;
+        return error(DE_SHORT_BUF);
+    }
+    *nbytes = needed;
+    if (needed == 0)
+        return DE_SUCCESS;
+    if (value == NULL)
+        return error(DE_NULL);
+    TRACE_RUN(_read_hyperslab(de, layout, start, count, stride, value));
+    if (de->swap)
+        _swap_elements(layout->eltype, layout->elsize, needed, value, value);
+    return DE_SUCCESS;
+}
+
+int _store_chunks(de_file de, const array_layout_t *layout, const void *value)
+{
+    const int64_t ndims = layout->ndims;
+    const int64_t es = layout->elsize;
+    TRACE_RUN(sql_store_chunk_layout(de, layout->id, es, ndims, layout->chunk));
+
+    int64_t nchunks[DE_MAX_AXES], vstr[DE_MAX_AXES], zero[DE_MAX_AXES], g[DE_MAX_AXES], glast[DE_MAX_AXES];
+    int64_t chunk_size = es;
+    for (int64_t k = 0; k < ndims; ++k)
+    {
+        if (layout->dims[k] == 0)
+            return DE_SUCCESS;
+        nchunks[k] = (layout->dims[k] + layout->chunk[k] - 1) / layout->chunk[k];
+        chunk_size *= layout->chunk[k];
+        zero[k] = 0;
+        glast[k] = nchunks[k] - 1;
+    }
+    _strides(ndims, layout->dims, vstr);
+
+    char *buf = malloc(chunk_size);
+    if (buf == NULL)
+        return error(DE_ERR_ALLOC);
+
+    int rc = DE_SUCCESS;
+    int64_t chunk_index = 0;
+    memcpy(g, zero, ndims * sizeof(int64_t));
+    while (1)
+    {
+        for (g[0] = 0; g[0] < nchunks[0]; ++g[0], ++chunk_index)
+        {
+            /* copy the chunk from the value into buf, one run along dimension 0 at a time */
+            int64_t c0[DE_MAX_AXES], ext[DE_MAX_AXES], elast[DE_MAX_AXES], cstr[DE_MAX_AXES], i[DE_MAX_AXES];
+            for (int64_t k = 0; k < ndims; ++k)
+            {
+                c0[k] = g[k] * layout->chunk[k];
+                ext[k] = layout->dims[k] - c0[k];
+                if (ext[k] > layout->chunk[k])
+                    ext[k] = layout->chunk[k];
+                elast[k] = ext[k] - 1;
+                i[k] = 0;
+            }
+            _strides(ndims, ext, cstr);
+            do
+            {
+                int64_t voff = c0[0], coff = 0;
+                for (int64_t k = 1; k < ndims; ++k)
+                {
+                    voff += (c0[k] + i[k]) * vstr[k];
+                    coff += i[k] * cstr[k];
+                }
+                memcpy(buf + coff * es, (const char *)value + voff * es, ext[0] * es);
+            } while (_next(ndims, i, zero, elast));
+            const int64_t nbytes = cstr[ndims - 1] * ext[ndims - 1] * es;
+            if (de->swap)
+                _swap_elements(layout->eltype, es, nbytes, buf, buf);
+            if (DE_SUCCESS != (rc = sql_store_chunk(de, layout->id, chunk_index, nbytes, buf, NULL)))
+            {
+                rc = trace_error();
+                goto done;
+            }
+        }
+        if (!_next(ndims, g, zero, glast))
+            break;
+    }
+
+done:
+    free(buf);
+    return rc;
+}
+
+int _load_chunks(de_file de, const array_layout_t *layout, int64_t *nbytes, const void **value)
+{
+    int64_t size = layout->elsize;
+    int64_t zero[DE_MAX_AXES];
+    for (int64_t k = 0; k < layout->ndims; ++k)
+    {
+        size *= layout->dims[k];
+        zero[k] = 0;
+    }
+    *nbytes = size;
+    *value = NULL;
+    if (size == 0)
+        return DE_SUCCESS;
+    void *buf = _get_scratch(de, size);
+    if (buf == NULL)
+        return trace_error();
+    TRACE_RUN(_read_hyperslab(de, layout, zero, layout->dims, NULL, buf));
+    if (de->swap)
+        _swap_elements(layout->eltype, layout->elsize, size, buf, buf);
+    *value = buf;
+    return DE_SUCCESS;
+}
+
+static inline int64_t _min(int64_t a, int64_t b) { return a < b ? a : b; }
+
+/* the transpose works on square blocks that fit in L1 cache together */
+#define TRANSPOSE_BLOCK 32
+
+#define TRANSPOSE_KERNEL(T)                                             \
+    {                                                                   \
+        const T *s = src;                                               \
+        T *d = dst;                                                     \
+        for (int64_t jb = 0; jb < ncols; jb += TRANSPOSE_BLOCK)         \
+        {                                                               \
+            const int64_t jmax = _min(jb + TRANSPOSE_BLOCK, ncols);     \
+            for (int64_t ib = 0; ib < nrows; ib += TRANSPOSE_BLOCK)     \
+            {                                                           \
+                const int64_t imax = _min(ib + TRANSPOSE_BLOCK, nrows); \
+                for (int64_t i = ib; i < imax; ++i)                     \
+                    for (int64_t j = jb; j < jmax; ++j)                 \
+                        d[i * ncols + j] = s[j * nrows + i];            \
+            }                                                           \
+        }                                                               \
+    }
+
+void _transpose(int64_t nrows, int64_t ncols, int64_t elsize, const void *src, void *dst)
+{
+    if (nrows == 1 || ncols == 1)
+    {
+        /* a vector is the same in both orders */
+        memcpy(dst, src, nrows * ncols * elsize);
+        return;
+    }
+    switch (elsize)
+    {
+    case 8:
+        TRANSPOSE_KERNEL(int64_t);
+        break;
+    case 4:
+        TRANSPOSE_KERNEL(int32_t);
+        break;
+    case 2:
+        TRANSPOSE_KERNEL(int16_t);
+        break;
+    case 1:
+        TRANSPOSE_KERNEL(int8_t);
+        break;
+    default:
+    {
+        const char *s = src;
+        char *d = dst;
+        for (int64_t jb = 0; jb < ncols; jb += TRANSPOSE_BLOCK)
+        {
+            const int64_t jmax = _min(jb + TRANSPOSE_BLOCK, ncols);
+            for (int64_t ib = 0; ib < nrows; ib += TRANSPOSE_BLOCK)
+            {
+                const int64_t imax = _min(ib + TRANSPOSE_BLOCK, nrows);
+                for (int64_t i = ib; i < imax; ++i)
+                    for (int64_t j = jb; j < jmax; ++j)
+                        memcpy(d + (i * ncols + j) * elsize, s + (j * nrows + i) * elsize, elsize);
+            }
+        }
+    }
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef __HYPERSLAB_H__
+#define __HYPERSLAB_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+#include "file.h"
+#include "object.h"
+
+/* ========================================================================= */
+/* internal */
+
+/* describes how the elements of an array object (mvtseries or ndtseries) are
+   stored. Elements are in column-major order, i.e. the index along the first
+   axis changes fastest. */
+typedef struct
+{
+    obj_id_t id;                /* id of the object */
+    const char *table;          /* table whose `value` column holds the elements when not chunked */
+    type_t eltype;              /* type of the elements */
+    bool chunked;               /* true if the elements are stored in the `chunks` table */
+    int64_t ndims;              /* number of dimensions */
+    int64_t elsize;             /* size of one element in bytes */
+    int64_t dims[DE_MAX_AXES];  /* number of elements along each dimension */
+    int64_t chunk[DE_MAX_AXES]; /* chunk shape; same as dims when not chunked */
+} array_layout_t;
+
+/* fill in the layout of an array object from its dimensions and the size of its
+   `value` column. An empty value means that the elements are stored in chunks,
+   or that there are no elements. */
+int _init_layout(de_file de, obj_id_t id, const char *table, type_t eltype,
+                 int64_t ndims, const int64_t *dims, int64_t nbytes,
+                 array_layout_t *layout);
+
+/* fill in the layout of a new chunked array object and validate the arguments
+   given to de_store_xyz_chunked. `layout->id` must be set by the caller once
+   the object is created. */
+int _init_chunked_layout(const char *table, type_t eltype, int64_t ndims, const int64_t *dims,
+                         const int64_t *chunk_shape, int64_t nbytes,
+                         array_layout_t *layout);
+
+/* read the hyperslab selected by `start`, `count` and `stride` into `value`,
+   in column-major order and in the byte order of the file. `stride` may be NULL, in which case it is 1 along
+   every dimension. Only the parts of the value (or the chunks) that contain
+   selected elements are read from the file. */
+int _read_hyperslab(de_file de, const array_layout_t *layout,
+                    const int64_t *start, const int64_t *count, const int64_t *stride,
+                    void *value);
+
+/* same as _read_hyperslab, but with the buffer protocol of de_pack_strings for
+   `nbytes`, and the elements are in the byte order of the host */
+int _load_hyperslab(de_file de, const array_layout_t *layout,
+                    const int64_t *start, const int64_t *count, const int64_t *stride,
+                    int64_t *nbytes, void *value);
+
+/* split the given value according to layout->chunk and write it in the
+   `chunks` table, in the byte order of the file. The layout is recorded in the `chunk_layouts` table. */
+int _store_chunks(de_file de, const array_layout_t *layout, const void *value);
+
+/* assemble the whole value of a chunked object in the scratch memory of the
+   de_file, in the byte order of the host. */
+int _load_chunks(de_file de, const array_layout_t *layout, int64_t *nbytes, const void **value);
+
+/* transpose a `nrows` x `ncols` matrix stored in column-major order in `src`
+   into `dst`, i.e. write it in row-major order. The two must not overlap. */
+void _transpose(int64_t nrows, int64_t ncols, int64_t elsize, const void *src, void *dst);
+
+#endif
@@ -129,3 +129,40 @@ int de_unpack_strings(const char *buffer, int64_t bufsize, const char **strvec,
     }
     return DE_SUCCESS;
 }
+
+/* a 64-bit hash built from the round and final avalanche of xxHash64, but
+   not xxHash64 itself: there are no 32-byte stripes, every 8-byte word goes
+   through the round and the remaining bytes are mixed one at a time. The
+   hashes are stored in `blobs`, so they must not change. */
+#define _H1 UINT64_C(0x9E3779B185EBCA87)
+#define _H2 UINT64_C(0xC2B2AE3D27D4EB4F)
+#define _H3 UINT64_C(0x165667B19E3779F9)
+#define _H4 UINT64_C(0x85EBCA77C2B2AE63)
+#define _ROTL(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+int64_t _hash_bytes(int64_t nbytes, const void *data)
+{
+    const unsigned char *p = data;
+    uint64_t h = _H3 + (uint64_t)nbytes;
+    int64_t i = 0;
+    for (; i + 8 <= nbytes; i += 8)
+    {
+        uint64_t w;
+        memcpy(&w, p + i, 8);
+        w *= _H2;
+        w = _ROTL(w, 31) * _H1;
+        h ^= w;
+        h = _ROTL(h, 27) * _H1 + _H4;
+    }
+    for (; i < nbytes; ++i)
+    {
+        h ^= p[i] * _H3;
+        h = _ROTL(h, 11) * _H1;
+    }
+    h ^= h >> 33;
+    h *= _H2;
+    h ^= h >> 29;
+    h *= _H3;
+    h ^= h >> 32;
+    return (int64_t)h;
+}
@@ -58,4 +58,8 @@ const char *_id2str(int64_t id);
 /* make a string "pid=N,name='abc'" given integer N */
 const char *_pidnm2str(int64_t pid, const char *name);
 
+/* a 64-bit hash of `nbytes` bytes of data, used to find identical values.
+   Not cryptographic; equal hashes must be confirmed by comparing the bytes. */
+int64_t _hash_bytes(int64_t nbytes, const void *data);
+
 #endif
@@ -1,11 +1,16 @@
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "error.h"
 #include "file.h"
 #include "object.h"
 #include "axis.h"
 #include "tseries.h"
 #include "mvtseries.h"
+#include "hyperslab.h"
 #include "sql.h"
+#include "convert.h"
 
 bool check_mvtseries_type(type_t type)
 {
@@ -18,29 +23,207 @@ int de_store_mvtseries(de_file de, obj_id_t pid, const char *name, type_t obj_ty
                        axis_id_t axis1_id, axis_id_t axis2_id,
                        int64_t nbytes, const void *value,
                        obj_id_t *id)
+{
+    TRACE_RUN(de_store_mvtseries_order(de, pid, name, obj_type, eltype, elfreq,
+                                       axis1_id, axis2_id, order_col_major, nbytes, value, id));
+    return DE_SUCCESS;
+}
+
+int de_store_mvtseries_order(de_file de, obj_id_t pid, const char *name, type_t obj_type,
+                             type_t eltype, frequency_t elfreq,
+                             axis_id_t axis1_id, axis_id_t axis2_id,
+                             order_t order, int64_t nbytes, const void *value,
+                             obj_id_t *id)
 {
     if (de == NULL || name == NULL)
         return error(DE_NULL);
     if (!check_mvtseries_type(obj_type))
         return error(DE_BAD_TYPE);
     TRACE_RUN(validate_eltype(obj_type, eltype, elfreq));
+    if (order != order_col_major && order != order_row_major)
+        return error(DE_ARG);
 
     obj_id_t _id;
     TRACE_RUN(_new_object(de, pid, class_mvtseries, obj_type, name, &_id));
     if (id != NULL)
         *id = _id;
-    TRACE_RUN(sql_store_mvtseries_value(de, _id, eltype, elfreq, axis1_id, axis2_id, nbytes, value));
+    if (de->swap && nbytes > 0)
+    {
+        axis_t axis1, axis2;
+        TRACE_RUN(sql_load_axis(de, axis1_id, &axis1));
+        TRACE_RUN(sql_load_axis(de, axis2_id, &axis2));
+        TRACE_RUN(_swap_value(de, eltype, axis1.length * axis2.length, nbytes, &value));
+    }
+    TRACE_RUN(sql_store_mvtseries_value(de, _id, eltype, elfreq, axis1_id, axis2_id, order, nbytes, value));
     return DE_SUCCESS;
 }
 
-/* load a 2d-array object by name from a given parent catalog */
-int de_load_mvtseries(de_file de, obj_id_t id, mvtseries_t *mvtseries)
+/* load a 2d-array object and the order in which its value is stored */
+static int _load_mvtseries(de_file de, obj_id_t id, mvtseries_t *mvtseries, order_t *order)
 {
     if (de == NULL || mvtseries == NULL)
         return error(DE_NULL);
     TRACE_RUN(sql_load_object(de, id, &(mvtseries->object)));
     if (mvtseries->object.obj_class != class_mvtseries)
         return error(DE_BAD_CLASS);
-    TRACE_RUN(sql_load_mvtseries_value(de, id, mvtseries));
+    TRACE_RUN(sql_load_mvtseries_value(de, id, mvtseries, order));
+    TRACE_RUN(_swap_value(de, mvtseries->eltype, mvtseries->axis1.length * mvtseries->axis2.length,
+                          mvtseries->nbytes, &mvtseries->value));
+    if (mvtseries->nbytes == 0)
+    {
+        /* the value might be stored in chunks */
+        const int64_t dims[2] = {mvtseries->axis1.length, mvtseries->axis2.length};
+        array_layout_t layout;
+        TRACE_RUN(_init_layout(de, id, "mvtseries", mvtseries->eltype, 2, dims, 0, &layout));
+        if (layout.chunked)
+            TRACE_RUN(_load_chunks(de, &layout, &mvtseries->nbytes, &mvtseries->value));
+    }
+    return DE_SUCCESS;
+}
+
+/* load a 2d-array object by name from a given parent catalog */
+int de_load_mvtseries(de_file de, obj_id_t id, mvtseries_t *mvtseries)
+{
+    TRACE_RUN(de_load_mvtseries_order(de, id, order_col_major, mvtseries));
+    return DE_SUCCESS;
+}
+
+int de_load_mvtseries_order(de_file de, obj_id_t id, order_t order, mvtseries_t *mvtseries)
+{
+    if (order != order_col_major && order != order_row_major)
+        return error(DE_ARG);
+    order_t stored;
+    TRACE_RUN(_load_mvtseries(de, id, mvtseries, &stored));
+    const int64_t nrows = mvtseries->axis1.length;
+    const int64_t ncols = mvtseries->axis2.length;
+    const int64_t nelem = nrows * ncols;
+    if (stored == order || nelem == 0 || mvtseries->nbytes == 0)
+        return DE_SUCCESS;
+    if (mvtseries->nbytes % nelem != 0)
+        return error1(DE_BAD_OBJ, "elements of variable size cannot be transposed");
+    const int64_t elsize = mvtseries->nbytes / nelem;
+
+    /* the value is either in SQLite's memory or, if it was assembled from chunks, in our scratch */
+    const void *src = mvtseries->value;
+    void *tmp = NULL;
+    if (src == de->scratch)
+    {
+        if (NULL == (tmp = malloc(mvtseries->nbytes)))
+            return error(DE_ERR_ALLOC);
+        memcpy(tmp, src, mvtseries->nbytes);
+        src = tmp;
+    }
+    void *dst = _get_scratch(de, mvtseries->nbytes);
+    if (dst == NULL)
+    {
+        free(tmp);
+        return trace_error();
+    }
+    if (stored == order_col_major)
+        _transpose(nrows, ncols, elsize, src, dst);
+    else
+        _transpose(ncols, nrows, elsize, src, dst);
+    free(tmp);
+    mvtseries->value = dst;
+    return DE_SUCCESS;
+}
+
+int de_get_mvtseries_order(de_file de, obj_id_t id, order_t *order)
+{
+    if (de == NULL || order == NULL)
+        return error(DE_NULL);
+    mvtseries_t mvtseries;
+    TRACE_RUN(sql_load_object(de, id, &(mvtseries.object)));
+    if (mvtseries.object.obj_class != class_mvtseries)
+        return error(DE_BAD_CLASS);
+    TRACE_RUN(sql_load_mvtseries_meta(de, id, &mvtseries, order));
+    return DE_SUCCESS;
+}
+
+int de_store_mvtseries_chunked(de_file de, obj_id_t pid, const char *name, type_t obj_type,
+                               type_t eltype, frequency_t elfreq,
+                               axis_id_t axis1_id, axis_id_t axis2_id,
+                               const int64_t *chunk_shape,
+                               int64_t nbytes, const void *value,
+                               obj_id_t *id)
+{
+    if (de == NULL || name == NULL || (value == NULL && nbytes > 0))
+        return error(DE_NULL);
+    if (!check_mvtseries_type(obj_type))
+        return error(DE_BAD_TYPE);
+    TRACE_RUN(validate_eltype(obj_type, eltype, elfreq));
+    if (eltype == type_string)
+        return error(DE_BAD_ELTYPE);
+
+    axis_t axis1, axis2;
+    TRACE_RUN(sql_load_axis(de, axis1_id, &axis1));
+    TRACE_RUN(sql_load_axis(de, axis2_id, &axis2));
+    const int64_t dims[2] = {axis1.length, axis2.length};
+    array_layout_t layout;
+    TRACE_RUN(_init_chunked_layout("mvtseries", eltype, 2, dims, chunk_shape, nbytes, &layout));
+
+    obj_id_t _id;
+    TRACE_RUN(_new_object(de, pid, class_mvtseries, obj_type, name, &_id));
+    if (id != NULL)
+        *id = _id;
+    TRACE_RUN(sql_store_mvtseries_value(de, _id, eltype, elfreq, axis1_id, axis2_id, order_col_major, 0, NULL));
+    layout.id = _id;
+    if (layout.elsize > 0)
+        TRACE_RUN(_store_chunks(de, &layout, value));
+    return DE_SUCCESS;
+}
+
+int de_load_mvtseries_slice(de_file de, obj_id_t id,
+                            const int64_t *start, const int64_t *count, const int64_t *stride,
+                            int64_t *nbytes, void *value)
+{
+    if (de == NULL || start == NULL || count == NULL || nbytes == NULL)
+        return error(DE_NULL);
+    mvtseries_t mvtseries;
+    TRACE_RUN(sql_load_object(de, id, &(mvtseries.object)));
+    if (mvtseries.object.obj_class != class_mvtseries)
+        return error(DE_BAD_CLASS);
+    order_t order;
+    TRACE_RUN(sql_load_mvtseries_meta(de, id, &mvtseries, &order));
+    if (order == order_col_major)
+    {
+        const int64_t dims[2] = {mvtseries.axis1.length, mvtseries.axis2.length};
+        array_layout_t layout;
+        TRACE_RUN(_init_layout(de, id, "mvtseries", mvtseries.eltype, 2, dims, mvtseries.nbytes, &layout));
+        TRACE_RUN(_load_hyperslab(de, &layout, start, count, stride, nbytes, value));
+        return DE_SUCCESS;
+    }
+
+    /* stored row-major: read the transposed selection, then transpose it */
+    const int64_t dims[2] = {mvtseries.axis2.length, mvtseries.axis1.length};
+    const int64_t tstart[2] = {start[1], start[0]};
+    const int64_t tcount[2] = {count[1], count[0]};
+    const int64_t tstride[2] = {stride ? stride[1] : 1, stride ? stride[0] : 1};
+    array_layout_t layout;
+    TRACE_RUN(_init_layout(de, id, "mvtseries", mvtseries.eltype, 2, dims, mvtseries.nbytes, &layout));
+    int64_t needed = -1;
+    TRACE_RUN(_load_hyperslab(de, &layout, tstart, tcount, tstride, &needed, NULL));
+    if (*nbytes < 0)
+    {
+        *nbytes = needed;
+        return DE_SUCCESS;
+    }
+    if (*nbytes < needed)
+    {
+        *nbytes = needed;
+        return error(DE_SHORT_BUF);
+    }
+    *nbytes = needed;
+    if (needed == 0)
+        return DE_SUCCESS;
+    if (value == NULL)
+        return error(DE_NULL);
+    void *tmp = _get_scratch(de, needed);
+    if (tmp == NULL)
+        return trace_error();
+    TRACE_RUN(_read_hyperslab(de, &layout, tstart, tcount, tstride, tmp));
+    if (de->swap)
+        _swap_elements(layout.eltype, layout.elsize, needed, tmp, tmp);
+    _transpose(tcount[0], tcount[1], layout.elsize, tmp, value);
     return DE_SUCCESS;
 }
@@ -29,9 +29,51 @@ int de_store_mvtseries(de_file de, obj_id_t pid, const char *name, type_t obj_ty
                        int64_t nbytes, const void *value,
                        obj_id_t *id);
 
-/* load a 2d-array object by name from a given parent catalog */
+/* load a 2d-array object by name from a given parent catalog. The value is
+   always in column-major order; one stored in row-major order (see
+   de_store_mvtseries_order) is transposed as in de_load_mvtseries_order. */
 int de_load_mvtseries(de_file de, obj_id_t id, mvtseries_t *mvtseries);
 
+typedef enum
+{
+    order_col_major = 0, /* elements along axis1 are contiguous (this is the default) */
+    order_row_major,     /* elements along axis2 are contiguous */
+} order_t;
+
+/* same as de_store_mvtseries, but the value is in the given order. The order
+   is recorded with the object. */
+int de_store_mvtseries_order(de_file de, obj_id_t pid, const char *name, type_t obj_type,
+                             type_t eltype, frequency_t elfreq,
+                             axis_id_t axis1_id, axis_id_t axis2_id,
+                             order_t order, int64_t nbytes, const void *value,
+                             obj_id_t *id);
+
+/* get the order in which the value of a 2d-array object is stored */
+int de_get_mvtseries_order(de_file de, obj_id_t id, order_t *order);
+
+/* same as de_load_mvtseries, but the value is returned in the requested
+   order. If it is stored in the other order, the elements are transposed into
+   memory managed by the library, valid until the next library call. */
+int de_load_mvtseries_order(de_file de, obj_id_t id, order_t order, mvtseries_t *mvtseries);
+
+/* load a hyperslab of a 2d-array object, e.g. some of its columns. This works
+   like de_load_ndtseries_slice with two axes, axis1 being the first. To load
+   column j use start = {0, j}, count = {axis1.length, 1}. The result is always
+   in column-major order, regardless of the order the value is stored in. */
+int de_load_mvtseries_slice(de_file de, obj_id_t id,
+                            const int64_t *start, const int64_t *count, const int64_t *stride,
+                            int64_t *nbytes, void *value);
+
+/* same as de_store_mvtseries, but the value is split into chunks of shape
+   `chunk_shape[0]` x `chunk_shape[1]`, each stored separately. See
+   de_store_ndtseries_chunked. */
+int de_store_mvtseries_chunked(de_file de, obj_id_t pid, const char *name, type_t obj_type,
+                               type_t eltype, frequency_t elfreq,
+                               axis_id_t axis1_id, axis_id_t axis2_id,
+                               const int64_t *chunk_shape,
+                               int64_t nbytes, const void *value,
+                               obj_id_t *id);
+
 /* ========================================================================= */
 /* internal */
 
@@ -6,7 +6,9 @@
 #include "axis.h"
 #include "tseries.h"
 #include "mvtseries.h"
+#include "hyperslab.h"
 #include "sql.h"
+#include "convert.h"
 
 bool check_ndtseries_type(type_t type)
 {
@@ -32,6 +34,17 @@ int de_store_ndtseries(de_file de, obj_id_t pid, const char *name, type_t obj_ty
     TRACE_RUN(_new_object(de, pid, class_ndtseries, obj_type, name, &_id));
     if (id != NULL)
         *id = _id;
+    if (de->swap && nbytes > 0)
+    {
+        int64_t nelem = 1;
+        for (int64_t n = 0; n < naxes; ++n)
+        {
+            axis_t axis;
+            TRACE_RUN(sql_load_axis(de, axis_ids[n], &axis));
+            nelem *= axis.length;
+        }
+        TRACE_RUN(_swap_value(de, eltype, nelem, nbytes, &value));
+    }
     TRACE_RUN(sql_store_ndtseries_value(de, _id, eltype, elfreq, nbytes, value));
     for (int64_t n = 0; n < naxes; ++n)
         TRACE_RUN(sql_store_ndaxes(de, _id, n, axis_ids[n]));
@@ -47,5 +60,80 @@ int de_load_ndtseries(de_file de, obj_id_t id, ndtseries_t *ndtseries)
     if (ndtseries->object.obj_class != class_ndtseries)
         return error(DE_BAD_CLASS);
     TRACE_RUN(sql_load_ndtseries_value(de, id, ndtseries));
+    int64_t dims[DE_MAX_AXES], nelem = 1;
+    for (int64_t n = 0; n < ndtseries->naxes; ++n)
+    {
+        dims[n] = ndtseries->axis[n].length;
+        nelem *= dims[n];
+    }
+    TRACE_RUN(_swap_value(de, ndtseries->eltype, nelem, ndtseries->nbytes, &ndtseries->value));
+    if (ndtseries->nbytes == 0)
+    {
+        /* the value might be stored in chunks */
+        array_layout_t layout;
+        TRACE_RUN(_init_layout(de, id, "ndtseries", ndtseries->eltype, ndtseries->naxes, dims, 0, &layout));
+        if (layout.chunked)
+            TRACE_RUN(_load_chunks(de, &layout, &ndtseries->nbytes, &ndtseries->value));
+    }
+    return DE_SUCCESS;
+}
+
+int de_store_ndtseries_chunked(de_file de, obj_id_t pid, const char *name, type_t obj_type,
+                               type_t eltype, frequency_t elfreq,
+                               int64_t naxes, const axis_id_t *axis_ids,
+                               const int64_t *chunk_shape,
+                               int64_t nbytes, const void *value,
+                               obj_id_t *id)
+{
+    if (de == NULL || name == NULL || axis_ids == NULL || (value == NULL && nbytes > 0))
+        return error(DE_NULL);
+    if (!check_ndtseries_type(obj_type))
+        return error(DE_BAD_TYPE);
+    TRACE_RUN(validate_eltype(obj_type, eltype, elfreq));
+    if (eltype == type_string)
+        return error(DE_BAD_ELTYPE);
+    if ((naxes < 1) || (naxes > DE_MAX_AXES))
+        return error(DE_BAD_NUM_AXES);
+
+    int64_t dims[DE_MAX_AXES];
+    for (int64_t n = 0; n < naxes; ++n)
+    {
+        axis_t axis;
+        TRACE_RUN(sql_load_axis(de, axis_ids[n], &axis));
+        dims[n] = axis.length;
+    }
+    array_layout_t layout;
+    TRACE_RUN(_init_chunked_layout("ndtseries", eltype, naxes, dims, chunk_shape, nbytes, &layout));
+
+    obj_id_t _id;
+    TRACE_RUN(_new_object(de, pid, class_ndtseries, obj_type, name, &_id));
+    if (id != NULL)
+        *id = _id;
+    TRACE_RUN(sql_store_ndtseries_value(de, _id, eltype, elfreq, 0, NULL));
+    for (int64_t n = 0; n < naxes; ++n)
+        TRACE_RUN(sql_store_ndaxes(de, _id, n, axis_ids[n]));
+    layout.id = _id;
+    if (layout.elsize > 0)
+        TRACE_RUN(_store_chunks(de, &layout, value));
+    return DE_SUCCESS;
+}
+
+int de_load_ndtseries_slice(de_file de, obj_id_t id,
+                            const int64_t *start, const int64_t *count, const int64_t *stride,
+                            int64_t *nbytes, void *value)
+{
+    if (de == NULL || start == NULL || count == NULL || nbytes == NULL)
+        return error(DE_NULL);
+    ndtseries_t ndtseries;
+    TRACE_RUN(sql_load_object(de, id, &(ndtseries.object)));
+    if (ndtseries.object.obj_class != class_ndtseries)
+        return error(DE_BAD_CLASS);
+    TRACE_RUN(sql_load_ndtseries_meta(de, id, &ndtseries));
+    int64_t dims[DE_MAX_AXES];
+    for (int64_t n = 0; n < ndtseries.naxes; ++n)
+        dims[n] = ndtseries.axis[n].length;
+    array_layout_t layout;
+    TRACE_RUN(_init_layout(de, id, "ndtseries", ndtseries.eltype, ndtseries.naxes, dims, ndtseries.nbytes, &layout));
+    TRACE_RUN(_load_hyperslab(de, &layout, start, count, stride, nbytes, value));
     return DE_SUCCESS;
 }
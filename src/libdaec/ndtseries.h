@@ -33,6 +33,34 @@ int de_store_ndtseries(de_file de, obj_id_t pid, const char *name, type_t obj_ty
 /* load a Nd-array object by name from a given parent catalog */
 int de_load_ndtseries(de_file de, obj_id_t id, ndtseries_t *ndtseries);
 
+/* same as de_store_ndtseries, but the value is split into chunks of shape
+   `chunk_shape` (one number per axis), each stored separately. Reading a
+   hyperslab of a chunked object only touches the chunks that contain
+   selected elements. Chunks at the end of an axis are truncated to the
+   length of the axis. The elements must be of fixed size, i.e. `nbytes` must
+   be a multiple of the number of elements. */
+int de_store_ndtseries_chunked(de_file de, obj_id_t pid, const char *name, type_t obj_type,
+                               type_t eltype, frequency_t elfreq,
+                               int64_t naxes, const axis_id_t *axis_ids,
+                               const int64_t *chunk_shape,
+                               int64_t nbytes, const void *value,
+                               obj_id_t *id);
+
+/*
+    load a hyperslab of a Nd-array object.
+    NOTES:
+    * `start`, `count` and `stride` have one entry per axis. Along axis k we
+      select the `count[k]` elements at positions `start[k]`,
+      `start[k] + stride[k]`, etc. `stride` may be NULL, meaning 1 for all axes.
+    * the selected elements are written in `value` in column-major order, i.e.
+      as an Nd-array of shape `count`. Return DE_RANGE if the selection does
+      not fit in the object.
+    * `nbytes` follows the same protocol as in de_pack_strings.
+*/
+int de_load_ndtseries_slice(de_file de, obj_id_t id,
+                            const int64_t *start, const int64_t *count, const int64_t *stride,
+                            int64_t *nbytes, void *value);
+
 /* ========================================================================= */
 /* internal */
 
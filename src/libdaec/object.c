@@ -9,6 +9,8 @@
 #include "file.h"
 #include "object.h"
 #include "sql.h"
+#include "misc.h"
+#include "delete.h"
 
 /* check if the given string is a valid object name */
 bool _check_name(const char *name)
@@ -44,19 +46,18 @@ int _new_object(de_file de, obj_id_t pid, class_t class, type_t type, const char
 {
     if (!_check_name(name))
         return trace_error();
-    int rc;
-    rc = sql_find_object(de, pid, name, NULL);
-    if (rc == DE_SUCCESS)
-        return error1(DE_EXISTS, name);
-    if (rc != DE_OBJ_DNE)
-        return trace_error();
-    de_clear_error();
     TRACE_RUN(de_begin_transaction(de));
-    TRACE_RUN(sql_new_object(de, pid, class, type, name));
-    obj_id_t _id = sqlite3_last_insert_rowid(de->db);
+    /* a duplicate name is found by the insert itself */
+    obj_id_t _id;
+    TRACE_RUN(sql_new_object(de, pid, class, type, name, &_id));
     if (id != NULL)
         *id = _id;
-    TRACE_RUN(sql_new_object_info(de, _id));
+    if (!de->defer_info)
+    {
+        TRACE_RUN(sql_new_object_info(de, _id));
+    }
+    else if (de->info_from == 0)
+        de->info_from = _id;
     return DE_SUCCESS;
 }
 
@@ -80,10 +81,75 @@ int de_delete_object(de_file de, obj_id_t id)
 {
     if (de == NULL)
         return error(DE_NULL);
+    /* without the foreign keys, nothing cascades */
+    if (de->bulk.on)
+        return de_delete_subtree(de, id, NULL, NULL);
     TRACE_RUN(sql_delete_object(de, id));
     return DE_SUCCESS;
 }
 
+/* check that no other object in catalog `pid` has the given name */
+static int _check_free_name(de_file de, obj_id_t id, obj_id_t pid, const char *name)
+{
+    obj_id_t other;
+    int rc = sql_find_object(de, pid, name, &other);
+    if (rc == DE_SUCCESS)
+        return (other == id) ? DE_SUCCESS : error1(DE_EXISTS, name);
+    if (rc != DE_OBJ_DNE)
+        return trace_error();
+    de_clear_error();
+    return DE_SUCCESS;
+}
+
+int de_rename(de_file de, obj_id_t id, const char *name)
+{
+    if (de == NULL || name == NULL)
+        return error(DE_NULL);
+    if (id == 0)
+        return error1(DE_ARG, "cannot rename the root catalog");
+    if (!_check_name(name))
+        return trace_error();
+    object_t object;
+    TRACE_RUN(sql_load_object(de, id, &object));
+    if (strcmp(object.name, name) == 0)
+        return DE_SUCCESS;
+    TRACE_RUN(_check_free_name(de, id, object.pid, name));
+    TRACE_RUN(de_begin_transaction(de));
+    TRACE_RUN(sql_rename_object(de, id, name));
+    TRACE_RUN(_fill_object_info(de));
+    TRACE_RUN(sql_update_fullpaths(de, id));
+    return DE_SUCCESS;
+}
+
+int de_move(de_file de, obj_id_t id, obj_id_t pid)
+{
+    if (de == NULL)
+        return error(DE_NULL);
+    if (id == 0)
+        return error1(DE_ARG, "cannot move the root catalog");
+    /* the new catalog must not be the object or under it */
+    object_t object;
+    for (obj_id_t cat = pid;; cat = object.pid)
+    {
+        if (cat == id)
+            return error1(DE_ARG, "cannot move a catalog under itself");
+        TRACE_RUN(sql_load_object(de, cat, &object));
+        if (cat == pid && object.obj_class != class_catalog)
+            return error1(DE_BAD_CLASS, _id2str(pid));
+        if (cat == 0)
+            break;
+    }
+    TRACE_RUN(sql_load_object(de, id, &object));
+    if (object.pid == pid)
+        return DE_SUCCESS;
+    TRACE_RUN(_check_free_name(de, id, pid, object.name));
+    TRACE_RUN(de_begin_transaction(de));
+    TRACE_RUN(sql_move_object(de, id, pid));
+    TRACE_RUN(_fill_object_info(de));
+    TRACE_RUN(sql_update_fullpaths(de, id));
+    return DE_SUCCESS;
+}
+
 int de_set_attribute(de_file de, obj_id_t id, const char *name, const char *value)
 {
     if (de == NULL || name == NULL)
@@ -113,6 +179,7 @@ int de_get_object_info(de_file de, obj_id_t id, const char **fullpath, int64_t *
 {
     if (de == NULL || (fullpath == NULL && depth == NULL && created == NULL))
         return error(DE_NULL);
+    TRACE_RUN(_fill_object_info(de));
     TRACE_RUN(sql_get_object_info(de, id, fullpath, depth, created));
     if (id == 0)
         *fullpath = "/";
@@ -129,6 +196,7 @@ int de_find_fullpath(de_file de, const char *fullpath, obj_id_t *id)
     }
     else
     {
+        TRACE_RUN(_fill_object_info(de));
         TRACE_RUN(sql_find_fullpath(de, fullpath, id));
     }
     return DE_SUCCESS;
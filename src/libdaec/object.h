@@ -76,6 +76,12 @@ int de_load_object(de_file de, obj_id_t id, object_t *object);
 /* delete object given id*/
 int de_delete_object(de_file de, obj_id_t id);
 
+/* give an object a new name in the same catalog */
+int de_rename(de_file de, obj_id_t id, const char *name);
+
+/* move an object, and everything under it if it is a catalog, to catalog `pid` */
+int de_move(de_file de, obj_id_t id, obj_id_t pid);
+
 /* set attribute by name */
 int de_set_attribute(de_file de, obj_id_t id, const char *name, const char *value);
 
@@ -10,6 +10,7 @@
 #include "scalar.h"
 #include "sql.h"
 #include "misc.h"
+#include "convert.h"
 
 bool check_scalar_type(type_t type)
 {
@@ -29,6 +30,7 @@ int de_store_scalar(de_file de, obj_id_t pid, const char *name, type_t type,
     TRACE_RUN(_new_object(de, pid, class_scalar, type, name, &_id));
     if (id != NULL)
         *id = _id;
+    TRACE_RUN(_swap_value(de, type, 1, nbytes, &value));
     TRACE_RUN(sql_store_scalar_value(de, _id, freq, nbytes, value));
     return DE_SUCCESS;
 }
@@ -41,5 +43,6 @@ int de_load_scalar(de_file de, obj_id_t id, scalar_t *scalar)
     if (scalar->object.obj_class != class_scalar)
         return error(DE_BAD_CLASS);
     TRACE_RUN(sql_load_scalar_value(de, id, scalar));
+    TRACE_RUN(_swap_value(de, scalar->object.obj_type, 1, scalar->nbytes, &scalar->value));
     return DE_SUCCESS;
 }
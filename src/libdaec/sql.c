@@ -12,6 +12,9 @@
 #include "tseries.h"
 #include "mvtseries.h"
 #include "ndtseries.h"
+#include "dates.h"
+#include "calendar.h"
+#include "catalog.h"
 #include "sql.h"
 #include "misc.h"
 
@@ -76,7 +79,7 @@ int sql_load_object(de_file de, obj_id_t id, object_t *object)
     return DE_SUCCESS;
 }
 
-int sql_new_object(de_file de, obj_id_t pid, class_t class, type_t type, const char *name)
+int sql_new_object(de_file de, obj_id_t pid, class_t class, type_t type, const char *name, obj_id_t *id)
 {
     sqlite3_stmt *stmt = _get_statement(de, stmt_new_object);
     if (stmt == NULL)
@@ -87,8 +90,23 @@ int sql_new_object(de_file de, obj_id_t pid, class_t class, type_t type, const c
     CHECK_SQLITE(sqlite3_bind_int(stmt, 2, class));
     CHECK_SQLITE(sqlite3_bind_int(stmt, 3, type));
     CHECK_SQLITE(sqlite3_bind_text(stmt, 4, name, -1, SQLITE_TRANSIENT));
-    rc = sqlite3_step(stmt);
-    return rc == SQLITE_DONE ? DE_SUCCESS : rc_error(rc);
+    switch ((rc = sqlite3_step(stmt)))
+    {
+    case SQLITE_ROW:
+        *id = sqlite3_column_int64(stmt, 0);
+        /* the insert is done, this only finishes the statement */
+        rc = sqlite3_step(stmt);
+        return rc == SQLITE_DONE ? DE_SUCCESS : rc_error(rc);
+    default:
+        /* a duplicate name fails the insert on its unique index */
+        if (sqlite3_extended_errcode(de->db) == SQLITE_CONSTRAINT_UNIQUE)
+            rc = error1(DE_EXISTS, name);
+        else
+            rc = rc_error(rc);
+        /* otherwise the next reset would report the error again */
+        sqlite3_reset(stmt);
+        return rc;
+    }
 }
 
 int sql_new_object_info(de_file de, obj_id_t id)
@@ -103,6 +121,18 @@ int sql_new_object_info(de_file de, obj_id_t id)
     return rc == SQLITE_DONE ? DE_SUCCESS : rc_error(rc);
 }
 
+int sql_fill_object_info(de_file de, obj_id_t from_id)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_fill_object_info);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, from_id));
+    rc = sqlite3_step(stmt);
+    return rc == SQLITE_DONE ? DE_SUCCESS : rc_error(rc);
+}
+
 int sql_delete_object(de_file de, obj_id_t id)
 {
     sqlite3_stmt *stmt = _get_statement(de, stmt_delete_object);
@@ -117,6 +147,44 @@ int sql_delete_object(de_file de, obj_id_t id)
     return rc == SQLITE_DONE ? DE_SUCCESS : rc_error(rc);
 }
 
+int sql_rename_object(de_file de, obj_id_t id, const char *name)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_rename_object);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_text(stmt, 1, name, -1, SQLITE_TRANSIENT));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 2, id));
+    rc = sqlite3_step(stmt);
+    return rc == SQLITE_DONE ? DE_SUCCESS : rc_error(rc);
+}
+
+int sql_move_object(de_file de, obj_id_t id, obj_id_t pid)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_move_object);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, pid));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 2, id));
+    rc = sqlite3_step(stmt);
+    return rc == SQLITE_DONE ? DE_SUCCESS : rc_error(rc);
+}
+
+int sql_update_fullpaths(de_file de, obj_id_t id)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_update_fullpaths);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, id));
+    rc = sqlite3_step(stmt);
+    return rc == SQLITE_DONE ? DE_SUCCESS : rc_error(rc);
+}
+
 int sql_set_attribute(de_file de, int64_t id, const char *name, const char *value)
 {
     sqlite3_stmt *stmt = _get_statement(de, stmt_set_attribute);
@@ -289,12 +357,13 @@ int sql_load_scalar_value(de_file de, obj_id_t id, scalar_t *scalar)
 /******************************************************************/
 /* axis */
 
-int _fill_axis(sqlite3_stmt *stmt, axis_t *axis)
+/* fill an axis from the columns of the `axes` table, which are found in the result row starting at column `col` */
+int _fill_axis_at(sqlite3_stmt *stmt, int col, axis_t *axis)
 {
-    axis->id = sqlite3_column_int64(stmt, 0);
-    axis->ax_type = sqlite3_column_int(stmt, 1);
-    axis->length = sqlite3_column_int64(stmt, 2);
-    axis->frequency = sqlite3_column_int(stmt, 3);
+    axis->id = sqlite3_column_int64(stmt, col + 0);
+    axis->ax_type = sqlite3_column_int(stmt, col + 1);
+    axis->length = sqlite3_column_int64(stmt, col + 2);
+    axis->frequency = sqlite3_column_int(stmt, col + 3);
     switch (axis->ax_type)
     {
     case axis_plain:
@@ -302,12 +371,12 @@ int _fill_axis(sqlite3_stmt *stmt, axis_t *axis)
         axis->names = NULL;
         break;
     case axis_range:
-        axis->first = sqlite3_column_int64(stmt, 4);
+        axis->first = sqlite3_column_int64(stmt, col + 4);
         axis->names = NULL;
         break;
     case axis_names:
         axis->first = 0;
-        axis->names = (const char *)sqlite3_column_text(stmt, 4);
+        axis->names = (const char *)sqlite3_column_text(stmt, col + 4);
         break;
     default:
         return error(DE_BAD_AXIS_TYPE);
@@ -315,6 +384,11 @@ int _fill_axis(sqlite3_stmt *stmt, axis_t *axis)
     return DE_SUCCESS;
 }
 
+int _fill_axis(sqlite3_stmt *stmt, axis_t *axis)
+{
+    return _fill_axis_at(stmt, 0, axis);
+}
+
 int sql_load_axis(de_file de, axis_id_t id, axis_t *axis)
 {
     sqlite3_stmt *stmt = _get_statement(de, stmt_load_axis);
@@ -335,6 +409,19 @@ int sql_load_axis(de_file de, axis_id_t id, axis_t *axis)
     }
 }
 
+int sql_gc_axes(de_file de, int64_t *removed)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_gc_axes);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    if (SQLITE_DONE != (rc = sqlite3_step(stmt)))
+        return rc_error(rc);
+    *removed = sqlite3_changes64(de->db);
+    return DE_SUCCESS;
+}
+
 int sql_find_axis(de_file de, axis_t *axis)
 {
     sqlite3_stmt *stmt = _get_statement(de, stmt_find_axis);
@@ -405,6 +492,18 @@ int sql_new_axis(de_file de, axis_t *axis)
     default:
         return error(DE_BAD_AXIS_TYPE);
     }
+    /* the days covered by a range of dates, for the statistics of catalogs */
+    date_t first_day, last_day;
+    if (axis->ax_type == axis_range && _range_days(axis->frequency, axis->first, axis->length, &first_day, &last_day))
+    {
+        CHECK_SQLITE(sqlite3_bind_int64(stmt, 5, first_day));
+        CHECK_SQLITE(sqlite3_bind_int64(stmt, 6, last_day));
+    }
+    else
+    {
+        CHECK_SQLITE(sqlite3_bind_null(stmt, 5));
+        CHECK_SQLITE(sqlite3_bind_null(stmt, 6));
+    }
     rc = sqlite3_step(stmt);
     if (rc == SQLITE_DONE)
     {
@@ -414,6 +513,90 @@ int sql_new_axis(de_file de, axis_t *axis)
     return rc_error(rc);
 }
 
+/**************************************************************/
+/* shared values */
+
+int sql_store_blob(de_file de, int64_t nbytes, const void *value, int64_t *blob_id)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_find_blob);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    int64_t hash = _hash_bytes(nbytes, value);
+    /* the value is only used during this call, no need to copy it */
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, hash));
+    CHECK_SQLITE(sqlite3_bind_blob64(stmt, 2, value, nbytes, SQLITE_STATIC));
+    switch ((rc = sqlite3_step(stmt)))
+    {
+    case SQLITE_ROW:
+        *blob_id = sqlite3_column_int64(stmt, 0);
+        CHECK_SQLITE(sqlite3_reset(stmt));
+        return DE_SUCCESS;
+    case SQLITE_DONE:
+        break;
+    default:
+        return rc_error(rc);
+    }
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    stmt = _get_statement(de, stmt_new_blob);
+    if (stmt == NULL)
+        return trace_error();
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, hash));
+    CHECK_SQLITE(sqlite3_bind_blob64(stmt, 2, value, nbytes, SQLITE_STATIC));
+    if (SQLITE_DONE != (rc = sqlite3_step(stmt)))
+        return rc_error(rc);
+    *blob_id = sqlite3_last_insert_rowid(de->db);
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    return DE_SUCCESS;
+}
+
+int sql_blob_stats(de_file de, int64_t *nblobs, int64_t *nbytes, int64_t *nrefs)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_blob_stats);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    if (SQLITE_ROW != (rc = sqlite3_step(stmt)))
+        return rc_error(rc);
+    if (nblobs != NULL)
+        *nblobs = sqlite3_column_int64(stmt, 0);
+    if (nbytes != NULL)
+        *nbytes = sqlite3_column_int64(stmt, 1);
+    if (nrefs != NULL)
+        *nrefs = sqlite3_column_int64(stmt, 2);
+    return DE_SUCCESS;
+}
+
+/* bind the value of a tseries, mvtseries or ndtseries to the `value` and
+   `blob_id` parameters of its insert statement. With deduplication on, the
+   value goes to the `blobs` table and only its id is bound. */
+static int _bind_value(de_file de, sqlite3_stmt *stmt, int value_col, int blob_col,
+                       int64_t nbytes, const void *value)
+{
+    int rc;
+    if (value == NULL || nbytes <= 0)
+    {
+        CHECK_SQLITE(sqlite3_bind_null(stmt, value_col));
+        CHECK_SQLITE(sqlite3_bind_null(stmt, blob_col));
+    }
+    else if (de->dedup)
+    {
+        int64_t blob_id;
+        TRACE_RUN(sql_store_blob(de, nbytes, value, &blob_id));
+        CHECK_SQLITE(sqlite3_bind_null(stmt, value_col));
+        CHECK_SQLITE(sqlite3_bind_int64(stmt, blob_col, blob_id));
+    }
+    else
+    {
+        CHECK_SQLITE(sqlite3_bind_blob(stmt, value_col, value, nbytes, SQLITE_TRANSIENT));
+        CHECK_SQLITE(sqlite3_bind_null(stmt, blob_col));
+    }
+    return DE_SUCCESS;
+}
+
 /**************************************************************/
 /* tseries */
 
@@ -431,14 +614,7 @@ int sql_store_tseries_value(de_file de, obj_id_t id,
     CHECK_SQLITE(sqlite3_bind_int(stmt, 2, eltype));
     CHECK_SQLITE(sqlite3_bind_int(stmt, 3, elfreq));
     CHECK_SQLITE(sqlite3_bind_int64(stmt, 4, axis_id));
-    if (value != NULL && nbytes > 0)
-    {
-        CHECK_SQLITE(sqlite3_bind_blob(stmt, 5, value, nbytes, SQLITE_TRANSIENT));
-    }
-    else
-    {
-        CHECK_SQLITE(sqlite3_bind_null(stmt, 5));
-    }
+    TRACE_RUN(_bind_value(de, stmt, 5, 6, nbytes, value));
     rc = sqlite3_step(stmt);
     return rc == SQLITE_DONE ? DE_SUCCESS : rc_error(rc);
 }
@@ -476,13 +652,127 @@ int sql_load_tseries_value(de_file de, obj_id_t id, tseries_t *tseries)
     }
 }
 
+int sql_load_tseries_meta(de_file de, obj_id_t id, tseries_t *tseries)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_load_tseries_meta);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, id));
+    switch ((rc = sqlite3_step(stmt)))
+    {
+    case SQLITE_ROW:
+        tseries->object.id = sqlite3_column_int64(stmt, 0);
+        tseries->eltype = sqlite3_column_int(stmt, 1);
+        tseries->elfreq = sqlite3_column_int(stmt, 2);
+        tseries->nbytes = sqlite3_column_int64(stmt, 3);
+        tseries->value = NULL;
+        TRACE_RUN(_fill_axis_at(stmt, 4, &(tseries->axis)));
+        return DE_SUCCESS;
+    case SQLITE_DONE:
+        return error1(DE_OBJ_DNE, _id2str(id));
+    default:
+        return rc_error(rc);
+    }
+}
+
+int sql_update_tseries_value(de_file de, obj_id_t id, axis_id_t axis_id, int64_t nbytes, const void *value)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_update_tseries);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, axis_id));
+    TRACE_RUN(_bind_value(de, stmt, 2, 3, nbytes, value));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 4, id));
+    rc = sqlite3_step(stmt);
+    return rc == SQLITE_DONE ? DE_SUCCESS : rc_error(rc);
+}
+
+/**************************************************************/
+/* vintages */
+
+int sql_store_vintage(de_file de, obj_id_t id, int64_t timestamp, axis_id_t axis_id,
+                      bool snapshot, int64_t nbytes, const void *value)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_store_vintage);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, id));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 2, timestamp));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 3, axis_id));
+    CHECK_SQLITE(sqlite3_bind_int(stmt, 4, snapshot));
+    if (value != NULL && nbytes > 0)
+    {
+        CHECK_SQLITE(sqlite3_bind_blob64(stmt, 5, value, nbytes, SQLITE_TRANSIENT));
+    }
+    else
+    {
+        CHECK_SQLITE(sqlite3_bind_null(stmt, 5));
+    }
+    rc = sqlite3_step(stmt);
+    return rc == SQLITE_DONE ? DE_SUCCESS : rc_error(rc);
+}
+
+int sql_last_vintage(de_file de, obj_id_t id, int64_t *timestamp, int64_t *count)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_last_vintage);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, id));
+    if (SQLITE_ROW != (rc = sqlite3_step(stmt)))
+        return rc_error(rc);
+    *timestamp = sqlite3_column_int64(stmt, 0);
+    *count = sqlite3_column_int64(stmt, 1);
+    return DE_SUCCESS;
+}
+
+int sql_load_vintages(de_file de, obj_id_t id, int64_t timestamp, sqlite3_stmt **stmt)
+{
+    *stmt = _get_statement(de, stmt_load_vintages);
+    if (*stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(*stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(*stmt, 1, id));
+    CHECK_SQLITE(sqlite3_bind_int64(*stmt, 2, timestamp));
+    return DE_SUCCESS;
+}
+
+int sql_next_vintage(sqlite3_stmt *stmt, bool *found, axis_id_t *axis_id, bool *snapshot,
+                     int64_t *nbytes, const void **value)
+{
+    int rc;
+    switch ((rc = sqlite3_step(stmt)))
+    {
+    case SQLITE_ROW:
+        *found = true;
+        *axis_id = sqlite3_column_int64(stmt, 1);
+        *snapshot = sqlite3_column_int(stmt, 2) != 0;
+        *nbytes = sqlite3_column_bytes(stmt, 3);
+        *value = sqlite3_column_blob(stmt, 3);
+        return DE_SUCCESS;
+    case SQLITE_DONE:
+        *found = false;
+        return DE_SUCCESS;
+    default:
+        return rc_error(rc);
+    }
+}
+
 /**************************************************************/
 /* mvtseries */
 
 int sql_store_mvtseries_value(de_file de, obj_id_t id,
                               type_t eltype, frequency_t elfreq,
                               axis_id_t axis1_id, axis_id_t axis2_id,
-                              int64_t nbytes, const void *value)
+                              order_t order, int64_t nbytes, const void *value)
 {
     sqlite3_stmt *stmt = _get_statement(de, stmt_store_mvtseries);
     if (stmt == NULL)
@@ -494,14 +784,8 @@ int sql_store_mvtseries_value(de_file de, obj_id_t id,
     CHECK_SQLITE(sqlite3_bind_int(stmt, 3, elfreq));
     CHECK_SQLITE(sqlite3_bind_int64(stmt, 4, axis1_id));
     CHECK_SQLITE(sqlite3_bind_int64(stmt, 5, axis2_id));
-    if (value != NULL && nbytes > 0)
-    {
-        CHECK_SQLITE(sqlite3_bind_blob(stmt, 6, value, nbytes, SQLITE_TRANSIENT));
-    }
-    else
-    {
-        CHECK_SQLITE(sqlite3_bind_null(stmt, 6));
-    }
+    TRACE_RUN(_bind_value(de, stmt, 6, 8, nbytes, value));
+    CHECK_SQLITE(sqlite3_bind_int(stmt, 7, order));
     rc = sqlite3_step(stmt);
     return rc == SQLITE_DONE ? DE_SUCCESS : rc_error(rc);
 }
@@ -519,7 +803,7 @@ void _fill_mvtseries(sqlite3_stmt *stmt, mvtseries_t *mvtseries)
     mvtseries->value = sqlite3_column_blob(stmt, 5);
 }
 
-int sql_load_mvtseries_value(de_file de, obj_id_t id, mvtseries_t *mvtseries)
+int sql_load_mvtseries_value(de_file de, obj_id_t id, mvtseries_t *mvtseries, order_t *order)
 {
     sqlite3_stmt *stmt = _get_statement(de, stmt_load_mvtseries);
     if (stmt == NULL)
@@ -531,6 +815,38 @@ int sql_load_mvtseries_value(de_file de, obj_id_t id, mvtseries_t *mvtseries)
     {
     case SQLITE_ROW:
         _fill_mvtseries(stmt, mvtseries);
+        if (order != NULL)
+            *order = sqlite3_column_int(stmt, 6);
+        TRACE_RUN(sql_load_axis(de, mvtseries->axis1.id, &(mvtseries->axis1)));
+        TRACE_RUN(sql_load_axis(de, mvtseries->axis2.id, &(mvtseries->axis2)));
+        return DE_SUCCESS;
+    case SQLITE_DONE:
+        return error(DE_BAD_OBJ);
+    default:
+        return rc_error(rc);
+    }
+}
+
+int sql_load_mvtseries_meta(de_file de, obj_id_t id, mvtseries_t *mvtseries, order_t *order)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_load_mvtseries_meta);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, id));
+    switch ((rc = sqlite3_step(stmt)))
+    {
+    case SQLITE_ROW:
+        mvtseries->object.id = sqlite3_column_int64(stmt, 0);
+        mvtseries->eltype = sqlite3_column_int(stmt, 1);
+        mvtseries->elfreq = sqlite3_column_int(stmt, 2);
+        mvtseries->axis1.id = sqlite3_column_int64(stmt, 3);
+        mvtseries->axis2.id = sqlite3_column_int64(stmt, 4);
+        mvtseries->nbytes = sqlite3_column_int64(stmt, 5);
+        mvtseries->value = NULL;
+        if (order != NULL)
+            *order = sqlite3_column_int(stmt, 6);
         TRACE_RUN(sql_load_axis(de, mvtseries->axis1.id, &(mvtseries->axis1)));
         TRACE_RUN(sql_load_axis(de, mvtseries->axis2.id, &(mvtseries->axis2)));
         return DE_SUCCESS;
@@ -555,14 +871,7 @@ int sql_store_ndtseries_value(de_file de, obj_id_t id, type_t eltype, frequency_
     CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, id));
     CHECK_SQLITE(sqlite3_bind_int(stmt, 2, eltype));
     CHECK_SQLITE(sqlite3_bind_int(stmt, 3, elfreq));
-    if (value != NULL && nbytes > 0)
-    {
-        CHECK_SQLITE(sqlite3_bind_blob(stmt, 4, value, nbytes, SQLITE_TRANSIENT));
-    }
-    else
-    {
-        CHECK_SQLITE(sqlite3_bind_null(stmt, 4));
-    }
+    TRACE_RUN(_bind_value(de, stmt, 4, 5, nbytes, value));
     rc = sqlite3_step(stmt);
     return rc == SQLITE_DONE ? DE_SUCCESS : rc_error(rc);
 }
@@ -601,6 +910,7 @@ int _sql_load_ndaxes(de_file de, ndtseries_t *ndtseries)
     CHECK_SQLITE(sqlite3_reset(stmt));
     CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, ndtseries->object.id));
     memset(ndtseries->axis, 0, sizeof ndtseries->axis);
+    ndtseries->naxes = 0;
     for (int n = 0; n < DE_MAX_AXES; ++n)
     {
         ndtseries->axis[n].id = -1;
@@ -649,6 +959,120 @@ int sql_load_ndtseries_value(de_file de, obj_id_t id, ndtseries_t *ndtseries)
     }
 }
 
+int sql_load_ndtseries_meta(de_file de, obj_id_t id, ndtseries_t *ndtseries)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_load_ndtseries_meta);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, id));
+    switch ((rc = sqlite3_step(stmt)))
+    {
+    case SQLITE_ROW:
+        ndtseries->object.id = sqlite3_column_int64(stmt, 0);
+        ndtseries->eltype = sqlite3_column_int(stmt, 1);
+        ndtseries->elfreq = sqlite3_column_int(stmt, 2);
+        ndtseries->nbytes = sqlite3_column_int64(stmt, 3);
+        ndtseries->value = NULL;
+        TRACE_RUN(_sql_load_ndaxes(de, ndtseries));
+        return DE_SUCCESS;
+    case SQLITE_DONE:
+        return error(DE_BAD_OBJ);
+    default:
+        return rc_error(rc);
+    }
+}
+
+/**************************************************************/
+/* chunks */
+
+int sql_store_chunk_layout(de_file de, obj_id_t id, int64_t elsize, int64_t ndims, const int64_t *chunk_shape)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_store_chunk_layout);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, id));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 2, elsize));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 3, ndims));
+    CHECK_SQLITE(sqlite3_bind_blob(stmt, 4, chunk_shape, ndims * sizeof(int64_t), SQLITE_TRANSIENT));
+    rc = sqlite3_step(stmt);
+    return rc == SQLITE_DONE ? DE_SUCCESS : rc_error(rc);
+}
+
+int sql_load_chunk_layout(de_file de, obj_id_t id, int64_t *elsize, int64_t *ndims, int64_t *chunk_shape)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_load_chunk_layout);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, id));
+    switch ((rc = sqlite3_step(stmt)))
+    {
+    case SQLITE_ROW:
+        *elsize = sqlite3_column_int64(stmt, 0);
+        *ndims = sqlite3_column_int64(stmt, 1);
+        if (*ndims < 0 || *ndims > DE_MAX_AXES ||
+            sqlite3_column_bytes(stmt, 2) != *ndims * (int64_t)sizeof(int64_t))
+            return error1(DE_BAD_OBJ, _id2str(id));
+        memcpy(chunk_shape, sqlite3_column_blob(stmt, 2), *ndims * sizeof(int64_t));
+        return DE_SUCCESS;
+    case SQLITE_DONE:
+        return error1(DE_OBJ_DNE, _id2str(id));
+    default:
+        return rc_error(rc);
+    }
+}
+
+int sql_store_chunk(de_file de, obj_id_t id, int64_t chunk_index, int64_t nbytes, const void *value, int64_t *rowid)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_store_chunk);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, id));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 2, chunk_index));
+    if (value == NULL)
+    {
+        CHECK_SQLITE(sqlite3_bind_zeroblob64(stmt, 3, nbytes));
+    }
+    else
+    {
+        CHECK_SQLITE(sqlite3_bind_blob64(stmt, 3, value, nbytes, SQLITE_TRANSIENT));
+    }
+    rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE)
+        return rc_error(rc);
+    if (rowid != NULL)
+        *rowid = sqlite3_last_insert_rowid(de->db);
+    return DE_SUCCESS;
+}
+
+int sql_find_chunk(de_file de, obj_id_t id, int64_t chunk_index, int64_t *rowid)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_find_chunk);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, id));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 2, chunk_index));
+    switch ((rc = sqlite3_step(stmt)))
+    {
+    case SQLITE_ROW:
+        *rowid = sqlite3_column_int64(stmt, 0);
+        return DE_SUCCESS;
+    case SQLITE_DONE:
+        return error1(DE_BAD_OBJ, _id2str(id));
+    default:
+        return rc_error(rc);
+    }
+}
+
 /**************************************************************/
 /* count */
 
@@ -667,3 +1091,335 @@ int sql_count_objects(de_file de, obj_id_t pid, int64_t *count)
     }
     return rc_error(rc);
 }
+
+/**************************************************************/
+/* calendars */
+
+int sql_new_calendar(de_file de, const char *name, date_t first, date_t last,
+                     int64_t nholidays, const date_t *holidays, calendar_id_t *id)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_new_calendar);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_text(stmt, 1, name, -1, SQLITE_TRANSIENT));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 2, first));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 3, last));
+    if (holidays != NULL && nholidays > 0)
+    {
+        CHECK_SQLITE(sqlite3_bind_blob64(stmt, 4, holidays, nholidays * sizeof(date_t), SQLITE_TRANSIENT));
+    }
+    else
+    {
+        CHECK_SQLITE(sqlite3_bind_null(stmt, 4));
+    }
+    switch ((rc = sqlite3_step(stmt)))
+    {
+    case SQLITE_DONE:
+        if (id != NULL)
+            *id = sqlite3_last_insert_rowid(de->db);
+        return DE_SUCCESS;
+    default:
+        return rc_error(rc);
+    }
+}
+
+int sql_find_calendar(de_file de, const char *name, calendar_id_t *id)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_find_calendar);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_text(stmt, 1, name, -1, SQLITE_TRANSIENT));
+    switch ((rc = sqlite3_step(stmt)))
+    {
+    case SQLITE_ROW:
+        if (id != NULL)
+            *id = sqlite3_column_int64(stmt, 0);
+        return DE_SUCCESS;
+    case SQLITE_DONE:
+        return error1(DE_OBJ_DNE, name);
+    default:
+        return rc_error(rc);
+    }
+}
+
+int sql_load_calendar(de_file de, calendar_id_t id, date_t *first, date_t *last,
+                      int64_t *nholidays, const date_t **holidays)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_load_calendar);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, id));
+    switch ((rc = sqlite3_step(stmt)))
+    {
+    case SQLITE_ROW:
+        *first = sqlite3_column_int64(stmt, 1);
+        *last = sqlite3_column_int64(stmt, 2);
+        *holidays = sqlite3_column_blob(stmt, 3);
+        *nholidays = sqlite3_column_bytes(stmt, 3) / sizeof(date_t);
+        return DE_SUCCESS;
+    case SQLITE_DONE:
+        return error1(DE_OBJ_DNE, _id2str(id));
+    default:
+        return rc_error(rc);
+    }
+}
+
+/**************************************************************/
+/* incremental blob I/O */
+
+int sql_reserve_value(de_file de, const char *table, obj_id_t id, int64_t nbytes)
+{
+    stmt_name_t stmt_name;
+    if (strcmp(table, "tseries") == 0)
+        stmt_name = stmt_reserve_tseries;
+    else if (strcmp(table, "mvtseries") == 0)
+        stmt_name = stmt_reserve_mvtseries;
+    else if (strcmp(table, "ndtseries") == 0)
+        stmt_name = stmt_reserve_ndtseries;
+    else
+        return error1(DE_INTERNAL, table);
+    sqlite3_stmt *stmt = _get_statement(de, stmt_name);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, nbytes));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 2, id));
+    rc = sqlite3_step(stmt);
+    return rc == SQLITE_DONE ? DE_SUCCESS : rc_error(rc);
+}
+
+/* the id of the shared blob holding the value of the given object, or 0 if
+   the value is in the object's own row */
+static int _find_value_blob(de_file de, const char *table, obj_id_t id, int64_t *blob_id)
+{
+    stmt_name_t stmt_name;
+    if (strcmp(table, "tseries") == 0)
+        stmt_name = stmt_find_tseries_blob;
+    else if (strcmp(table, "mvtseries") == 0)
+        stmt_name = stmt_find_mvtseries_blob;
+    else if (strcmp(table, "ndtseries") == 0)
+        stmt_name = stmt_find_ndtseries_blob;
+    else
+        return error1(DE_INTERNAL, table);
+    sqlite3_stmt *stmt = _get_statement(de, stmt_name);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, id));
+    switch ((rc = sqlite3_step(stmt)))
+    {
+    case SQLITE_ROW:
+        *blob_id = sqlite3_column_int64(stmt, 0);
+        return DE_SUCCESS;
+    case SQLITE_DONE:
+        return error1(DE_OBJ_DNE, _id2str(id));
+    default:
+        return rc_error(rc);
+    }
+}
+
+int sql_open_value_blob(de_file de, const char *table, obj_id_t id, bool write,
+                        sqlite3_blob **blob, bool *shared)
+{
+    int rc = SQLITE_ERROR;
+    if (*blob != NULL && (shared == NULL || !*shared))
+    {
+        if (SQLITE_OK == (rc = sqlite3_blob_reopen(*blob, id)))
+            return DE_SUCCESS;
+    }
+    /* a handle on `blobs`, or one whose reopen failed, can't be moved */
+    if (*blob != NULL)
+    {
+        sqlite3_blob_close(*blob);
+        *blob = NULL;
+    }
+    if (SQLITE_OK == (rc = sqlite3_blob_open(de->db, "main", table, "value", id, write, blob)))
+    {
+        if (shared != NULL)
+            *shared = false;
+        return DE_SUCCESS;
+    }
+    if (shared == NULL)
+        return db_error(de);
+    /* a shared value leaves the column in the object's row NULL */
+    int64_t blob_id = 0;
+    TRACE_RUN(_find_value_blob(de, table, id, &blob_id));
+    if (blob_id == 0)
+        return rc_error(rc);
+    if (write)
+        return error1(DE_INTERNAL, "shared values are read-only");
+    if (SQLITE_OK != sqlite3_blob_open(de->db, "main", "blobs", "value", blob_id, false, blob))
+        return db_error(de);
+    *shared = true;
+    return DE_SUCCESS;
+}
+
+int sql_read_value_blob(sqlite3_blob *blob, int64_t offset, int64_t nbytes, void *buffer)
+{
+    int rc;
+    if (offset < 0 || nbytes < 0 || offset + nbytes > sqlite3_blob_bytes(blob))
+        return error(DE_RANGE);
+    CHECK_SQLITE(sqlite3_blob_read(blob, buffer, (int)nbytes, (int)offset));
+    return DE_SUCCESS;
+}
+
+int sql_write_value_blob(sqlite3_blob *blob, int64_t offset, int64_t nbytes, const void *buffer)
+{
+    int rc;
+    if (offset < 0 || nbytes < 0 || offset + nbytes > sqlite3_blob_bytes(blob))
+        return error(DE_RANGE);
+    CHECK_SQLITE(sqlite3_blob_write(blob, buffer, (int)nbytes, (int)offset));
+    return DE_SUCCESS;
+}
+
+int sql_close_value_blob(sqlite3_blob *blob)
+{
+    int rc;
+    CHECK_SQLITE(sqlite3_blob_close(blob));
+    return DE_SUCCESS;
+}
+
+/**************************************************************/
+/* storage */
+
+int sql_storage_pages(de_file de, int64_t *page_size, int64_t *page_count, int64_t *free_pages, int *auto_vacuum)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_storage_pages);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    if (SQLITE_ROW != (rc = sqlite3_step(stmt)))
+        return rc_error(rc);
+    *page_size = sqlite3_column_int64(stmt, 0);
+    *page_count = sqlite3_column_int64(stmt, 1);
+    *free_pages = sqlite3_column_int64(stmt, 2);
+    *auto_vacuum = sqlite3_column_int(stmt, 3);
+    return DE_SUCCESS;
+}
+
+int sql_load_storage_tables(de_file de, sqlite3_stmt **stmt)
+{
+    *stmt = _get_statement(de, stmt_storage_tables);
+    if (*stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(*stmt));
+    return DE_SUCCESS;
+}
+
+int sql_next_storage_table(sqlite3_stmt *stmt, bool *found, const char **name, int64_t *nbytes, int64_t *unused)
+{
+    int rc;
+    switch ((rc = sqlite3_step(stmt)))
+    {
+    case SQLITE_ROW:
+        *found = true;
+        *name = (const char *)sqlite3_column_text(stmt, 0);
+        *nbytes = sqlite3_column_int64(stmt, 1);
+        *unused = sqlite3_column_int64(stmt, 2);
+        return DE_SUCCESS;
+    case SQLITE_DONE:
+        *found = false;
+        return DE_SUCCESS;
+    default:
+        return rc_error(rc);
+    }
+}
+
+/*****************************************************************************************/
+/* catalog stats */
+
+/* read the date coverage in columns `col` and `col + 1` */
+static void _fill_catalog_days(sqlite3_stmt *stmt, int col, catalog_stats_t *stats)
+{
+    stats->dated = (sqlite3_column_type(stmt, col) != SQLITE_NULL);
+    stats->first_day = stats->dated ? sqlite3_column_int64(stmt, col) : 0;
+    stats->last_day = stats->dated ? sqlite3_column_int64(stmt, col + 1) : 0;
+}
+
+int sql_load_catalog_stats(de_file de, obj_id_t id, catalog_stats_t *stats, bool *found, bool *stale)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_load_catalog_stats);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, id));
+    switch ((rc = sqlite3_step(stmt)))
+    {
+    case SQLITE_ROW:
+        stats->count = sqlite3_column_int64(stmt, 0);
+        stats->nbytes = sqlite3_column_int64(stmt, 1);
+        _fill_catalog_days(stmt, 2, stats);
+        *stale = sqlite3_column_int(stmt, 4) != 0;
+        *found = true;
+        return DE_SUCCESS;
+    case SQLITE_DONE:
+        *found = false;
+        return DE_SUCCESS;
+    default:
+        return rc_error(rc);
+    }
+}
+
+int sql_catalog_totals(de_file de, obj_id_t id, catalog_stats_t *stats)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_catalog_totals);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, id));
+    if (SQLITE_ROW != (rc = sqlite3_step(stmt)))
+        return rc_error(rc);
+    stats->count = sqlite3_column_int64(stmt, 0);
+    stats->nbytes = sqlite3_column_int64(stmt, 1);
+    _fill_catalog_days(stmt, 2, stats);
+    return DE_SUCCESS;
+}
+
+int sql_catalog_days(de_file de, obj_id_t id, catalog_stats_t *stats)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_catalog_days);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, id));
+    if (SQLITE_ROW != (rc = sqlite3_step(stmt)))
+        return rc_error(rc);
+    _fill_catalog_days(stmt, 0, stats);
+    return DE_SUCCESS;
+}
+
+int sql_store_catalog_days(de_file de, obj_id_t id, const catalog_stats_t *stats)
+{
+    sqlite3_stmt *stmt = _get_statement(de, stmt_store_catalog_days);
+    if (stmt == NULL)
+        return trace_error();
+    int rc;
+    CHECK_SQLITE(sqlite3_reset(stmt));
+    if (stats->dated)
+    {
+        CHECK_SQLITE(sqlite3_bind_int64(stmt, 1, stats->first_day));
+        CHECK_SQLITE(sqlite3_bind_int64(stmt, 2, stats->last_day));
+    }
+    else
+    {
+        CHECK_SQLITE(sqlite3_bind_null(stmt, 1));
+        CHECK_SQLITE(sqlite3_bind_null(stmt, 2));
+    }
+    CHECK_SQLITE(sqlite3_bind_int64(stmt, 3, id));
+    if (SQLITE_DONE != (rc = sqlite3_step(stmt)))
+        return rc_error(rc);
+    return DE_SUCCESS;
+}
@@ -10,6 +10,8 @@
 #include "tseries.h"
 #include "mvtseries.h"
 #include "ndtseries.h"
+#include "calendar.h"
+#include "catalog.h"
 
 /* ========================================================================= */
 /* internal */
@@ -19,18 +21,31 @@ void _fill_object(sqlite3_stmt *stmt, object_t *object);
 /* find the id of an object identified by its parent and its name */
 int sql_find_object(de_file de, obj_id_t pid, const char *name, obj_id_t *id);
 
-/* create a new object */
-int sql_new_object(de_file de, obj_id_t pid, class_t class, type_t type, const char *name);
+/* create a new object, whose id is returned in `id`. DE_EXISTS if the
+   catalog already has an object with that name */
+int sql_new_object(de_file de, obj_id_t pid, class_t class, type_t type, const char *name, obj_id_t *id);
 
 /* update insert objects_info for a new object */
 int sql_new_object_info(de_file de, obj_id_t id);
 
+/* insert objects_info for all objects from `from_id` on that don't have it */
+int sql_fill_object_info(de_file de, obj_id_t from_id);
+
 /* load object_t data for the given id */
 int sql_load_object(de_file de, obj_id_t id, object_t *object);
 
 /* delete an object from the database. If catalog, all children are also removed recursively.*/
 int sql_delete_object(de_file de, obj_id_t id);
 
+/* change the name of an object */
+int sql_rename_object(de_file de, obj_id_t id, const char *name);
+
+/* change the catalog of an object */
+int sql_move_object(de_file de, obj_id_t id, obj_id_t pid);
+
+/* rewrite objects_info for an object that was renamed or moved and everything under it */
+int sql_update_fullpaths(de_file de, obj_id_t id);
+
 /* write a row in the attributes table */
 int sql_set_attribute(de_file de, int64_t id, const char *name, const char *value);
 
@@ -61,17 +76,28 @@ int sql_new_axis(de_file de, axis_t *axis);
 /* load a row from the axes table with the given id */
 int sql_load_axis(de_file de, axis_id_t id, axis_t *axis);
 
+/* delete the rows of the axes table not referred to by any object or vintage */
+int sql_gc_axes(de_file de, int64_t *removed);
+
 /* create a new row in the `tseries` table for the given id and data */
 int sql_store_tseries_value(de_file de, obj_id_t id, type_t eltype, frequency_t elfreq, axis_id_t axis_id, int64_t nbytes, const void *value);
 
 /* load a row from the `tseries` table with the given id */
 int sql_load_tseries_value(de_file de, obj_id_t id, tseries_t *tseries);
 
+/* load a row from the `tseries` table together with its axis, without loading the value.
+   `nbytes` is set to the size of the value, but `value` is set to NULL */
+int sql_load_tseries_meta(de_file de, obj_id_t id, tseries_t *tseries);
+
 /* create a new row in the `mvtseries` table for the given id and data */
-int sql_store_mvtseries_value(de_file de, obj_id_t id, type_t eltype, frequency_t elfreq, axis_id_t axis1_id, axis_id_t axis2_id, int64_t nbytes, const void *value);
+int sql_store_mvtseries_value(de_file de, obj_id_t id, type_t eltype, frequency_t elfreq, axis_id_t axis1_id, axis_id_t axis2_id, order_t order, int64_t nbytes, const void *value);
+
+/* load a row from the mvtseries table with the given id. `order` may be NULL */
+int sql_load_mvtseries_value(de_file de, obj_id_t id, mvtseries_t *mvtseries, order_t *order);
 
-/* load a row from the mvtseries table with the given id */
-int sql_load_mvtseries_value(de_file de, obj_id_t id, mvtseries_t *mvtseries);
+/* load a row from the mvtseries table with the given id together with its axes, without loading the value.
+   `nbytes` is set to the size of the value, but `value` is set to NULL */
+int sql_load_mvtseries_meta(de_file de, obj_id_t id, mvtseries_t *mvtseries, order_t *order);
 
 /* count objects in a catalog */
 int sql_count_objects(de_file de, obj_id_t pid, int64_t *count);
@@ -84,4 +110,110 @@ int sql_store_ndaxes(de_file de, obj_id_t id, int64_t axis_index, axis_id_t axis
 /* load a row from the ndtseries table with the given id */
 int sql_load_ndtseries_value(de_file de, obj_id_t id, ndtseries_t *ndmvtseries);
 
+/* load a row from the ndtseries table with the given id together with its axes, without loading the value.
+   `nbytes` is set to the size of the value, but `value` is set to NULL */
+int sql_load_ndtseries_meta(de_file de, obj_id_t id, ndtseries_t *ndtseries);
+
+/* create a new row in the `chunk_layouts` table */
+int sql_store_chunk_layout(de_file de, obj_id_t id, int64_t elsize, int64_t ndims, const int64_t *chunk_shape);
+
+/* load the chunk layout of an object. Return DE_OBJ_DNE if the object is not stored in chunks */
+int sql_load_chunk_layout(de_file de, obj_id_t id, int64_t *elsize, int64_t *ndims, int64_t *chunk_shape);
+
+/* create a new row in the `chunks` table. If `value` is NULL, the chunk is
+   filled with `nbytes` zero bytes. `rowid` (may be NULL) receives the rowid of the new row */
+int sql_store_chunk(de_file de, obj_id_t id, int64_t chunk_index, int64_t nbytes, const void *value, int64_t *rowid);
+
+/* find the rowid of a chunk in the `chunks` table */
+int sql_find_chunk(de_file de, obj_id_t id, int64_t chunk_index, int64_t *rowid);
+
+/* create a new row in the `calendars` table */
+int sql_new_calendar(de_file de, const char *name, date_t first, date_t last, int64_t nholidays, const date_t *holidays, calendar_id_t *id);
+
+/* find the id of a calendar by its name */
+int sql_find_calendar(de_file de, const char *name, calendar_id_t *id);
+
+/* load a row from the `calendars` table. The memory for holidays is valid until the next library call */
+int sql_load_calendar(de_file de, calendar_id_t id, date_t *first, date_t *last, int64_t *nholidays, const date_t **holidays);
+
+/* set the `value` column of the given table (tseries, mvtseries or
+   ndtseries) in the row with the given id to `nbytes` zero bytes */
+int sql_reserve_value(de_file de, const char *table, obj_id_t id, int64_t nbytes);
+
+/* open a handle for incremental reading (or writing, if `write` is true) of
+   the `value` column of the given table in the row with the given id. If the
+   row refers to a shared value, the handle is opened on the `blobs` table
+   instead (for reading only) and `*shared` is set; `shared` may be NULL for
+   the `chunks` table, which has no shared values. If `*blob` is not NULL, it
+   must be a handle previously opened with the same table and `shared`; it is
+   moved to the new row when possible. */
+int sql_open_value_blob(de_file de, const char *table, obj_id_t id, bool write,
+                        sqlite3_blob **blob, bool *shared);
+
+/* replace the axis and the value of a tseries */
+int sql_update_tseries_value(de_file de, obj_id_t id, axis_id_t axis_id, int64_t nbytes, const void *value);
+
+/* create a new row in the `vintages` table */
+int sql_store_vintage(de_file de, obj_id_t id, int64_t timestamp, axis_id_t axis_id,
+                      bool snapshot, int64_t nbytes, const void *value);
+
+/* find the timestamp of the last vintage of an object and the number of
+   vintages since the last snapshot, including both. `*count` is 0 if the
+   object has no vintages. */
+int sql_last_vintage(de_file de, obj_id_t id, int64_t *timestamp, int64_t *count);
+
+/* start loading the vintages of an object needed to rebuild the one in effect
+   at `timestamp`: the last snapshot at or before `timestamp` and the deltas
+   after it. The rows are then read with sql_next_vintage. */
+int sql_load_vintages(de_file de, obj_id_t id, int64_t timestamp, sqlite3_stmt **stmt);
+
+/* read the next row started with sql_load_vintages. `*found` is false after
+   the last row. The memory of `value` is valid until the next row is read. */
+int sql_next_vintage(sqlite3_stmt *stmt, bool *found, axis_id_t *axis_id, bool *snapshot,
+                     int64_t *nbytes, const void **value);
+
+/* find the blob with the given content in the `blobs` table, adding it if
+   it isn't there, and return its id */
+int sql_store_blob(de_file de, int64_t nbytes, const void *value, int64_t *blob_id);
+
+/* count the rows of the `blobs` table, their bytes and their references */
+int sql_blob_stats(de_file de, int64_t *nblobs, int64_t *nbytes, int64_t *nrefs);
+
+/* read `nbytes` bytes starting at `offset` from an open blob handle */
+int sql_read_value_blob(sqlite3_blob *blob, int64_t offset, int64_t nbytes, void *buffer);
+
+/* write `nbytes` bytes starting at `offset` into a blob handle open for writing */
+int sql_write_value_blob(sqlite3_blob *blob, int64_t offset, int64_t nbytes, const void *buffer);
+
+/* close a blob handle opened with sql_open_value_blob */
+int sql_close_value_blob(sqlite3_blob *blob);
+
+/* the size of the pages of the file, their number, the number of those not
+   in use and the auto_vacuum setting */
+int sql_storage_pages(de_file de, int64_t *page_size, int64_t *page_count, int64_t *free_pages, int *auto_vacuum);
+
+/* start reading the bytes used by each table and index of the file, which
+   are then read with sql_next_storage_table */
+int sql_load_storage_tables(de_file de, sqlite3_stmt **stmt);
+
+/* read the next row started with sql_load_storage_tables. `*found` is false
+   after the last row. The memory of `name` is valid until the next row is read. */
+int sql_next_storage_table(sqlite3_stmt *stmt, bool *found, const char **name, int64_t *nbytes, int64_t *unused);
+
+/* catalog stats */
+
+/* the statistics kept for catalog `id`. `*found` is false if there are
+   none. `*stale` is true if its date coverage may be wider than that of the
+   objects under it */
+int sql_load_catalog_stats(de_file de, obj_id_t id, catalog_stats_t *stats, bool *found, bool *stale);
+
+/* compute the statistics of the objects under catalog `id` */
+int sql_catalog_totals(de_file de, obj_id_t id, catalog_stats_t *stats);
+
+/* compute the date coverage of the objects under catalog `id` */
+int sql_catalog_days(de_file de, obj_id_t id, catalog_stats_t *stats);
+
+/* save the date coverage of catalog `id`, which is no longer stale */
+int sql_store_catalog_days(de_file de, obj_id_t id, const catalog_stats_t *stats);
+
 #endif
@@ -0,0 +1,121 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <sqlite3.h>
+
+#include "error.h"
+#include "file.h"
+#include "storage.h"
+#include "sql.h"
+
+/* round up to a multiple of the size of an int64 */
+#define _ALIGN(n) (((n) + sizeof(int64_t) - 1) / sizeof(int64_t) * sizeof(int64_t))
+
+int de_storage_stats(de_file de, storage_stats_t *stats)
+{
+    if (de == NULL || stats == NULL)
+        return error(DE_NULL);
+    TRACE_RUN(sql_storage_pages(de, &stats->page_size, &stats->page_count,
+                                &stats->free_pages, &stats->auto_vacuum));
+
+    /* the names go into scratch memory as they are read, followed by the
+       table of results, once we know its size */
+    sqlite3_stmt *stmt;
+    TRACE_RUN(sql_load_storage_tables(de, &stmt));
+    int64_t ntables = 0, used = 0;
+    char *buf;
+    while (1)
+    {
+        bool found;
+        const char *name;
+        int64_t nbytes, unused;
+        TRACE_RUN(sql_next_storage_table(stmt, &found, &name, &nbytes, &unused));
+        if (!found)
+            break;
+        const int64_t len = strlen(name) + 1;
+        if (NULL == (buf = _get_scratch(de, used + _ALIGN(2 * sizeof(int64_t) + len))))
+            return trace_error();
+        memcpy(buf + used, &nbytes, sizeof(int64_t));
+        memcpy(buf + used + sizeof(int64_t), &unused, sizeof(int64_t));
+        memcpy(buf + used + 2 * sizeof(int64_t), name, len);
+        used += _ALIGN(2 * sizeof(int64_t) + len);
+        ++ntables;
+    }
+    if (NULL == (buf = _get_scratch(de, used + ntables * sizeof(table_storage_t) + 1)))
+        return trace_error();
+    table_storage_t *tables = (table_storage_t *)(buf + used);
+    for (int64_t i = 0, pos = 0; i < ntables; ++i)
+    {
+        memcpy(&tables[i].nbytes, buf + pos, sizeof(int64_t));
+        memcpy(&tables[i].unused, buf + pos + sizeof(int64_t), sizeof(int64_t));
+        tables[i].name = buf + pos + 2 * sizeof(int64_t);
+        pos += _ALIGN(2 * sizeof(int64_t) + strlen(tables[i].name) + 1);
+    }
+    stats->ntables = ntables;
+    stats->tables = tables;
+    return DE_SUCCESS;
+}
+
+/* run `sql`, which rebuilds the file in a temporary copy, with the copy
+   on disk */
+static int _vacuum(de_file de, const char *sql)
+{
+    TRACE_RUN(_temp_store_file(de, true));
+    int rc = DE_SUCCESS;
+    if (SQLITE_OK != sqlite3_exec(de->db, sql, NULL, NULL, NULL))
+        rc = db_error(de);
+    if (DE_SUCCESS != _temp_store_file(de, false) && rc == DE_SUCCESS)
+        rc = trace_error();
+    return rc;
+}
+
+int de_compact(de_file de, compact_mode_t mode, const char *fname)
+{
+    if (de == NULL)
+        return error(DE_NULL);
+    if (mode == compact_into && fname == NULL)
+        return error(DE_NULL);
+    if (mode != compact_full && mode != compact_into && mode != compact_incremental)
+        return error1(DE_ARG, "unknown compact mode");
+
+    /* VACUUM fails inside transactions and while statements are in progress */
+    TRACE_RUN(de_commit(de));
+    _reset_stmts(de);
+    int rc = SQLITE_OK;
+    switch (mode)
+    {
+    case compact_full:
+        TRACE_RUN(_vacuum(de, "VACUUM;"));
+        break;
+    case compact_into:
+    {
+        sqlite3_stmt *stmt;
+        if (SQLITE_OK == (rc = sqlite3_prepare_v2(de->db, "VACUUM INTO ?;", -1, &stmt, NULL)))
+        {
+            if (SQLITE_OK == (rc = sqlite3_bind_text(stmt, 1, fname, -1, SQLITE_STATIC)) &&
+                SQLITE_DONE == (rc = sqlite3_step(stmt)))
+                rc = SQLITE_OK;
+            sqlite3_finalize(stmt);
+        }
+        break;
+    }
+    case compact_incremental:
+    {
+        int64_t page_size, page_count, free_pages;
+        int auto_vacuum;
+        TRACE_RUN(sql_storage_pages(de, &page_size, &page_count, &free_pages, &auto_vacuum));
+        _reset_stmts(de);
+        if (auto_vacuum == 2)
+            rc = sqlite3_exec(de->db, "PRAGMA incremental_vacuum;", NULL, NULL, NULL);
+        else
+        {
+            TRACE_RUN(_vacuum(de, "PRAGMA auto_vacuum = INCREMENTAL; VACUUM;"));
+        }
+        break;
+    }
+    }
+    if (rc != SQLITE_OK)
+        return db_error(de);
+    return DE_SUCCESS;
+}
@@ -0,0 +1,57 @@
+#ifndef __STORAGE_H__
+#define __STORAGE_H__
+
+#include <stdint.h>
+
+#include "file.h"
+
+/* ========================================================================= */
+/* API */
+
+/* space used by one table or index of a file */
+typedef struct
+{
+    const char *name; /* name of the table or index */
+    int64_t nbytes;   /* size of its pages */
+    int64_t unused;   /* bytes not in use within its pages */
+} table_storage_t;
+
+/* how the file uses its pages */
+typedef struct
+{
+    int64_t page_size;       /* size of a page in bytes */
+    int64_t page_count;      /* number of pages in the file */
+    int64_t free_pages;      /* pages not in use, which de_compact gives back */
+    int auto_vacuum;         /* 0: off, 1: full, 2: incremental (see compact_incremental) */
+    int64_t ntables;         /* number of tables and indexes in `tables` */
+    table_storage_t *tables; /* in the order of their names */
+} storage_stats_t;
+
+/* report the space used by the file. The memory of the tables is managed by
+   the library and is valid until the next library call. */
+int de_storage_stats(de_file de, storage_stats_t *stats);
+
+typedef enum
+{
+    compact_full = 0,    /* rebuild the file, which drops the free pages and defragments the rest */
+    compact_into,        /* write a compacted copy to a new file, leaving this one as it is */
+    compact_incremental, /* give back the free pages, without moving the rest */
+} compact_mode_t;
+
+/*
+    give back the space that is not in use in a file.
+    NOTES:
+    * pending changes are committed first.
+    * compact_full and compact_into take time and temporary space that grow
+      with the size of the file. For compact_into, `fname` must be the name
+      of a new file (it is ignored in the other modes).
+    * compact_incremental is fast when auto_vacuum is incremental: it only
+      truncates the file. Otherwise, it turns incremental auto_vacuum on,
+      which takes a full rebuild this one time.
+*/
+int de_compact(de_file de, compact_mode_t mode, const char *fname);
+
+/* ========================================================================= */
+/* internal */
+
+#endif
@@ -0,0 +1,477 @@
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <sqlite3.h>
+
+#include "config.h"
+#include "error.h"
+#include "file.h"
+#include "object.h"
+#include "axis.h"
+#include "tseries.h"
+#include "mvtseries.h"
+#include "ndtseries.h"
+#include "hyperslab.h"
+#include "stream.h"
+#include "convert.h"
+#include "sql.h"
+
+/* largest value that fits in one row */
+static int64_t _max_value_bytes(de_file de)
+{
+    return sqlite3_limit(de->db, SQLITE_LIMIT_LENGTH, -1);
+}
+
+/* decide how the value of an array object is stored by the writer. Data
+   arrives in column-major order, so chunks must be whole slices along the
+   last axis; then each chunk holds a contiguous range of bytes. */
+static int _plan_array(de_file de, const char *table, type_t eltype, int64_t ndims, const int64_t *dims,
+                       const int64_t *chunk_shape, int64_t nbytes,
+                       array_layout_t *layout, int64_t *chunk_bytes)
+{
+    const int64_t max_bytes = _max_value_bytes(de);
+    int64_t shape[DE_MAX_AXES];
+    if (chunk_shape == NULL)
+    {
+        if (nbytes <= max_bytes)
+        {
+            int64_t nelem = 1;
+            for (int64_t k = 0; k < ndims; ++k)
+            {
+                layout->dims[k] = layout->chunk[k] = dims[k];
+                nelem *= dims[k];
+            }
+            layout->id = 0;
+            layout->table = table;
+            layout->eltype = eltype;
+            layout->chunked = false;
+            layout->ndims = ndims;
+            layout->elsize = (nelem > 0) ? nbytes / nelem : 0;
+            *chunk_bytes = nbytes;
+            return DE_SUCCESS;
+        }
+        /* leave room for the rest of the row */
+        const int64_t target = (DE_STREAM_CHUNK_BYTES < max_bytes / 2) ? DE_STREAM_CHUNK_BYTES : max_bytes / 2;
+        const int64_t slice = (dims[ndims - 1] > 0) ? nbytes / dims[ndims - 1] : nbytes;
+        for (int64_t k = 0; k < ndims - 1; ++k)
+            shape[k] = dims[k];
+        shape[ndims - 1] = (0 < slice && slice < target) ? target / slice : 1;
+        chunk_shape = shape;
+    }
+    TRACE_RUN(_init_chunked_layout(table, eltype, ndims, dims, chunk_shape, nbytes, layout));
+    *chunk_bytes = layout->elsize;
+    for (int64_t k = 0; k < ndims; ++k)
+    {
+        if (k < ndims - 1 && layout->chunk[k] < dims[k])
+            return error(DE_ARG);
+        *chunk_bytes *= layout->chunk[k];
+    }
+    if (*chunk_bytes > max_bytes)
+        return error(DE_RANGE);
+    return DE_SUCCESS;
+}
+
+/* the size of the elements whose bytes are swapped on the way to or from
+   the file, or 0 if the byte order of the file is that of the host or the
+   elements are not numbers */
+static int64_t _swap_size(de_file de, type_t eltype, int64_t elsize)
+{
+    if (!de->swap || elsize < 2)
+        return 0;
+    switch (eltype)
+    {
+    case type_signed:
+    case type_unsigned:
+    case type_date:
+    case type_float:
+    case type_complex:
+        return elsize;
+    default:
+        return 0;
+    }
+}
+
+static de_writer _new_writer(de_file de, const char *table, int64_t nbytes,
+                             const array_layout_t *layout, int64_t chunk_bytes)
+{
+    de_writer writer = calloc(1, sizeof(de_writer_t));
+    if (writer == NULL)
+    {
+        error(DE_ERR_ALLOC);
+        return NULL;
+    }
+    writer->de = de;
+    writer->table = table;
+    /* a chunked object with no elements has no chunks to write */
+    writer->chunked = layout != NULL && layout->chunked && nbytes > 0;
+    writer->nbytes = nbytes;
+    writer->chunk_bytes = writer->chunked ? chunk_bytes : nbytes;
+    writer->eltype = layout->eltype;
+    writer->swap_size = _swap_size(de, layout->eltype, layout->elsize);
+    return writer;
+}
+
+/* make room for the value of the object just created */
+static int _start_writer(de_writer writer, obj_id_t id, const array_layout_t *layout)
+{
+    writer->id = id;
+    if (writer->chunked)
+    {
+        TRACE_RUN(sql_store_chunk_layout(writer->de, id, layout->elsize, layout->ndims, layout->chunk));
+    }
+    else if (writer->nbytes > 0)
+    {
+        TRACE_RUN(sql_reserve_value(writer->de, writer->table, id, writer->nbytes));
+    }
+    return DE_SUCCESS;
+}
+
+int de_open_tseries_writer(de_file de, obj_id_t pid, const char *name, type_t obj_type,
+                           type_t eltype, frequency_t elfreq,
+                           axis_id_t axis_id, int64_t nbytes,
+                           obj_id_t *id, de_writer *writer)
+{
+    if (de == NULL || writer == NULL)
+        return error(DE_NULL);
+    if (nbytes < 0)
+        return error(DE_RANGE);
+    axis_t axis;
+    TRACE_RUN(sql_load_axis(de, axis_id, &axis));
+    array_layout_t layout;
+    int64_t chunk_bytes = 0;
+    TRACE_RUN(_plan_array(de, "tseries", eltype, 1, &axis.length, NULL, nbytes, &layout, &chunk_bytes));
+    de_writer w = _new_writer(de, "tseries", nbytes, &layout, chunk_bytes);
+    if (w == NULL)
+        return trace_error();
+    obj_id_t _id;
+    if (DE_SUCCESS != de_store_tseries(de, pid, name, obj_type, eltype, elfreq, axis_id, 0, NULL, &_id) ||
+        DE_SUCCESS != _start_writer(w, _id, &layout))
+    {
+        free(w);
+        return trace_error();
+    }
+    if (id != NULL)
+        *id = _id;
+    *writer = w;
+    return DE_SUCCESS;
+}
+
+int de_open_mvtseries_writer(de_file de, obj_id_t pid, const char *name, type_t obj_type,
+                             type_t eltype, frequency_t elfreq,
+                             axis_id_t axis1_id, axis_id_t axis2_id,
+                             const int64_t *chunk_shape, int64_t nbytes,
+                             obj_id_t *id, de_writer *writer)
+{
+    if (de == NULL || writer == NULL)
+        return error(DE_NULL);
+    if (nbytes < 0)
+        return error(DE_RANGE);
+    axis_t axis1, axis2;
+    TRACE_RUN(sql_load_axis(de, axis1_id, &axis1));
+    TRACE_RUN(sql_load_axis(de, axis2_id, &axis2));
+    const int64_t dims[2] = {axis1.length, axis2.length};
+    array_layout_t layout;
+    int64_t chunk_bytes = 0;
+    TRACE_RUN(_plan_array(de, "mvtseries", eltype, 2, dims, chunk_shape, nbytes, &layout, &chunk_bytes));
+    de_writer w = _new_writer(de, "mvtseries", nbytes, &layout, chunk_bytes);
+    if (w == NULL)
+        return trace_error();
+    obj_id_t _id;
+    if (DE_SUCCESS != de_store_mvtseries(de, pid, name, obj_type, eltype, elfreq,
+                                         axis1_id, axis2_id, 0, NULL, &_id) ||
+        DE_SUCCESS != _start_writer(w, _id, &layout))
+    {
+        free(w);
+        return trace_error();
+    }
+    if (id != NULL)
+        *id = _id;
+    *writer = w;
+    return DE_SUCCESS;
+}
+
+int de_open_ndtseries_writer(de_file de, obj_id_t pid, const char *name, type_t obj_type,
+                             type_t eltype, frequency_t elfreq,
+                             int64_t naxes, const axis_id_t *axis_ids,
+                             const int64_t *chunk_shape, int64_t nbytes,
+                             obj_id_t *id, de_writer *writer)
+{
+    if (de == NULL || axis_ids == NULL || writer == NULL)
+        return error(DE_NULL);
+    if (nbytes < 0)
+        return error(DE_RANGE);
+    if ((naxes < 1) || (naxes > DE_MAX_AXES))
+        return error(DE_BAD_NUM_AXES);
+    int64_t dims[DE_MAX_AXES];
+    for (int64_t n = 0; n < naxes; ++n)
+    {
+        axis_t axis;
+        TRACE_RUN(sql_load_axis(de, axis_ids[n], &axis));
+        dims[n] = axis.length;
+    }
+    array_layout_t layout;
+    int64_t chunk_bytes = 0;
+    TRACE_RUN(_plan_array(de, "ndtseries", eltype, naxes, dims, chunk_shape, nbytes, &layout, &chunk_bytes));
+    de_writer w = _new_writer(de, "ndtseries", nbytes, &layout, chunk_bytes);
+    if (w == NULL)
+        return trace_error();
+    obj_id_t _id;
+    if (DE_SUCCESS != de_store_ndtseries(de, pid, name, obj_type, eltype, elfreq,
+                                         naxes, axis_ids, 0, NULL, &_id) ||
+        DE_SUCCESS != _start_writer(w, _id, &layout))
+    {
+        free(w);
+        return trace_error();
+    }
+    if (id != NULL)
+        *id = _id;
+    *writer = w;
+    return DE_SUCCESS;
+}
+
+/* open the blob of the piece (the value or a chunk) that starts at the current offset */
+static int _open_piece(de_writer writer)
+{
+    if (!writer->chunked)
+        return sql_open_value_blob(writer->de, writer->table, writer->id, true, &writer->blob, NULL);
+    const int64_t chunk_index = writer->offset / writer->chunk_bytes;
+    const int64_t remaining = writer->nbytes - writer->offset;
+    const int64_t size = (remaining < writer->chunk_bytes) ? remaining : writer->chunk_bytes;
+    int64_t rowid;
+    TRACE_RUN(sql_store_chunk(writer->de, writer->id, chunk_index, size, NULL, &rowid));
+    TRACE_RUN(sql_open_value_blob(writer->de, "chunks", rowid, true, &writer->blob, NULL));
+    return DE_SUCCESS;
+}
+
+int de_write_next(de_writer writer, int64_t nbytes, const void *buffer)
+{
+    if (writer == NULL || (buffer == NULL && nbytes > 0))
+        return error(DE_NULL);
+    if (nbytes < 0 || nbytes > writer->nbytes - writer->offset)
+        return error(DE_RANGE);
+    const char *src = buffer;
+    if (writer->swap_size > 0 && nbytes > 0)
+    {
+        if (nbytes % writer->swap_size != 0)
+            return error1(DE_ARG, "the bytes of the elements are swapped, so pieces must hold whole elements");
+        char *buf = _get_scratch(writer->de, nbytes);
+        if (buf == NULL)
+            return trace_error();
+        _swap_elements(writer->eltype, writer->swap_size, nbytes, src, buf);
+        src = buf;
+    }
+    while (nbytes > 0)
+    {
+        const int64_t pos = writer->offset % writer->chunk_bytes;
+        if (pos == 0)
+            TRACE_RUN(_open_piece(writer));
+        const int64_t n = (nbytes < writer->chunk_bytes - pos) ? nbytes : writer->chunk_bytes - pos;
+        TRACE_RUN(sql_write_value_blob(writer->blob, pos, n, src));
+        src += n;
+        nbytes -= n;
+        writer->offset += n;
+    }
+    return DE_SUCCESS;
+}
+
+int de_close_writer(de_writer writer)
+{
+    if (writer == NULL)
+        return DE_SUCCESS;
+    int rc = DE_SUCCESS;
+    if (writer->blob != NULL)
+        rc = sql_close_value_blob(writer->blob);
+    const bool complete = writer->offset == writer->nbytes;
+    free(writer);
+    if (rc != DE_SUCCESS)
+        return trace_error();
+    if (!complete)
+        return error1(DE_ARG, "value not written completely");
+    return DE_SUCCESS;
+}
+
+/* find where the value of an object is and how big it is */
+static int _init_reader(de_reader reader, obj_id_t id)
+{
+    de_file de = reader->de;
+    array_layout_t *layout = &reader->layout;
+    object_t object;
+    TRACE_RUN(sql_load_object(de, id, &object));
+    int64_t ndims = 0, nbytes = 0, dims[DE_MAX_AXES];
+    const char *table;
+    type_t eltype;
+    switch (object.obj_class)
+    {
+    case class_tseries:
+    {
+        tseries_t tseries;
+        TRACE_RUN(sql_load_tseries_meta(de, id, &tseries));
+        table = "tseries";
+        eltype = tseries.eltype;
+        nbytes = tseries.nbytes;
+        ndims = 1;
+        dims[0] = tseries.axis.length;
+        break;
+    }
+    case class_mvtseries:
+    {
+        mvtseries_t mvtseries;
+        TRACE_RUN(sql_load_mvtseries_meta(de, id, &mvtseries, NULL));
+        table = "mvtseries";
+        eltype = mvtseries.eltype;
+        nbytes = mvtseries.nbytes;
+        ndims = 2;
+        dims[0] = mvtseries.axis1.length;
+        dims[1] = mvtseries.axis2.length;
+        break;
+    }
+    case class_ndtseries:
+    {
+        ndtseries_t ndtseries;
+        TRACE_RUN(sql_load_ndtseries_meta(de, id, &ndtseries));
+        table = "ndtseries";
+        eltype = ndtseries.eltype;
+        nbytes = ndtseries.nbytes;
+        ndims = ndtseries.naxes;
+        for (int64_t k = 0; k < ndims; ++k)
+            dims[k] = ndtseries.axis[k].length;
+        break;
+    }
+    default:
+        return error(DE_BAD_CLASS);
+    }
+    if (nbytes > 0 || ndims == 0)
+    {
+        /* the value is in one piece */
+        int64_t nelem = 1;
+        for (int64_t k = 0; k < ndims; ++k)
+            nelem *= dims[k];
+        layout->id = id;
+        layout->table = table;
+        layout->eltype = eltype;
+        layout->chunked = false;
+        reader->nbytes = reader->piece_bytes = nbytes;
+        reader->swap_size = _swap_size(de, eltype, (nelem > 0) ? nbytes / nelem : 0);
+        return DE_SUCCESS;
+    }
+    TRACE_RUN(_init_layout(de, id, table, eltype, ndims, dims, nbytes, layout));
+    reader->swap_size = _swap_size(de, eltype, layout->elsize);
+    if (!layout->chunked)
+        return DE_SUCCESS;
+    reader->nbytes = layout->elsize;
+    reader->piece_bytes = layout->elsize;
+    for (int64_t k = 0; k < ndims; ++k)
+    {
+        reader->nbytes *= dims[k];
+        if (k < ndims - 1)
+        {
+            reader->gather = reader->gather || layout->chunk[k] < dims[k];
+            reader->piece_bytes *= dims[k];
+        }
+    }
+    if (!reader->gather)
+        reader->piece_bytes *= layout->chunk[ndims - 1];
+    else if (reader->nbytes > 0)
+    {
+        reader->buffer = malloc(reader->piece_bytes);
+        if (reader->buffer == NULL)
+            return error(DE_ERR_ALLOC);
+    }
+    return DE_SUCCESS;
+}
+
+int de_open_reader(de_file de, obj_id_t id, int64_t *nbytes, de_reader *reader)
+{
+    if (de == NULL || reader == NULL)
+        return error(DE_NULL);
+    de_reader r = calloc(1, sizeof(de_reader_t));
+    if (r == NULL)
+        return error(DE_ERR_ALLOC);
+    r->de = de;
+    if (DE_SUCCESS != _init_reader(r, id))
+    {
+        de_close_reader(r);
+        return trace_error();
+    }
+    if (nbytes != NULL)
+        *nbytes = r->nbytes;
+    *reader = r;
+    return DE_SUCCESS;
+}
+
+/* make the piece with the given index ready for reading */
+static int _load_piece(de_reader reader, int64_t index)
+{
+    const array_layout_t *layout = &reader->layout;
+    if (!layout->chunked)
+        return sql_open_value_blob(reader->de, layout->table, layout->id, false, &reader->blob, &reader->shared);
+    if (!reader->gather)
+    {
+        int64_t rowid;
+        TRACE_RUN(sql_find_chunk(reader->de, layout->id, index, &rowid));
+        TRACE_RUN(sql_open_value_blob(reader->de, "chunks", rowid, false, &reader->blob, NULL));
+        return DE_SUCCESS;
+    }
+    /* slice `index` along the last axis */
+    int64_t start[DE_MAX_AXES], count[DE_MAX_AXES];
+    for (int64_t k = 0; k < layout->ndims; ++k)
+    {
+        start[k] = 0;
+        count[k] = layout->dims[k];
+    }
+    start[layout->ndims - 1] = index;
+    count[layout->ndims - 1] = 1;
+    TRACE_RUN(_read_hyperslab(reader->de, layout, start, count, NULL, reader->buffer));
+    return DE_SUCCESS;
+}
+
+int de_read_next(de_reader reader, int64_t *nbytes, void *buffer)
+{
+    if (reader == NULL || nbytes == NULL || (buffer == NULL && *nbytes > 0))
+        return error(DE_NULL);
+    if (*nbytes < 0)
+        return error(DE_ARG);
+    if (reader->swap_size > 0 && *nbytes % reader->swap_size != 0)
+        return error1(DE_ARG, "the bytes of the elements are swapped, so pieces must hold whole elements");
+    const int64_t remaining = reader->nbytes - reader->offset;
+    const int64_t want = (*nbytes < remaining) ? *nbytes : remaining;
+    char *dst = buffer;
+    int64_t done = 0;
+    while (done < want)
+    {
+        const int64_t index = reader->offset / reader->piece_bytes;
+        const int64_t pos = reader->offset % reader->piece_bytes;
+        if (pos == 0)
+            TRACE_RUN(_load_piece(reader, index));
+        const int64_t left = reader->nbytes - index * reader->piece_bytes;
+        const int64_t size = (left < reader->piece_bytes) ? left : reader->piece_bytes;
+        const int64_t n = (want - done < size - pos) ? want - done : size - pos;
+        if (reader->gather)
+            memcpy(dst + done, reader->buffer + pos, n);
+        else
+            TRACE_RUN(sql_read_value_blob(reader->blob, pos, n, dst + done));
+        done += n;
+        reader->offset += n;
+    }
+    if (reader->swap_size > 0)
+        _swap_elements(reader->layout.eltype, reader->swap_size, done, buffer, buffer);
+    *nbytes = done;
+    return DE_SUCCESS;
+}
+
+int de_close_reader(de_reader reader)
+{
+    if (reader == NULL)
+        return DE_SUCCESS;
+    int rc = DE_SUCCESS;
+    if (reader->blob != NULL)
+        rc = sql_close_value_blob(reader->blob);
+    free(reader->buffer);
+    free(reader);
+    if (rc != DE_SUCCESS)
+        return trace_error();
+    return DE_SUCCESS;
+}
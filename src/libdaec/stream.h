@@ -0,0 +1,136 @@
+#ifndef __STREAM_H__
+#define __STREAM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <sqlite3.h>
+
+#include "config.h"
+#include "file.h"
+#include "object.h"
+#include "axis.h"
+#include "hyperslab.h"
+
+/* ========================================================================= */
+/* API */
+
+struct de_writer_s;
+typedef struct de_writer_s de_writer_t;
+typedef de_writer_t *de_writer;
+
+/*
+    create a new 1d-array object and open a writer for its value, which is
+    then written in pieces with de_write_next.
+    NOTES:
+    * the object is created right away with `nbytes` zero bytes as its value.
+      The pieces given to de_write_next go directly into the file, so the
+      memory used does not depend on the size of the value.
+    * the writer must be closed with de_close_writer before anything else is
+      changed in the file and before the file is closed.
+    * a value larger than fits in one row of the file (1 GB, unless SQLite was
+      compiled with a different SQLITE_MAX_LENGTH) is split into chunks, as in
+      de_open_mvtseries_writer. Vintages can't be appended to such an object.
+*/
+int de_open_tseries_writer(de_file de, obj_id_t pid, const char *name, type_t obj_type,
+                           type_t eltype, frequency_t elfreq,
+                           axis_id_t axis_id, int64_t nbytes,
+                           obj_id_t *id, de_writer *writer);
+
+/* same as de_open_tseries_writer, for a 2d-array object in column-major
+   order. If `chunk_shape` is NULL, the value is stored in one piece when it
+   fits in the file and is otherwise split into chunks of whole columns. If
+   `chunk_shape` is given (see de_store_mvtseries_chunked), its chunks must
+   span all of axis1, otherwise we return DE_ARG. */
+int de_open_mvtseries_writer(de_file de, obj_id_t pid, const char *name, type_t obj_type,
+                             type_t eltype, frequency_t elfreq,
+                             axis_id_t axis1_id, axis_id_t axis2_id,
+                             const int64_t *chunk_shape, int64_t nbytes,
+                             obj_id_t *id, de_writer *writer);
+
+/* same as de_open_mvtseries_writer, for a Nd-array object. Chunks must span
+   all axes except the last one. */
+int de_open_ndtseries_writer(de_file de, obj_id_t pid, const char *name, type_t obj_type,
+                             type_t eltype, frequency_t elfreq,
+                             int64_t naxes, const axis_id_t *axis_ids,
+                             const int64_t *chunk_shape, int64_t nbytes,
+                             obj_id_t *id, de_writer *writer);
+
+/* write the next `nbytes` bytes of the value. Return DE_RANGE if this goes
+   past the size given when the writer was opened. If the byte order of the
+   file is not that of the host, the elements are swapped on their way to
+   the file, and `nbytes` must be a multiple of their size (DE_ARG). */
+int de_write_next(de_writer writer, int64_t nbytes, const void *buffer);
+
+/* release the resources of a writer. Return DE_ARG if fewer bytes were
+   written than the size given when it was opened; the rest of the value
+   remains zero. */
+int de_close_writer(de_writer writer);
+
+struct de_reader_s;
+typedef struct de_reader_s de_reader_t;
+typedef de_reader_t *de_reader;
+
+/*
+    open a reader for the value of a tseries, mvtseries or ndtseries object,
+    which is then read in pieces with de_read_next.
+    NOTES:
+    * `nbytes` (may be NULL) receives the size of the value.
+    * the bytes come in the order in which they are stored (see
+      de_get_mvtseries_order). Chunked values are reassembled in column-major
+      order.
+    * the value is read directly from the file, one piece at a time, so the
+      memory used does not depend on the size of the value. The file must not
+      be modified while the reader is open.
+    * the elements are in the byte order of the host, as with the other ways
+      to load a value (see de_set_byte_order).
+*/
+int de_open_reader(de_file de, obj_id_t id, int64_t *nbytes, de_reader *reader);
+
+/* read the next bytes of the value. On entry `*nbytes` is the size of
+   `buffer`. On exit it is the number of bytes written in `buffer`, which is
+   less than the size of `buffer` only at the end of the value and 0 after
+   the value has been read completely. If the byte order of the file is not
+   that of the host, the size of `buffer` must be a multiple of the size of
+   the elements (DE_ARG). */
+int de_read_next(de_reader reader, int64_t *nbytes, void *buffer);
+
+/* release the resources of a reader. */
+int de_close_reader(de_reader reader);
+
+/* ========================================================================= */
+/* internal */
+
+/* size of the chunks chosen by the writers when the value doesn't fit in one piece */
+#define DE_STREAM_CHUNK_BYTES ((int64_t)64 << 20)
+
+struct de_writer_s
+{
+    de_file de;
+    obj_id_t id;
+    const char *table;   /* table whose `value` column holds the data when not chunked */
+    bool chunked;        /* true if the data goes to the `chunks` table */
+    int64_t nbytes;      /* size of the value */
+    int64_t offset;      /* number of bytes written so far */
+    int64_t chunk_bytes; /* size of each chunk except maybe the last; same as nbytes when not chunked */
+    sqlite3_blob *blob;  /* handle of the value or chunk being written */
+    type_t eltype;       /* type of the elements */
+    int64_t swap_size;   /* size of the elements if their bytes are swapped, otherwise 0 */
+};
+
+struct de_reader_s
+{
+    de_file de;
+    array_layout_t layout; /* where the data is; layout.chunked is false for a value in one piece */
+    int64_t nbytes;        /* size of the value */
+    int64_t offset;        /* number of bytes read so far */
+    int64_t piece_bytes;   /* size of each piece (the value, a chunk or a slice) except maybe the last */
+    bool gather;           /* true if the chunks don't span all axes but the last; then each piece is
+                              one slice along the last axis, assembled in `buffer` */
+    char *buffer;          /* the current slice when gathering */
+    sqlite3_blob *blob;    /* handle of the value or chunk being read */
+    bool shared;           /* true if `blob` is on a shared value (see sql_open_value_blob) */
+    int64_t swap_size;     /* size of the elements if their bytes are swapped, otherwise 0 */
+};
+
+#endif
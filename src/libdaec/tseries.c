@@ -1,3 +1,5 @@
+#include <math.h>
+#include <string.h>
 
 #include "error.h"
 #include "file.h"
@@ -5,6 +7,8 @@
 #include "axis.h"
 #include "tseries.h"
 #include "sql.h"
+#include "misc.h"
+#include "convert.h"
 
 bool check_tseries_type(type_t type)
 {
@@ -37,6 +41,12 @@ int de_store_tseries(de_file de, obj_id_t pid, const char *name, type_t obj_type
     TRACE_RUN(_new_object(de, pid, class_tseries, obj_type, name, &_id));
     if (id != NULL)
         *id = _id;
+    if (de->swap && nbytes > 0)
+    {
+        axis_t axis;
+        TRACE_RUN(sql_load_axis(de, axis_id, &axis));
+        TRACE_RUN(_swap_value(de, eltype, axis.length, nbytes, &value));
+    }
     TRACE_RUN(sql_store_tseries_value(de, _id, eltype, elfreq, axis_id, nbytes, value));
     return DE_SUCCESS;
 }
@@ -50,5 +60,241 @@ int de_load_tseries(de_file de, obj_id_t id, tseries_t *tseries)
     if (tseries->object.obj_class != class_tseries)
         return error(DE_BAD_CLASS);
     TRACE_RUN(sql_load_tseries_value(de, id, tseries));
+    TRACE_RUN(_swap_value(de, tseries->eltype, tseries->axis.length, tseries->nbytes, &tseries->value));
+    if (tseries->nbytes == 0 && tseries->axis.length > 0)
+    {
+        /* the value might be stored in chunks */
+        array_layout_t layout;
+        TRACE_RUN(_tseries_layout(de, id, tseries, &layout));
+        if (layout.chunked)
+        {
+            TRACE_RUN(_load_chunks(de, &layout, &tseries->nbytes, &tseries->value));
+        }
+    }
+    return DE_SUCCESS;
+}
+
+int _tseries_layout(de_file de, obj_id_t id, const tseries_t *tseries, array_layout_t *layout)
+{
+    return _init_layout(de, id, "tseries", tseries->eltype, 1, &tseries->axis.length, tseries->nbytes, layout);
+}
+
+/* load the metadata of a tseries without its value */
+static int _load_tseries_meta(de_file de, obj_id_t id, tseries_t *tseries)
+{
+    int rc = sql_load_tseries_meta(de, id, tseries);
+    if (rc == DE_SUCCESS)
+        return DE_SUCCESS;
+    if (rc != DE_OBJ_DNE)
+        return trace_error();
+    /* distinguish between an object that doesn't exist and one that isn't a tseries */
+    de_clear_error();
+    TRACE_RUN(sql_load_object(de, id, &(tseries->object)));
+    return error1(DE_BAD_CLASS, _id2str(id));
+}
+
+/* fill `count` elements of size `elsize` with the missing value of the given type */
+static void _fill_missing(type_t eltype, int64_t elsize, int64_t count, void *value)
+{
+    if (eltype == type_float && elsize == sizeof(double))
+    {
+        double *dv = value;
+        for (int64_t i = 0; i < count; ++i)
+            dv[i] = NAN;
+    }
+    else if (eltype == type_float && elsize == sizeof(float))
+    {
+        float *fv = value;
+        for (int64_t i = 0; i < count; ++i)
+            fv[i] = NAN;
+    }
+    else
+        memset(value, 0, count * elsize);
+}
+
+int de_load_aligned(de_file de, int64_t n, const obj_id_t *ids, align_mode_t mode,
+                    axis_t *axis, type_t *eltype, int64_t *nbytes, void *value)
+{
+    if (de == NULL || ids == NULL || axis == NULL || nbytes == NULL)
+        return error(DE_NULL);
+    if (n <= 0 || (mode != align_intersection && mode != align_union))
+        return error(DE_ARG);
+
+    /* the metadata of each tseries, followed by the layouts of those stored in chunks */
+    tseries_t *meta = malloc(n * (sizeof(tseries_t) + sizeof(array_layout_t)));
+    if (meta == NULL)
+        return error(DE_ERR_ALLOC);
+    array_layout_t *layouts = (array_layout_t *)(meta + n);
+
+    /* first pass: compute the aligned range from the axes */
+    int rc = DE_SUCCESS;
+    int64_t elsize = 0;
+    date_t first = 0, last = 0;
+    for (int64_t j = 0; j < n; ++j)
+    {
+        tseries_t *ts = meta + j;
+        if (DE_SUCCESS != (rc = _load_tseries_meta(de, ids[j], ts)))
+            goto done;
+        if (ts->axis.ax_type != axis_range)
+        {
+            rc = error1(DE_BAD_AXIS_TYPE, _id2str(ids[j]));
+            goto done;
+        }
+        if (ts->axis.frequency != meta[0].axis.frequency)
+        {
+            rc = error1(DE_BAD_FREQ, _id2str(ids[j]));
+            goto done;
+        }
+        if (ts->eltype != meta[0].eltype || ts->eltype == type_string || ts->eltype >= type_other_scalar)
+        {
+            rc = error1(DE_BAD_ELTYPE, _id2str(ids[j]));
+            goto done;
+        }
+        layouts[j].chunked = false;
+        if (ts->axis.length > 0 && ts->nbytes == 0)
+        {
+            if (DE_SUCCESS != (rc = _tseries_layout(de, ids[j], ts, layouts + j)))
+                goto done;
+            ts->nbytes = layouts[j].elsize * ts->axis.length;
+        }
+        if (ts->axis.length > 0 && ts->nbytes > 0)
+        {
+            if (ts->nbytes % ts->axis.length != 0 ||
+                (elsize > 0 && elsize != ts->nbytes / ts->axis.length))
+            {
+                rc = error1(DE_BAD_OBJ, _id2str(ids[j]));
+                goto done;
+            }
+            elsize = ts->nbytes / ts->axis.length;
+        }
+        const date_t ts_first = ts->axis.first;
+        const date_t ts_last = ts->axis.first + ts->axis.length - 1;
+        if (j == 0)
+        {
+            first = ts_first;
+            last = ts_last;
+        }
+        else if (mode == align_intersection)
+        {
+            first = (ts_first > first) ? ts_first : first;
+            last = (ts_last < last) ? ts_last : last;
+        }
+        else
+        {
+            first = (ts_first < first) ? ts_first : first;
+            last = (ts_last > last) ? ts_last : last;
+        }
+    }
+
+    const int64_t length = (last >= first) ? last - first + 1 : 0;
+    axis->id = 0;
+    axis->ax_type = axis_range;
+    axis->frequency = meta[0].axis.frequency;
+    axis->first = first;
+    axis->length = length;
+    axis->names = NULL;
+    if (eltype != NULL)
+        *eltype = meta[0].eltype;
+
+    const int64_t colbytes = length * elsize;
+    const int64_t needed = n * colbytes;
+    if (*nbytes < 0)
+    {
+        *nbytes = needed;
+        goto done;
+    }
+    if (*nbytes < needed)
+    {
+        *nbytes = needed;
+        rc = error(DE_SHORT_BUF);
+        goto done;
+    }
+    *nbytes = needed;
+    if (needed == 0)
+        goto done;
+    if (value == NULL)
+    {
+        rc = error(DE_NULL);
+        goto done;
+    }
+
+    /* second pass: read the overlapping part of each value into its column */
+    sqlite3_blob *blob = NULL;
+    bool shared = false;
+    for (int64_t j = 0; j < n; ++j)
+    {
+        const tseries_t *ts = meta + j;
+        char *column = (char *)value + j * colbytes;
+        /* the part of the aligned range covered by this tseries */
+        date_t lo = (ts->axis.first > first) ? ts->axis.first : first;
+        date_t hi = ts->axis.first + ts->axis.length - 1;
+        hi = (hi < last) ? hi : last;
+        if (ts->nbytes == 0 || hi < lo)
+        {
+            _fill_missing(ts->eltype, elsize, length, column);
+            continue;
+        }
+        if (lo > first)
+            _fill_missing(ts->eltype, elsize, lo - first, column);
+        if (hi < last)
+            _fill_missing(ts->eltype, elsize, last - hi, column + (hi - first + 1) * elsize);
+        if (layouts[j].chunked)
+        {
+            const int64_t start = lo - ts->axis.first, count = hi - lo + 1;
+            if (DE_SUCCESS != (rc = _read_hyperslab(de, layouts + j, &start, &count, NULL, column + (lo - first) * elsize)))
+            {
+                rc = trace_error();
+                break;
+            }
+        }
+        else if (DE_SUCCESS != (rc = sql_open_value_blob(de, "tseries", ts->object.id, false, &blob, &shared)) ||
+                 DE_SUCCESS != (rc = sql_read_value_blob(blob, (lo - ts->axis.first) * elsize,
+                                                         (hi - lo + 1) * elsize, column + (lo - first) * elsize)))
+        {
+            rc = trace_error();
+            break;
+        }
+        if (de->swap)
+        {
+            char *part = column + (lo - first) * elsize;
+            _swap_elements(ts->eltype, elsize, (hi - lo + 1) * elsize, part, part);
+        }
+    }
+    if (blob != NULL && DE_SUCCESS != sql_close_value_blob(blob) && rc == DE_SUCCESS)
+        rc = trace_error();
+
+done:
+    free(meta);
+    return rc;
+}
+
+int de_load_tseries_as(de_file de, obj_id_t id, type_t eltype, int64_t elsize,
+                       int64_t *nbytes, void *value)
+{
+    if (de == NULL || nbytes == NULL)
+        return error(DE_NULL);
+    tseries_t tseries;
+    TRACE_RUN(de_load_tseries(de, id, &tseries));
+    const int64_t length = tseries.axis.length;
+    if (length < 0 || (length > 0 && (tseries.nbytes <= 0 || tseries.nbytes % length != 0)))
+        return error1(DE_BAD_OBJ, _id2str(id));
+    const int64_t src_size = (length > 0) ? tseries.nbytes / length : elsize;
+    /* validate the types before looking at the buffer */
+    TRACE_RUN(_convert_elements(tseries.eltype, src_size, eltype, elsize, 0, NULL, NULL));
+    const int64_t needed = length * elsize;
+    if (*nbytes < 0)
+    {
+        *nbytes = needed;
+        return DE_SUCCESS;
+    }
+    if (*nbytes < needed)
+    {
+        *nbytes = needed;
+        return error(DE_SHORT_BUF);
+    }
+    if (value == NULL && needed > 0)
+        return error(DE_NULL);
+    *nbytes = needed;
+    TRACE_RUN(_convert_elements(tseries.eltype, src_size, eltype, elsize, length, tseries.value, value));
     return DE_SUCCESS;
 }
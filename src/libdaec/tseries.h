@@ -4,6 +4,7 @@
 #include "file.h"
 #include "object.h"
 #include "axis.h"
+#include "hyperslab.h"
 
 /* ========================================================================= */
 /* API */
@@ -30,10 +31,55 @@ int de_store_tseries(de_file de, obj_id_t pid, const char *name, type_t type,
 /* load a 1d-array object by name from a given parent catalog */
 int de_load_tseries(de_file de, obj_id_t id, tseries_t *tseries);
 
+typedef enum
+{
+    align_intersection = 0, /* the common range of all series */
+    align_union,            /* the smallest range that contains all series */
+} align_mode_t;
+
+/*
+    load several tseries aligned on a common range axis into a column-major
+    matrix, one column per series.
+    NOTES:
+    * all tseries must have range axes of the same frequency and the same
+      element type and size.
+    * the aligned range is computed from the axes alone. It is written in
+      `axis`, whose `id` is set to 0 since the axis is not stored in the file.
+    * only the part of each value that falls in the aligned range is read
+      from the file. With align_union the remaining elements are filled with
+      NaN if the element type is type_float and with zeros otherwise.
+    * `nbytes` follows the same protocol as in de_pack_strings. If `*nbytes`
+      is negative on entry, `value` is not accessed and only `axis`, `eltype`
+      and the required number of bytes are calculated.
+    * `eltype` may be NULL.
+*/
+int de_load_aligned(de_file de, int64_t n, const obj_id_t *ids, align_mode_t mode,
+                    axis_t *axis, type_t *eltype, int64_t *nbytes, void *value);
+
+/*
+    load the value of a 1d-array object converted to elements of type
+    `eltype` and size `elsize` bytes.
+    NOTES:
+    * the stored elements and the requested ones must be numeric: type_signed
+      or type_unsigned of size 1, 2, 4 or 8, or type_float of size 4 or 8.
+    * floats are truncated towards zero when converted to integers. If any
+      element can't be represented in the requested type, for example NaN (a
+      missing value) or a number that is too large, we return DE_RANGE and
+      `value` is left as it was.
+    * `nbytes` follows the same protocol as in de_pack_strings.
+*/
+int de_load_tseries_as(de_file de, obj_id_t id, type_t eltype, int64_t elsize,
+                       int64_t *nbytes, void *value);
+
 /* ========================================================================= */
 /* internal */
 
 bool check_tseries_type(type_t type);
 int validate_eltype(type_t obj_type, type_t eltype, frequency_t elfreq);
 
+/* fill in the layout of the value of tseries `id`, whose metadata is in
+   `tseries`. A value too large for one row is stored in chunks by
+   de_open_tseries_writer, leaving the `value` column empty. */
+int _tseries_layout(de_file de, obj_id_t id, const tseries_t *tseries, array_layout_t *layout);
+
 #endif
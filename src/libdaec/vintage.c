@@ -0,0 +1,238 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "error.h"
+#include "file.h"
+#include "object.h"
+#include "axis.h"
+#include "tseries.h"
+#include "vintage.h"
+#include "sql.h"
+#include "misc.h"
+#include "convert.h"
+
+/*
+    A delta is the size of the new value followed by runs of bytes, each
+    given by its offset, its length and the bytes themselves. Bytes not in
+    any run are those of the previous value. The numbers are int64 in the
+    byte order of the file.
+*/
+
+/* size of the numbers in a delta */
+#define _NUM_BYTES ((int64_t)sizeof(int64_t))
+
+/* equal bytes between two changes are kept in the run unless there are at
+   least as many as the header of a new run */
+#define _MIN_GAP (2 * _NUM_BYTES)
+
+static void _put_num(bool swap, int64_t num, char *p)
+{
+    if (swap)
+        _swap_elements(type_signed, _NUM_BYTES, _NUM_BYTES, &num, &num);
+    memcpy(p, &num, _NUM_BYTES);
+}
+
+static int64_t _get_num(bool swap, const char *p)
+{
+    int64_t num;
+    memcpy(&num, p, _NUM_BYTES);
+    if (swap)
+        _swap_elements(type_signed, _NUM_BYTES, _NUM_BYTES, &num, &num);
+    return num;
+}
+
+/* write into `delta` the changes that make `cur` out of `prev`. Return the
+   size of the delta, or -1 if it would be larger than `cap` bytes */
+static int64_t _encode_delta(bool swap, int64_t prev_n, const char *prev,
+                             int64_t n, const char *cur, int64_t cap, char *delta)
+{
+    if (cap < _NUM_BYTES)
+        return -1;
+    _put_num(swap, n, delta);
+    int64_t pos = _NUM_BYTES;
+    const int64_t common = (prev_n < n) ? prev_n : n;
+    int64_t i = 0;
+    while (i < n)
+    {
+        while (i < common && prev[i] == cur[i])
+            ++i;
+        if (i == n)
+            break;
+        /* bytes past the end of `prev` are always part of a run */
+        int64_t start = i, end = i;
+        while (i < n)
+        {
+            if (i >= common || prev[i] != cur[i])
+            {
+                end = ++i;
+                continue;
+            }
+            int64_t j = i;
+            while (j < common && prev[j] == cur[j] && j - i < _MIN_GAP)
+                ++j;
+            if (j - i >= _MIN_GAP || j == n)
+                break;
+            i = j;
+        }
+        int64_t len = end - start;
+        if (pos + 2 * _NUM_BYTES + len > cap)
+            return -1;
+        _put_num(swap, start, delta + pos);
+        _put_num(swap, len, delta + pos + _NUM_BYTES);
+        memcpy(delta + pos + 2 * _NUM_BYTES, cur + start, len);
+        pos += 2 * _NUM_BYTES + len;
+    }
+    return pos;
+}
+
+/* apply the changes in `delta` to the value in `buf`, whose size is updated
+   in `n`. `buf` must be large enough for the new value (see _delta_size) */
+static int _apply_delta(bool swap, int64_t nbytes, const char *delta, int64_t *n, char *buf)
+{
+    if (nbytes < _NUM_BYTES)
+        return error(DE_BAD_OBJ);
+    int64_t new_n = _get_num(swap, delta);
+    int64_t pos = _NUM_BYTES;
+    while (pos < nbytes)
+    {
+        if (pos + 2 * _NUM_BYTES > nbytes)
+            return error(DE_BAD_OBJ);
+        int64_t start = _get_num(swap, delta + pos);
+        int64_t len = _get_num(swap, delta + pos + _NUM_BYTES);
+        pos += 2 * _NUM_BYTES;
+        if (start < 0 || len < 0 || start + len > new_n || pos + len > nbytes)
+            return error(DE_BAD_OBJ);
+        memcpy(buf + start, delta + pos, len);
+        pos += len;
+    }
+    *n = new_n;
+    return DE_SUCCESS;
+}
+
+/* size of the value made by a delta */
+static int64_t _delta_size(bool swap, int64_t nbytes, const char *delta)
+{
+    return (nbytes < _NUM_BYTES) ? -1 : _get_num(swap, delta);
+}
+
+/* number of elements in a value on the given axis */
+static int _count_elements(de_file de, axis_id_t axis_id, int64_t *nelem)
+{
+    axis_t axis;
+    TRACE_RUN(sql_load_axis(de, axis_id, &axis));
+    *nelem = axis.length;
+    return DE_SUCCESS;
+}
+
+int de_append_vintage(de_file de, obj_id_t id, int64_t timestamp,
+                      axis_id_t axis_id, int64_t nbytes, const void *value)
+{
+    if (de == NULL)
+        return error(DE_NULL);
+    if (nbytes < 0 || (nbytes > 0 && value == NULL))
+        return error(DE_ARG);
+    tseries_t ts;
+    TRACE_RUN(sql_load_object(de, id, &(ts.object)));
+    if (ts.object.obj_class != class_tseries)
+        return error1(DE_BAD_CLASS, _id2str(id));
+
+    int64_t last, count;
+    TRACE_RUN(sql_last_vintage(de, id, &last, &count));
+    if (count > 0 && timestamp <= last)
+        return error1(DE_ARG, "vintages must be appended in order of their timestamps");
+
+    /* the current value of the object is the previous vintage */
+    TRACE_RUN(sql_load_tseries_value(de, id, &ts));
+    if (ts.nbytes == 0 && ts.axis.length > 0)
+    {
+        /* deltas work on values in one piece */
+        array_layout_t layout;
+        TRACE_RUN(_tseries_layout(de, id, &ts, &layout));
+        if (layout.chunked)
+            return error1(DE_ARG, "value stored in chunks");
+    }
+
+    /* scratch memory holds the new value in the byte order of the file, if
+       it needs swapping, followed by the delta, which is only worth keeping
+       if it is less than half the size of the value */
+    const bool delta = (0 < count && count < DE_VINTAGE_SNAPSHOT);
+    const int64_t cap = delta ? nbytes / 2 : 0;
+    const int64_t swapped = de->swap ? nbytes : 0;
+    char *buf = _get_scratch(de, swapped + cap + 1);
+    if (buf == NULL)
+        return trace_error();
+    const char *cur = value;
+    if (swapped > 0)
+    {
+        int64_t nelem = 0;
+        TRACE_RUN(_count_elements(de, axis_id, &nelem));
+        if (nelem > 0)
+        {
+            _swap_elements(ts.eltype, nbytes / nelem, nbytes, value, buf);
+            cur = buf;
+        }
+    }
+    int64_t dlen = delta ? _encode_delta(de->swap, ts.nbytes, ts.value, nbytes, cur, cap, buf + swapped) : -1;
+    if (dlen >= 0)
+    {
+        TRACE_RUN(sql_store_vintage(de, id, timestamp, axis_id, false, dlen, buf + swapped));
+    }
+    else
+    {
+        TRACE_RUN(sql_store_vintage(de, id, timestamp, axis_id, true, nbytes, cur));
+    }
+    TRACE_RUN(sql_update_tseries_value(de, id, axis_id, nbytes, cur));
+    return DE_SUCCESS;
+}
+
+int de_load_tseries_asof(de_file de, obj_id_t id, int64_t timestamp, tseries_t *tseries)
+{
+    if (de == NULL || tseries == NULL)
+        return error(DE_NULL);
+    TRACE_RUN(sql_load_object(de, id, &(tseries->object)));
+    if (tseries->object.obj_class != class_tseries)
+        return error1(DE_BAD_CLASS, _id2str(id));
+    TRACE_RUN(sql_load_tseries_meta(de, id, tseries));
+
+    /* rebuild the vintage in scratch memory, starting from the last snapshot */
+    sqlite3_stmt *stmt;
+    TRACE_RUN(sql_load_vintages(de, id, timestamp, &stmt));
+    bool found, any = false, snapshot;
+    axis_id_t axis_id = 0;
+    int64_t n = 0, nbytes;
+    const void *value;
+    char *buf = NULL;
+    while (1)
+    {
+        TRACE_RUN(sql_next_vintage(stmt, &found, &axis_id, &snapshot, &nbytes, &value));
+        if (!found)
+            break;
+        int64_t new_n = snapshot ? nbytes : _delta_size(de->swap, nbytes, value);
+        if (new_n < 0 || (!snapshot && !any))
+            return error1(DE_BAD_OBJ, _id2str(id));
+        /* the scratch memory keeps its content when it grows */
+        if (NULL == (buf = _get_scratch(de, new_n + 1)))
+            return trace_error();
+        if (snapshot)
+        {
+            if (nbytes > 0)
+                memcpy(buf, value, nbytes);
+            n = nbytes;
+        }
+        else
+        {
+            TRACE_RUN(_apply_delta(de->swap, nbytes, value, &n, buf));
+        }
+        any = true;
+    }
+    if (!any)
+        return error1(DE_OBJ_DNE, "no vintage at the given time");
+
+    TRACE_RUN(sql_load_axis(de, axis_id, &(tseries->axis)));
+    if (de->swap && tseries->axis.length > 0)
+        _swap_elements(tseries->eltype, n / tseries->axis.length, n, buf, buf);
+    tseries->nbytes = n;
+    tseries->value = (n > 0) ? buf : NULL;
+    return DE_SUCCESS;
+}
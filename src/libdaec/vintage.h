@@ -0,0 +1,46 @@
+#ifndef __VINTAGE_H__
+#define __VINTAGE_H__
+
+#include <stdint.h>
+
+#include "file.h"
+#include "object.h"
+#include "axis.h"
+#include "tseries.h"
+
+/* ========================================================================= */
+/* API */
+
+/*
+    append a new vintage (revision) to a 1d-array object. The vintage becomes
+    the value of the object and is added to its history.
+    NOTES:
+    * `timestamp` identifies the vintage, e.g. the time of its release. It can
+      be any number, but each vintage must have a larger timestamp than the
+      previous one, otherwise we return DE_ARG.
+    * the axis may differ from that of the previous vintage, but the element
+      type is that of the object.
+    * the history keeps most vintages as the bytes that changed since the
+      previous one, so revisions that touch a few elements or extend the
+      range take little space. Every 16 vintages (and whenever the changes
+      are large) the full value is kept instead, so that loading any vintage
+      never goes through more than 15 sets of changes.
+    * the value the object had before its first vintage is not part of the
+      history.
+*/
+int de_append_vintage(de_file de, obj_id_t id, int64_t timestamp,
+                      axis_id_t axis_id, int64_t nbytes, const void *value);
+
+/* load the vintage of a 1d-array object that was in effect at `timestamp`,
+   i.e. the last one appended with a timestamp not larger than it. Return
+   DE_OBJ_DNE if there is none. The memory of the value is managed by the
+   library and is valid until the next library call. */
+int de_load_tseries_asof(de_file de, obj_id_t id, int64_t timestamp, tseries_t *tseries);
+
+/* ========================================================================= */
+/* internal */
+
+/* number of vintages between full copies of the value in the history */
+#define DE_VINTAGE_SNAPSHOT 16
+
+#endif
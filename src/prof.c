@@ -4,9 +4,17 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 de_file de;
 char msg[1024];
+
+/* internal, see file.h */
+int64_t _statement_runs(de_file de);
+
+/* number of new objects whose statements are counted */
+#define NCOUNTED 1000
+
 #define CHECK(rc)                                         \
     if (rc)                                               \
     {                                                     \
@@ -22,6 +30,75 @@ int main(void)
 
     CHECK(de_open("prof.daec", &de));
 
+    /* count the statements run for each new scalar, with the info of the
+       objects filled in right away and then deferred to the commit, which
+       stays on for the rest. The baseline adds the lookup of the name that
+       used to come before the insert, which now reports duplicates itself */
+    obj_id_t counted;
+    rc = de_new_catalog(de, 0, "counted", &counted);
+    CHECK(rc);
+    for (int defer = 0; defer <= 1; ++defer)
+    {
+        rc = de_set_defer_info(de, defer);
+        CHECK(rc);
+        double x = 0;
+        int64_t runs[2];
+        for (int lookup = 1; lookup >= 0; --lookup)
+        {
+            runs[lookup] = _statement_runs(de);
+            for (int i = 1; i <= NCOUNTED; ++i)
+            {
+                snprintf(msg, 1023, "x%d_%d_%d", defer, lookup, i);
+                if (lookup)
+                {
+                    rc = de_find_object(de, counted, msg, NULL);
+                    if (rc == DE_SUCCESS)
+                        rc = DE_EXISTS;
+                    if (rc != DE_OBJ_DNE)
+                        CHECK(rc);
+                    de_clear_error();
+                }
+                rc = de_store_scalar(de, counted, msg, type_float, freq_none, sizeof(x), &x, NULL);
+                CHECK(rc);
+            }
+            runs[lookup] = _statement_runs(de) - runs[lookup];
+        }
+        printf("statement runs per new scalar, triggers included%s: %.2f, %.2f with a lookup first\n",
+               defer ? ", deferred info" : "", (double)runs[0] / NCOUNTED, (double)runs[1] / NCOUNTED);
+    }
+
+    /* the same for new tseries on a date axis, two catalogs down, without and
+       with the statistics of the catalogs kept by triggers */
+    axis_id_t monthly;
+    date_t jan2000;
+    rc = de_pack_year_period_date(freq_monthly, 2000, 1, &jan2000);
+    CHECK(rc);
+    rc = de_axis_range(de, 12, freq_monthly, jan2000, &monthly);
+    CHECK(rc);
+    for (int stats = 0; stats <= 1; ++stats)
+    {
+        rc = de_set_catalog_stats(de, stats);
+        CHECK(rc);
+        obj_id_t cat;
+        rc = de_new_catalog(de, counted, stats ? "stats" : "nostats", &cat);
+        CHECK(rc);
+        double x[12] = {0};
+        int64_t runs = _statement_runs(de);
+        clock_t start = clock();
+        for (int i = 1; i <= NCOUNTED; ++i)
+        {
+            snprintf(msg, 1023, "t%d", i);
+            rc = de_store_tseries(de, cat, msg, type_tseries, type_float, freq_monthly, monthly, sizeof(x), x, NULL);
+            CHECK(rc);
+        }
+        runs = _statement_runs(de) - runs;
+        printf("statement runs per new tseries, triggers included%s: %.2f, %.1f us each\n",
+               stats ? ", catalog stats" : "", (double)runs / NCOUNTED,
+               1e6 * (double)(clock() - start) / CLOCKS_PER_SEC / NCOUNTED);
+    }
+    rc = de_set_catalog_stats(de, 0);
+    CHECK(rc);
+
     obj_id_t scalars;
     rc = de_new_catalog(de, 0, "scalars", &scalars);
     CHECK(rc);
@@ -60,6 +137,38 @@ int main(void)
         CHECK(rc);
     }
 
+    obj_id_t panels;
+    rc = de_new_catalog(de, 0, "panels", &panels);
+    CHECK(rc);
+
+#   define NROWS 10000
+#   define NCOLS 300
+
+    /* load one column at a time from a wide mvtseries */
+    axis_id_t rows, cols;
+    rc = de_axis_plain(de, NROWS, &rows);
+    CHECK(rc);
+    rc = de_axis_plain(de, NCOLS, &cols);
+    CHECK(rc);
+
+    double *mvals = malloc(NROWS * NCOLS * sizeof(double));
+    if (mvals == NULL)
+        CHECK(DE_ERR_ALLOC);
+    for (int i = 0; i < NROWS * NCOLS; ++i)
+        mvals[i] = i;
+
+    obj_id_t panel;
+    rc = de_store_mvtseries(de, panels, "panel", type_mvtseries, type_float, freq_none, rows, cols, NROWS * NCOLS * sizeof(double), mvals, &panel);
+    CHECK(rc);
+    for (int j = 0; j < NCOLS; ++j)
+    {
+        const int64_t start[2] = {0, j}, count[2] = {NROWS, 1};
+        int64_t nbytes = NROWS * sizeof(double);
+        rc = de_load_mvtseries_slice(de, panel, start, count, NULL, &nbytes, mvals);
+        CHECK(rc);
+    }
+    free(mvals);
+
     rc = de_close(de);
     CHECK(rc);
 
@@ -277,6 +277,38 @@ void check_ypp_pack_unpack_calendar(frequency_t fr, int ppy, int mpp, const char
     }
 }
 
+/* record the calls of a progress function */
+static int64_t progress_calls, progress_done, progress_total;
+void count_progress(int64_t done, int64_t total)
+{
+    ++progress_calls;
+    progress_done = done;
+    progress_total = total;
+}
+
+/* a progress function that also writes to the file being copied, the first
+   `progress_writes` times it is called, through another connection */
+static const char *progress_writer_fname;
+static int64_t progress_writes;
+void write_progress(int64_t done, int64_t total)
+{
+    if (progress_calls++ < progress_writes)
+    {
+        de_file other;
+        static int written = 0;
+        char name[40];
+        if (written++ == 0)
+            strcpy(name, "written during backup");
+        else
+            sprintf(name, "written during backup %d", written);
+        CHECK_SUCCESS(de_open(progress_writer_fname, &other));
+        CHECK_SUCCESS(de_new_catalog(other, 0, name, NULL));
+        CHECK_SUCCESS(de_close(other));
+    }
+    progress_done = done;
+    progress_total = total;
+}
+
 int main(void)
 {
 
@@ -478,9 +510,10 @@ int main(void)
         CHECK_SUCCESS(de_store_scalar(de, 0, "attr_test_1", type_signed, freq_none, sizeof val, &val, &_id));
         CHECK_SUCCESS(de_get_all_attributes(de, _id, ",", &num, &name, &value));
         FAIL_IF(num != 0 || name != NULL || value != NULL, "de_get_all_attributes for object with no attributes");
-        /* root catalog has one attribute */
+        /* root catalog has two attributes */
         CHECK_SUCCESS(de_get_all_attributes(de, 0, ",", &num, &name, &value));
-        FAIL_IF(num != 1 || (strcmp(name, "DE_VERSION") != 0) || (strcmp(value, de_version()) != 0), "Get all attributes of root catalog");
+        FAIL_IF(num != 2 || (strcmp(name, "DE_BYTE_ORDER,DE_VERSION") != 0) || (strchr(value, ',') == NULL) ||
+                    (strcmp(strchr(value, ',') + 1, de_version()) != 0), "Get all attributes of root catalog");
         /* object does not exist - DE_OBJ_DNE*/
         CHECK(de_get_all_attributes(de, -1, ",", &num, &name, &value), DE_OBJ_DNE);
     }
@@ -713,6 +746,66 @@ int main(void)
         CHECK_SUCCESS(de_store_mvtseries(de, cata, "two_by_three", type_mvtseries, type_float, freq_none, ax1, ax2, sizeof values, values, &_id));
         CHECK_SUCCESS(de_load_mvtseries(de, _id, &data));
         CHECK_MVTSERIES(data, _id, type_mvtseries, type_float, freq_none, sizeof values[0][0], ax1, ax2, values);
+
+        /* columns are contiguous: "orange" is {3, 4} */
+        double col[6];
+        int64_t nbytes = sizeof col;
+        const int64_t start[2] = {0, 1}, count[2] = {2, 1};
+        CHECK_SUCCESS(de_load_mvtseries_slice(de, _id, start, count, NULL, &nbytes, col));
+        FAIL_IF(nbytes != 2 * sizeof(double) || col[0] != 3 || col[1] != 4, "mvtseries column");
+        /* second row of every other column */
+        const int64_t start2[2] = {1, 0}, count2[2] = {1, 2}, stride2[2] = {1, 2};
+        CHECK_SUCCESS(de_load_mvtseries_slice(de, _id, start2, count2, stride2, &nbytes, col));
+        FAIL_IF(nbytes != 2 * sizeof(double) || col[0] != 2 || col[1] != 6, "mvtseries row");
+        const int64_t count3[2] = {2, 3};
+        CHECK(de_load_mvtseries_slice(de, _id, start, count3, NULL, &nbytes, col), DE_RANGE);
+        CHECK(de_load_mvtseries_slice(de, cata, start, count, NULL, &nbytes, col), DE_BAD_CLASS);
+
+        /* storage order */
+        order_t order;
+        CHECK_SUCCESS(de_get_mvtseries_order(de, _id, &order));
+        FAIL_IF(order != order_col_major, "default order");
+        double rvalues[2][3] = {{1, 3, 5}, {2, 4, 6}}; /* same matrix as `values`, row-major */
+        CHECK(de_store_mvtseries_order(de, cata, "fail", type_mvtseries, type_float, freq_none, ax1, ax2, 2, sizeof rvalues, rvalues, &_id), DE_ARG);
+        CHECK_SUCCESS(de_store_mvtseries_order(de, cata, "two_by_three_rows", type_mvtseries, type_float, freq_none, ax1, ax2, order_row_major, sizeof rvalues, rvalues, &_id));
+        CHECK_SUCCESS(de_get_mvtseries_order(de, _id, &order));
+        FAIL_IF(order != order_row_major, "row-major order");
+        /* de_load_mvtseries always gives column-major order */
+        CHECK_SUCCESS(de_load_mvtseries(de, _id, &data));
+        CHECK_MVTSERIES(data, _id, type_mvtseries, type_float, freq_none, sizeof values[0][0], ax1, ax2, values);
+        CHECK_SUCCESS(de_load_mvtseries_order(de, _id, order_col_major, &data));
+        CHECK_MVTSERIES(data, _id, type_mvtseries, type_float, freq_none, sizeof values[0][0], ax1, ax2, values);
+        CHECK_SUCCESS(de_load_mvtseries_order(de, _id, order_row_major, &data));
+        CHECK_MVTSERIES(data, _id, type_mvtseries, type_float, freq_none, sizeof values[0][0], ax1, ax2, rvalues);
+        nbytes = sizeof col;
+        CHECK_SUCCESS(de_load_mvtseries_slice(de, _id, start, count, NULL, &nbytes, col));
+        FAIL_IF(nbytes != 2 * sizeof(double) || col[0] != 3 || col[1] != 4, "mvtseries column of row-major");
+        const int64_t count4[2] = {2, 2};
+        nbytes = sizeof col;
+        CHECK_SUCCESS(de_load_mvtseries_slice(de, _id, start, count4, NULL, &nbytes, col));
+        FAIL_IF(nbytes != 4 * sizeof(double) || col[0] != 3 || col[1] != 4 || col[2] != 5 || col[3] != 6, "mvtseries columns of row-major");
+
+        /* larger than a transpose block, with elements of 8 and 16 bytes */
+        axis_id_t ax3, ax4;
+        CHECK_SUCCESS(de_axis_plain(de, 70, &ax3));
+        CHECK_SUCCESS(de_axis_plain(de, 45, &ax4));
+        static double big[70 * 45 * 2];
+        for (int i = 0; i < 70 * 45 * 2; ++i)
+            big[i] = i;
+        CHECK_SUCCESS(de_store_mvtseries(de, cata, "big", type_mvtseries, type_float, freq_none, ax3, ax4, 70 * 45 * sizeof(double), big, &_id));
+        CHECK_SUCCESS(de_load_mvtseries_order(de, _id, order_row_major, &data));
+        for (int i = 0; i < 70; ++i)
+            for (int j = 0; j < 45; ++j)
+                FAIL_IF(((const double *)data.value)[i * 45 + j] != i + 70 * j, "transpose 8 bytes");
+        CHECK_SUCCESS(de_store_mvtseries(de, cata, "big_complex", type_mvtseries, type_complex, freq_none, ax3, ax4, sizeof big, big, &_id));
+        CHECK_SUCCESS(de_load_mvtseries_order(de, _id, order_row_major, &data));
+        for (int i = 0; i < 70; ++i)
+            for (int j = 0; j < 45; ++j)
+                FAIL_IF(((const double *)data.value)[2 * (i * 45 + j) + 1] != 2 * (i + 70 * j) + 1, "transpose 16 bytes");
+        const int64_t big_chunk[2] = {16, 16};
+        CHECK_SUCCESS(de_store_mvtseries_chunked(de, cata, "big_chunked", type_mvtseries, type_float, freq_none, ax3, ax4, big_chunk, 70 * 45 * sizeof(double), big, &_id));
+        CHECK_SUCCESS(de_load_mvtseries_order(de, _id, order_row_major, &data));
+        FAIL_IF(((const double *)data.value)[1] != 70 || ((const double *)data.value)[45] != 1, "transpose chunked");
     }
 
     /* test ndtseries */
@@ -768,6 +861,1560 @@ int main(void)
                                          sizeof values, values, &_id), DE_BAD_NUM_AXES);
     }
 
+    /* test frequency conversion */
+    {
+        obj_id_t cata;
+        CHECK_SUCCESS(de_new_catalog(de, 0, "fconvert", &cata));
+
+        axis_id_t ax;
+        obj_id_t _id;
+        tseries_t ts;
+        date_t first, d;
+        int64_t length;
+        double out[100];
+
+        /* monthly 2000M2 - 2001M1, the value in month M of 2000 is M - 1 */
+        double mvals[12];
+        for (int i = 0; i < 12; ++i)
+            mvals[i] = i + 1;
+        CHECK_SUCCESS(de_pack_year_period_date(freq_monthly, 2000, 2, &d));
+        CHECK_SUCCESS(de_axis_range(de, 12, freq_monthly, d, &ax));
+        CHECK_SUCCESS(de_store_tseries(de, cata, "monthly", type_tseries, type_float, freq_none, ax, sizeof mvals, mvals, &_id));
+
+        /* only 2000Q2 - 2000Q4 are complete */
+        CHECK_SUCCESS(de_pack_year_period_date(freq_quarterly, 2000, 2, &d));
+        CHECK(de_fconvert_range(freq_monthly, d, 12, freq_quarterly, fconv_sum, NULL, &length), DE_NULL);
+        length = -1;
+        CHECK_SUCCESS(de_load_tseries_fconvert(de, _id, freq_quarterly, fconv_sum, &first, &length, NULL));
+        FAIL_IF(first != d || length != 3, "fconvert range");
+        length = 2;
+        CHECK(de_load_tseries_fconvert(de, _id, freq_quarterly, fconv_sum, &first, &length, out), DE_SHORT_BUF);
+        FAIL_IF(length != 3, "fconvert required length");
+        length = sizeof out / sizeof out[0];
+        CHECK_SUCCESS(de_load_tseries_fconvert(de, _id, freq_quarterly, fconv_sum, &first, &length, out));
+        FAIL_IF(length != 3 || out[0] != 12 || out[1] != 21 || out[2] != 30, "fconvert sum");
+        length = sizeof out / sizeof out[0];
+        CHECK_SUCCESS(de_load_tseries_fconvert(de, _id, freq_quarterly, fconv_mean, &first, &length, out));
+        FAIL_IF(length != 3 || out[0] != 4 || out[1] != 7 || out[2] != 10, "fconvert mean");
+        length = sizeof out / sizeof out[0];
+        CHECK_SUCCESS(de_load_tseries_fconvert(de, _id, freq_quarterly, fconv_eop, &first, &length, out));
+        FAIL_IF(length != 3 || out[0] != 5 || out[1] != 8 || out[2] != 11, "fconvert eop");
+        length = sizeof out / sizeof out[0];
+        CHECK_SUCCESS(de_load_tseries_fconvert(de, _id, freq_halfyearly, fconv_sum, &first, &length, out));
+        FAIL_IF(length != 1 || out[0] != 51, "fconvert sum halfyearly");
+        CHECK(de_load_tseries_fconvert(de, _id, freq_quarterly, fconv_linear, &first, &length, out), DE_ARG);
+        CHECK(de_load_tseries_fconvert(de, _id, freq_monthly + 1, fconv_mean, &first, &length, out), DE_BAD_FREQ);
+        CHECK(de_load_tseries_fconvert(de, cata, freq_quarterly, fconv_mean, &first, &length, out), DE_BAD_CLASS);
+
+        /* missing values */
+        mvals[2] = NAN;
+        mvals[6] = NAN;
+        CHECK_SUCCESS(de_store_tseries(de, cata, "monthly_nan", type_tseries, type_float, freq_none, ax, sizeof mvals, mvals, &_id));
+        CHECK_SUCCESS(de_load_tseries(de, _id, &ts));
+        length = sizeof out / sizeof out[0];
+        CHECK_SUCCESS(de_fconvert_tseries(&ts, freq_quarterly, fconv_first, &first, &length, out));
+        FAIL_IF(length != 3 || out[0] != 4 || out[1] != 6 || out[2] != 9, "fconvert first");
+        length = sizeof out / sizeof out[0];
+        CHECK_SUCCESS(de_fconvert_tseries(&ts, freq_quarterly, fconv_last, &first, &length, out));
+        FAIL_IF(length != 3 || out[0] != 5 || out[1] != 8 || out[2] != 11, "fconvert last");
+        length = sizeof out / sizeof out[0];
+        CHECK_SUCCESS(de_fconvert_tseries(&ts, freq_quarterly, fconv_sum, &first, &length, out));
+        FAIL_IF(length != 3 || !isnan(out[0]) || !isnan(out[1]) || out[2] != 30, "fconvert sum with NaN");
+
+        /* daily 2000-01-15 - 2000-03-31 of ones to monthly: January is incomplete, 2000 is a leap year */
+        int32_t ivals[77];
+        for (int i = 0; i < 77; ++i)
+            ivals[i] = 1;
+        CHECK_SUCCESS(de_pack_calendar_date(freq_daily, 2000, 1, 15, &d));
+        CHECK_SUCCESS(de_axis_range(de, 77, freq_daily, d, &ax));
+        CHECK_SUCCESS(de_store_tseries(de, cata, "daily", type_tseries, type_signed, freq_none, ax, sizeof ivals, ivals, &_id));
+        length = sizeof out / sizeof out[0];
+        CHECK_SUCCESS(de_load_tseries_fconvert(de, _id, freq_monthly, fconv_sum, &first, &length, out));
+        CHECK_SUCCESS(de_pack_year_period_date(freq_monthly, 2000, 2, &d));
+        FAIL_IF(first != d || length != 2 || out[0] != 29 || out[1] != 31, "fconvert daily to monthly");
+        CHECK(de_load_tseries_fconvert(de, _id, freq_bdaily, fconv_sum, &first, &length, out), DE_BAD_FREQ);
+
+        /* business daily Mon 2023-07-03 - Fri 2023-07-28 to weekly ending on Sunday */
+        CHECK_SUCCESS(de_pack_calendar_date(freq_bdaily, 2023, 7, 3, &d));
+        CHECK_SUCCESS(de_axis_range(de, 20, freq_bdaily, d, &ax));
+        CHECK_SUCCESS(de_store_tseries(de, cata, "bdaily", type_tseries, type_signed, freq_none, ax, 20 * sizeof ivals[0], ivals, &_id));
+        length = sizeof out / sizeof out[0];
+        CHECK_SUCCESS(de_load_tseries_fconvert(de, _id, freq_weekly_sun, fconv_sum, &first, &length, out));
+        FAIL_IF(length != 4 || out[0] != 5 || out[3] != 5, "fconvert bdaily to weekly");
+
+        /* periods that straddle the periods of the other frequency */
+        CHECK(de_fconvert_range(freq_weekly_sun, d, 4, freq_monthly, fconv_sum, &first, &length), DE_BAD_FREQ);
+        CHECK(de_fconvert_range(freq_monthly, d, 4, freq_weekly_sun, fconv_const, &first, &length), DE_BAD_FREQ);
+        CHECK(de_fconvert_range(freq_quarterly_jan, d, 4, freq_yearly, fconv_sum, &first, &length), DE_BAD_FREQ);
+        CHECK(de_fconvert_range(freq_halfyearly_mar, d, 4, freq_yearly_jun, fconv_sum, &first, &length), DE_BAD_FREQ);
+        CHECK_SUCCESS(de_pack_year_period_date(freq_quarterly_jan, 2000, 1, &d));
+        CHECK_SUCCESS(de_fconvert_range(freq_quarterly_jan, d, 6, freq_yearly_apr, fconv_sum, &first, &length));
+        FAIL_IF(length != 1, "fconvert nested quarters");
+        CHECK_SUCCESS(de_pack_year_period_date(freq_quarterly, 2000, 1, &d));
+        CHECK_SUCCESS(de_fconvert_range(freq_quarterly, d, 4, freq_halfyearly_jun, fconv_sum, &first, &length));
+        FAIL_IF(length != 2, "fconvert nested quarters");
+
+        /* quarterly 2000Q1 - 2000Q2 to monthly */
+        double qvals[2] = {3, 6};
+        CHECK_SUCCESS(de_pack_year_period_date(freq_quarterly, 2000, 1, &d));
+        CHECK_SUCCESS(de_axis_range(de, 2, freq_quarterly, d, &ax));
+        CHECK_SUCCESS(de_store_tseries(de, cata, "quarterly", type_tseries, type_float, freq_none, ax, sizeof qvals, qvals, &_id));
+        CHECK_SUCCESS(de_pack_year_period_date(freq_monthly, 2000, 1, &d));
+        length = sizeof out / sizeof out[0];
+        CHECK_SUCCESS(de_load_tseries_fconvert(de, _id, freq_monthly, fconv_const, &first, &length, out));
+        FAIL_IF(first != d || length != 6 || out[0] != 3 || out[2] != 3 || out[3] != 6 || out[5] != 6, "fconvert const");
+        length = sizeof out / sizeof out[0];
+        CHECK_SUCCESS(de_load_tseries_fconvert(de, _id, freq_monthly, fconv_even, &first, &length, out));
+        FAIL_IF(length != 6 || out[0] != 1 || out[2] != 1 || out[3] != 2 || out[5] != 2, "fconvert even");
+        length = sizeof out / sizeof out[0];
+        CHECK_SUCCESS(de_load_tseries_fconvert(de, _id, freq_monthly, fconv_linear, &first, &length, out));
+        for (int i = 0; i < 6; ++i)
+            FAIL_IF(fabs(out[i] - (i + 1)) > 1e-12, "fconvert linear");
+        CHECK(de_load_tseries_fconvert(de, _id, freq_monthly, fconv_mean, &first, &length, out), DE_ARG);
+
+        /* plain axis */
+        CHECK_SUCCESS(de_axis_plain(de, 2, &ax));
+        CHECK_SUCCESS(de_store_tseries(de, cata, "plain", type_tseries, type_float, freq_none, ax, sizeof qvals, qvals, &_id));
+        CHECK(de_load_tseries_fconvert(de, _id, freq_monthly, fconv_const, &first, &length, out), DE_BAD_AXIS_TYPE);
+    }
+
+    /* test calendars */
+    {
+        calendar_id_t cid, _cid;
+        de_calendar cal;
+        date_t first, last, hol, d;
+        int64_t count, index;
+
+        /* July 2023, starts on a Saturday, Monday the 3rd is a holiday */
+        CHECK_SUCCESS(de_pack_calendar_date(freq_daily, 2023, 7, 1, &first));
+        CHECK_SUCCESS(de_pack_calendar_date(freq_daily, 2023, 7, 31, &last));
+        CHECK_SUCCESS(de_pack_calendar_date(freq_daily, 2023, 7, 3, &hol));
+        CHECK(de_store_calendar(de, "july", last, first, 1, &hol, &cid), DE_RANGE);
+        CHECK(de_store_calendar(de, "", first, last, 1, &hol, &cid), DE_BAD_NAME);
+        CHECK_SUCCESS(de_store_calendar(de, "july", first, last, 1, &hol, &cid));
+        CHECK(de_store_calendar(de, "july", first, last, 0, NULL, &_cid), DE_EXISTS);
+        CHECK_SUCCESS(de_find_calendar(de, "july", &_cid));
+        FAIL_IF(cid != _cid, "find calendar");
+        CHECK(de_find_calendar(de, "august", &_cid), DE_OBJ_DNE);
+
+        CHECK_SUCCESS(de_load_calendar(de, cid, &cal));
+        CHECK_SUCCESS(de_calendar_info(cal, &d, NULL, &count));
+        FAIL_IF(d != first || count != 20, "calendar info");
+
+        CHECK(de_calendar_index(cal, freq_daily, first, &index), DE_INEXACT);
+        FAIL_IF(index != 0, "calendar index of weekend");
+        CHECK(de_calendar_index(cal, freq_daily, hol, &index), DE_INEXACT);
+        FAIL_IF(index != 0, "calendar index of holiday");
+        CHECK_SUCCESS(de_pack_calendar_date(freq_bdaily, 2023, 7, 10, &d));
+        CHECK_SUCCESS(de_calendar_index(cal, freq_bdaily, d, &index));
+        FAIL_IF(index != 4, "calendar index of bdaily");
+        CHECK_SUCCESS(de_calendar_index(cal, freq_daily, last, &index));
+        FAIL_IF(index != 19, "calendar index of last");
+        CHECK(de_calendar_index(cal, freq_daily, first - 1, &index), DE_RANGE);
+        CHECK(de_calendar_index(cal, freq_monthly, first, &index), DE_BAD_FREQ);
+
+        CHECK_SUCCESS(de_calendar_date(cal, freq_daily, 0, &d));
+        FAIL_IF(d != hol + 1, "calendar date");
+        CHECK_SUCCESS(de_calendar_date(cal, freq_bdaily, 4, &d));
+        CHECK_SUCCESS(de_calendar_index(cal, freq_bdaily, d, &index));
+        FAIL_IF(index != 4, "calendar bdaily round trip");
+        for (int64_t i = 0; i < count; ++i)
+        {
+            CHECK_SUCCESS(de_calendar_date(cal, freq_daily, i, &d));
+            CHECK_SUCCESS(de_calendar_index(cal, freq_daily, d, &index));
+            FAIL_IF(index != i, "calendar daily round trip");
+        }
+        CHECK(de_calendar_date(cal, freq_daily, count, &d), DE_RANGE);
+        CHECK_SUCCESS(de_finalize_calendar(cal));
+        CHECK_SUCCESS(de_finalize_calendar(NULL)); // harmless no-op
+
+        /* the calendar ends with a weekend and a holiday, Monday the 31st */
+        CHECK_SUCCESS(de_store_calendar(de, "july_end", first, last, 1, &last, &cid));
+        CHECK_SUCCESS(de_load_calendar(de, cid, &cal));
+        CHECK_SUCCESS(de_calendar_info(cal, NULL, NULL, &count));
+        FAIL_IF(count != 20, "calendar info with trailing holiday");
+        CHECK_SUCCESS(de_calendar_index(cal, freq_daily, last - 3, &index));
+        FAIL_IF(index != 19, "calendar index before trailing holiday");
+        index = -1;
+        CHECK(de_calendar_index(cal, freq_daily, last - 2, &index), DE_RANGE);
+        CHECK(de_calendar_index(cal, freq_daily, last, &index), DE_RANGE);
+        FAIL_IF(index != -1, "calendar index of trailing holiday");
+        CHECK_SUCCESS(de_finalize_calendar(cal));
+    }
+
+    /* test aligned loading */
+    {
+        obj_id_t cata, ids[4];
+        CHECK_SUCCESS(de_new_catalog(de, 0, "aligned", &cata));
+
+        axis_id_t ax;
+        axis_t axis;
+        type_t eltype;
+        date_t d;
+        int64_t nbytes;
+        double vals[12], out[3 * 12];
+        for (int i = 0; i < 12; ++i)
+            vals[i] = i + 1;
+
+        /* 2000M1 - 2000M6, 2000M3 - 2000M10 and 2000M5 - 2000M12 */
+        CHECK_SUCCESS(de_pack_year_period_date(freq_monthly, 2000, 1, &d));
+        CHECK_SUCCESS(de_axis_range(de, 6, freq_monthly, d, &ax));
+        CHECK_SUCCESS(de_store_tseries(de, cata, "a", type_tseries, type_float, freq_none, ax, 6 * sizeof(double), vals, &ids[0]));
+        CHECK_SUCCESS(de_axis_range(de, 8, freq_monthly, d + 2, &ax));
+        CHECK_SUCCESS(de_store_tseries(de, cata, "b", type_tseries, type_float, freq_none, ax, 8 * sizeof(double), vals, &ids[1]));
+        CHECK_SUCCESS(de_axis_range(de, 8, freq_monthly, d + 4, &ax));
+        CHECK_SUCCESS(de_store_tseries(de, cata, "c", type_tseries, type_float, freq_none, ax, 8 * sizeof(double), vals, &ids[2]));
+
+        nbytes = -1;
+        CHECK_SUCCESS(de_load_aligned(de, 3, ids, align_intersection, &axis, &eltype, &nbytes, NULL));
+        FAIL_IF(axis.ax_type != axis_range || axis.frequency != freq_monthly || axis.first != d + 4 || axis.length != 2, "aligned intersection axis");
+        FAIL_IF(eltype != type_float || nbytes != 3 * 2 * sizeof(double), "aligned intersection size");
+        nbytes = sizeof out;
+        CHECK_SUCCESS(de_load_aligned(de, 3, ids, align_intersection, &axis, NULL, &nbytes, out));
+        FAIL_IF(out[0] != 5 || out[1] != 6 || out[2] != 3 || out[3] != 4 || out[4] != 1 || out[5] != 2, "aligned intersection values");
+
+        nbytes = 10;
+        CHECK(de_load_aligned(de, 3, ids, align_union, &axis, NULL, &nbytes, out), DE_SHORT_BUF);
+        FAIL_IF(nbytes != sizeof out, "aligned union size");
+        CHECK_SUCCESS(de_load_aligned(de, 3, ids, align_union, &axis, NULL, &nbytes, out));
+        FAIL_IF(axis.first != d || axis.length != 12, "aligned union axis");
+        FAIL_IF(out[0] != 1 || out[5] != 6 || !isnan(out[6]) || !isnan(out[11]), "aligned union column 1");
+        FAIL_IF(!isnan(out[12 + 1]) || out[12 + 2] != 1 || out[12 + 9] != 8 || !isnan(out[12 + 10]), "aligned union column 2");
+        FAIL_IF(!isnan(out[24 + 3]) || out[24 + 4] != 1 || out[24 + 11] != 8, "aligned union column 3");
+
+        /* disjoint ranges have an empty intersection */
+        CHECK_SUCCESS(de_axis_range(de, 2, freq_monthly, d + 20, &ax));
+        CHECK_SUCCESS(de_store_tseries(de, cata, "d", type_tseries, type_float, freq_none, ax, 2 * sizeof(double), vals, &ids[3]));
+        nbytes = sizeof out;
+        CHECK_SUCCESS(de_load_aligned(de, 4, ids, align_intersection, &axis, NULL, &nbytes, out));
+        FAIL_IF(axis.length != 0 || nbytes != 0, "aligned empty intersection");
+
+        /* incompatible series */
+        CHECK_SUCCESS(de_pack_year_period_date(freq_quarterly, 2000, 1, &d));
+        CHECK_SUCCESS(de_axis_range(de, 2, freq_quarterly, d, &ax));
+        CHECK_SUCCESS(de_store_tseries(de, cata, "q", type_tseries, type_float, freq_none, ax, 2 * sizeof(double), vals, &ids[3]));
+        CHECK(de_load_aligned(de, 4, ids, align_union, &axis, NULL, &nbytes, out), DE_BAD_FREQ);
+        int64_t ivals[2] = {1, 2};
+        CHECK_SUCCESS(de_pack_year_period_date(freq_monthly, 2000, 1, &d));
+        CHECK_SUCCESS(de_axis_range(de, 2, freq_monthly, d, &ax));
+        CHECK_SUCCESS(de_store_tseries(de, cata, "i", type_tseries, type_signed, freq_none, ax, sizeof ivals, ivals, &ids[3]));
+        CHECK(de_load_aligned(de, 4, ids, align_union, &axis, NULL, &nbytes, out), DE_BAD_ELTYPE);
+        CHECK_SUCCESS(de_axis_plain(de, 2, &ax));
+        CHECK_SUCCESS(de_store_tseries(de, cata, "p", type_tseries, type_float, freq_none, ax, 2 * sizeof(double), vals, &ids[3]));
+        CHECK(de_load_aligned(de, 4, ids, align_union, &axis, NULL, &nbytes, out), DE_BAD_AXIS_TYPE);
+        ids[3] = cata;
+        CHECK(de_load_aligned(de, 4, ids, align_union, &axis, NULL, &nbytes, out), DE_BAD_CLASS);
+        ids[3] = 1000000;
+        CHECK(de_load_aligned(de, 4, ids, align_union, &axis, NULL, &nbytes, out), DE_OBJ_DNE);
+        CHECK(de_load_aligned(de, 0, ids, align_union, &axis, NULL, &nbytes, out), DE_ARG);
+    }
+
+    /* test type-converting loads */
+    {
+        obj_id_t cata, id_f, id_i, id_u;
+        CHECK_SUCCESS(de_new_catalog(de, 0, "convert", &cata));
+        axis_id_t ax;
+        CHECK_SUCCESS(de_axis_plain(de, 5, &ax));
+
+        const double fvals[5] = {1.5, -2.75, 300.0, NAN, 1e40};
+        const int16_t ivals[5] = {-1, 2, -300, 127, 32767};
+        const uint32_t uvals[5] = {0, 1, 255, 65536, 4294967295u};
+        CHECK_SUCCESS(de_store_tseries(de, cata, "f", type_vector, type_float, freq_none, ax, sizeof fvals, fvals, &id_f));
+        CHECK_SUCCESS(de_store_tseries(de, cata, "i", type_vector, type_signed, freq_none, ax, sizeof ivals, ivals, &id_i));
+        CHECK_SUCCESS(de_store_tseries(de, cata, "u", type_vector, type_unsigned, freq_none, ax, sizeof uvals, uvals, &id_u));
+
+        int64_t nbytes = -1;
+        CHECK_SUCCESS(de_load_tseries_as(de, id_i, type_float, 8, &nbytes, NULL));
+        FAIL_IF(nbytes != 5 * sizeof(double), "converted size");
+        nbytes = 8;
+        double d[5];
+        CHECK(de_load_tseries_as(de, id_i, type_float, 8, &nbytes, d), DE_SHORT_BUF);
+
+        /* widening is exact */
+        nbytes = sizeof d;
+        CHECK_SUCCESS(de_load_tseries_as(de, id_i, type_float, 8, &nbytes, d));
+        for (int i = 0; i < 5; ++i)
+            FAIL_IF(d[i] != ivals[i], "int16 to float64");
+        CHECK_SUCCESS(de_load_tseries_as(de, id_u, type_float, 8, &nbytes, d));
+        for (int i = 0; i < 5; ++i)
+            FAIL_IF(d[i] != uvals[i], "uint32 to float64");
+        int64_t i8[5];
+        nbytes = sizeof i8;
+        CHECK_SUCCESS(de_load_tseries_as(de, id_u, type_signed, 8, &nbytes, i8));
+        FAIL_IF(i8[4] != 4294967295, "uint32 to int64");
+
+        /* narrowing rejects values with elements out of range, leaving the buffer alone */
+        int8_t i1[5] = {9, 9, 9, 9, 9};
+        nbytes = sizeof i1;
+        CHECK(de_load_tseries_as(de, id_i, type_signed, 1, &nbytes, i1), DE_RANGE);
+        for (int i = 0; i < 5; ++i)
+            FAIL_IF(i1[i] != 9, "int16 to int8");
+        uint16_t u2[5] = {9, 9, 9, 9, 9};
+        nbytes = sizeof u2;
+        CHECK(de_load_tseries_as(de, id_i, type_unsigned, 2, &nbytes, u2), DE_RANGE);
+        FAIL_IF(u2[1] != 9 || u2[4] != 9, "int16 to uint16");
+        int32_t i4[5] = {9, 9, 9, 9, 9};
+        nbytes = sizeof i4;
+        CHECK(de_load_tseries_as(de, id_f, type_signed, 4, &nbytes, i4), DE_RANGE);
+        FAIL_IF(i4[0] != 9 || i4[3] != 9, "float64 to int32");
+        float f4[5] = {9, 9, 9, 9, 9};
+        nbytes = sizeof f4;
+        CHECK(de_load_tseries_as(de, id_f, type_float, 4, &nbytes, f4), DE_RANGE);
+        FAIL_IF(f4[0] != 9 || f4[4] != 9, "float64 to float32");
+        nbytes = sizeof u2;
+        CHECK(de_load_tseries_as(de, id_u, type_unsigned, 2, &nbytes, u2), DE_RANGE);
+        FAIL_IF(u2[3] != 9, "uint32 to uint16");
+
+        /* narrowing succeeds when every element fits, NaN stays NaN between floats */
+        const double gvals[5] = {1.5, -2.75, 300.0, NAN, 1e30};
+        obj_id_t id_g;
+        CHECK_SUCCESS(de_store_tseries(de, cata, "g", type_vector, type_float, freq_none, ax, sizeof gvals, gvals, &id_g));
+        nbytes = sizeof f4;
+        CHECK_SUCCESS(de_load_tseries_as(de, id_g, type_float, 4, &nbytes, f4));
+        FAIL_IF(f4[0] != 1.5f || f4[2] != 300.0f || !isnan(f4[3]) || isinf(f4[4]), "float64 to float32");
+        const int16_t jvals[5] = {-1, 2, -100, 127, -128};
+        obj_id_t id_j;
+        CHECK_SUCCESS(de_store_tseries(de, cata, "j", type_vector, type_signed, freq_none, ax, sizeof jvals, jvals, &id_j));
+        nbytes = sizeof i1;
+        CHECK_SUCCESS(de_load_tseries_as(de, id_j, type_signed, 1, &nbytes, i1));
+        for (int i = 0; i < 5; ++i)
+            FAIL_IF(i1[i] != jvals[i], "int16 to int8");
+        CHECK(de_load_tseries_as(de, id_j, type_unsigned, 1, &nbytes, i1), DE_RANGE);
+
+        /* bad types and sizes */
+        CHECK(de_load_tseries_as(de, id_f, type_string, 8, &nbytes, d), DE_BAD_ELTYPE);
+        CHECK(de_load_tseries_as(de, id_f, type_float, 2, &nbytes, d), DE_ARG);
+        CHECK(de_load_tseries_as(de, id_f, type_signed, 3, &nbytes, d), DE_ARG);
+        CHECK(de_load_tseries_as(de, cata, type_float, 8, &nbytes, d), DE_BAD_CLASS);
+    }
+
+    /* test chunked storage and hyperslabs */
+    {
+        obj_id_t cata, id_mono, id_chunked, _id;
+        CHECK_SUCCESS(de_new_catalog(de, 0, "chunked", &cata));
+
+        /* 4 x 5 x 3 array whose elements are their own linear index */
+        const int64_t dims[3] = {4, 5, 3};
+        int32_t vals[60], out[60];
+        for (int i = 0; i < 60; ++i)
+            vals[i] = i;
+        axis_id_t ax[3];
+        for (int k = 0; k < 3; ++k)
+            CHECK_SUCCESS(de_axis_plain(de, dims[k], &ax[k]));
+        const int64_t chunk[3] = {3, 2, 2};
+        const int64_t bad_chunk[3] = {3, 0, 2};
+
+        CHECK(de_store_ndtseries_chunked(de, cata, "fail", type_ndtseries, type_signed, freq_none, 3, ax, bad_chunk, sizeof vals, vals, &_id), DE_ARG);
+        CHECK(de_store_ndtseries_chunked(de, cata, "fail", type_ndtseries, type_signed, freq_none, 3, ax, chunk, sizeof vals - 1, vals, &_id), DE_ARG);
+        CHECK(de_store_ndtseries_chunked(de, cata, "fail", type_ndtseries, type_signed, freq_none, 3, ax, NULL, sizeof vals, vals, &_id), DE_NULL);
+        CHECK(de_store_ndtseries_chunked(de, cata, "fail", type_ndtseries, type_string, freq_none, 3, ax, chunk, sizeof vals, vals, &_id), DE_BAD_ELTYPE);
+        CHECK(de_find_object(de, cata, "fail", &_id), DE_OBJ_DNE);
+
+        CHECK_SUCCESS(de_store_ndtseries(de, cata, "mono", type_ndtseries, type_signed, freq_none, 3, ax, sizeof vals, vals, &id_mono));
+        CHECK_SUCCESS(de_store_ndtseries_chunked(de, cata, "chunked", type_ndtseries, type_signed, freq_none, 3, ax, chunk, sizeof vals, vals, &id_chunked));
+
+        ndtseries_t data;
+        CHECK_SUCCESS(de_load_ndtseries(de, id_chunked, &data));
+        FAIL_IF(data.naxes != 3 || data.nbytes != sizeof vals || memcmp(data.value, vals, sizeof vals) != 0, "load chunked ndtseries");
+
+        int64_t nbytes;
+        const obj_id_t ids[2] = {id_mono, id_chunked};
+        for (int n = 0; n < 2; ++n)
+        {
+            const int64_t zero[3] = {0, 0, 0};
+            nbytes = sizeof out;
+            CHECK_SUCCESS(de_load_ndtseries_slice(de, ids[n], zero, dims, NULL, &nbytes, out));
+            FAIL_IF(nbytes != sizeof vals || memcmp(out, vals, sizeof vals) != 0, "full slice");
+
+            /* rows 1-3, columns 0, 2, 4, pages 1-2 */
+            const int64_t start[3] = {1, 0, 1}, count[3] = {3, 3, 2}, stride[3] = {1, 2, 1};
+            nbytes = -1;
+            CHECK_SUCCESS(de_load_ndtseries_slice(de, ids[n], start, count, stride, &nbytes, NULL));
+            FAIL_IF(nbytes != 18 * sizeof(int32_t), "slice size");
+            nbytes = 10;
+            CHECK(de_load_ndtseries_slice(de, ids[n], start, count, stride, &nbytes, out), DE_SHORT_BUF);
+            nbytes = sizeof out;
+            CHECK_SUCCESS(de_load_ndtseries_slice(de, ids[n], start, count, stride, &nbytes, out));
+            for (int i = 0; i < 3; ++i)
+                for (int j = 0; j < 3; ++j)
+                    for (int k = 0; k < 2; ++k)
+                        FAIL_IF(out[i + 3 * j + 9 * k] != (1 + i) + 4 * (2 * j) + 20 * (1 + k), "slice values");
+
+            /* strided along the first axis: rows 0 and 3 of the last page */
+            const int64_t start2[3] = {0, 4, 2}, count2[3] = {2, 1, 1}, stride2[3] = {3, 1, 1};
+            nbytes = sizeof out;
+            CHECK_SUCCESS(de_load_ndtseries_slice(de, ids[n], start2, count2, stride2, &nbytes, out));
+            FAIL_IF(nbytes != 2 * sizeof(int32_t) || out[0] != 56 || out[1] != 59, "strided slice");
+
+            const int64_t count3[3] = {4, 5, 4};
+            CHECK(de_load_ndtseries_slice(de, ids[n], zero, count3, NULL, &nbytes, out), DE_RANGE);
+            CHECK(de_load_ndtseries_slice(de, ids[n], start, count, zero, &nbytes, out), DE_RANGE);
+        }
+        CHECK(de_load_ndtseries_slice(de, cata, chunk, chunk, NULL, &nbytes, out), DE_BAD_CLASS);
+
+        /* chunked mvtseries */
+        mvtseries_t mv;
+        const int64_t mv_chunk[2] = {2, 100};
+        CHECK_SUCCESS(de_store_mvtseries_chunked(de, cata, "mv", type_mvtseries, type_signed, freq_none, ax[1], ax[0], mv_chunk, 20 * sizeof(int32_t), vals, &_id));
+        CHECK_SUCCESS(de_load_mvtseries(de, _id, &mv));
+        FAIL_IF(mv.nbytes != 20 * sizeof(int32_t) || memcmp(mv.value, vals, mv.nbytes) != 0, "load chunked mvtseries");
+
+        /* chunks are deleted with their object */
+        CHECK_SUCCESS(de_delete_object(de, id_chunked));
+        CHECK_SUCCESS(de_store_ndtseries_chunked(de, cata, "chunked", type_ndtseries, type_signed, freq_none, 3, ax, chunk, sizeof vals, vals, &id_chunked));
+        CHECK_SUCCESS(de_load_ndtseries(de, id_chunked, &data));
+        FAIL_IF(memcmp(data.value, vals, sizeof vals) != 0, "reload chunked ndtseries");
+    }
+
+    /* test streaming writers */
+    {
+        obj_id_t cata, _id;
+        CHECK_SUCCESS(de_new_catalog(de, 0, "stream", &cata));
+
+        double vals[60];
+        for (int i = 0; i < 60; ++i)
+            vals[i] = 0.5 * i;
+        axis_id_t ax60, ax4, ax5, ax3;
+        CHECK_SUCCESS(de_axis_plain(de, 60, &ax60));
+        CHECK_SUCCESS(de_axis_plain(de, 4, &ax4));
+        CHECK_SUCCESS(de_axis_plain(de, 5, &ax5));
+        CHECK_SUCCESS(de_axis_plain(de, 3, &ax3));
+
+        /* tseries, written in uneven pieces */
+        de_writer writer;
+        CHECK_SUCCESS(de_open_tseries_writer(de, cata, "ts", type_vector, type_float, freq_none, ax60, sizeof vals, &_id, &writer));
+        CHECK_SUCCESS(de_write_next(writer, 7 * sizeof(double), vals));
+        CHECK_SUCCESS(de_write_next(writer, 0, NULL));
+        CHECK_SUCCESS(de_write_next(writer, 50 * sizeof(double), vals + 7));
+        CHECK(de_write_next(writer, 4 * sizeof(double), vals + 57), DE_RANGE);
+        CHECK_SUCCESS(de_write_next(writer, 3 * sizeof(double), vals + 57));
+        CHECK_SUCCESS(de_close_writer(writer));
+        tseries_t ts;
+        CHECK_SUCCESS(de_load_tseries(de, _id, &ts));
+        FAIL_IF(ts.nbytes != sizeof vals || memcmp(ts.value, vals, sizeof vals) != 0, "streamed tseries");
+
+        /* mvtseries in chunks of 2 columns; pieces cross the chunk boundaries */
+        const int64_t mv_chunk[2] = {4, 2};
+        const int64_t bad_chunk[2] = {2, 2};
+        CHECK(de_open_mvtseries_writer(de, cata, "fail", type_mvtseries, type_float, freq_none, ax4, ax5, bad_chunk, 20 * sizeof(double), &_id, &writer), DE_ARG);
+        CHECK(de_find_object(de, cata, "fail", &_id), DE_OBJ_DNE);
+        CHECK_SUCCESS(de_open_mvtseries_writer(de, cata, "mv", type_mvtseries, type_float, freq_none, ax4, ax5, mv_chunk, 20 * sizeof(double), &_id, &writer));
+        for (int i = 0; i < 20; i += 3)
+            CHECK_SUCCESS(de_write_next(writer, (i + 3 <= 20 ? 3 : 20 - i) * sizeof(double), vals + i));
+        CHECK_SUCCESS(de_close_writer(writer));
+        mvtseries_t mv;
+        CHECK_SUCCESS(de_load_mvtseries(de, _id, &mv));
+        FAIL_IF(mv.nbytes != 20 * sizeof(double) || memcmp(mv.value, vals, mv.nbytes) != 0, "streamed chunked mvtseries");
+        double col[4];
+        const int64_t start[2] = {0, 4}, count[2] = {4, 1};
+        int64_t nbytes = sizeof col;
+        CHECK_SUCCESS(de_load_mvtseries_slice(de, _id, start, count, NULL, &nbytes, col));
+        FAIL_IF(memcmp(col, vals + 16, sizeof col) != 0, "slice of streamed mvtseries");
+
+        /* ndtseries in one piece; an incomplete value is reported and left as zeros */
+        const axis_id_t ax[3] = {ax4, ax5, ax3};
+        CHECK_SUCCESS(de_open_ndtseries_writer(de, cata, "nd", type_ndtseries, type_float, freq_none, 3, ax, NULL, sizeof vals, &_id, &writer));
+        CHECK_SUCCESS(de_write_next(writer, 30 * sizeof(double), vals));
+        CHECK(de_close_writer(writer), DE_ARG);
+        ndtseries_t nd;
+        CHECK_SUCCESS(de_load_ndtseries(de, _id, &nd));
+        FAIL_IF(nd.nbytes != sizeof vals || memcmp(nd.value, vals, 30 * sizeof(double)) != 0, "streamed ndtseries");
+        FAIL_IF(((const double *)nd.value)[59] != 0.0, "unwritten part of streamed ndtseries");
+        CHECK_SUCCESS(de_close_writer(NULL)); // harmless no-op
+    }
+
+    /* test streaming readers */
+    {
+        obj_id_t cata, id_ts, id_mv, id_nd, id_chunked;
+        CHECK_SUCCESS(de_find_object(de, 0, "stream", &cata));
+        CHECK_SUCCESS(de_find_object(de, cata, "ts", &id_ts));
+        CHECK_SUCCESS(de_find_object(de, cata, "mv", &id_mv));
+        CHECK_SUCCESS(de_find_object(de, cata, "nd", &id_nd));
+        CHECK_SUCCESS(de_find_object(de, 0, "chunked", &cata));
+        CHECK_SUCCESS(de_find_object(de, cata, "chunked", &id_chunked));
+
+        de_reader reader;
+        int64_t nbytes, total;
+        CHECK(de_open_reader(de, cata, &nbytes, &reader), DE_BAD_CLASS);
+        CHECK(de_open_reader(NULL, id_ts, &nbytes, &reader), DE_NULL);
+
+        /* read each object in windows of 13 bytes and compare with the whole value */
+        const obj_id_t ids[4] = {id_ts, id_mv, id_nd, id_chunked};
+        char all[512], window[13];
+        for (int n = 0; n < 4; ++n)
+        {
+            CHECK_SUCCESS(de_open_reader(de, ids[n], &total, &reader));
+            int64_t offset = 0;
+            do
+            {
+                nbytes = sizeof window;
+                CHECK_SUCCESS(de_read_next(reader, &nbytes, window));
+                FAIL_IF(offset + nbytes > (int64_t)sizeof all, "reader overflow");
+                memcpy(all + offset, window, nbytes);
+                offset += nbytes;
+            } while (nbytes == sizeof window);
+            nbytes = sizeof window;
+            CHECK_SUCCESS(de_read_next(reader, &nbytes, window));
+            FAIL_IF(nbytes != 0, "read past the end");
+            CHECK_SUCCESS(de_close_reader(reader));
+            FAIL_IF(offset != total, "reader size");
+
+            const void *value;
+            if (n == 0)
+            {
+                tseries_t ts;
+                CHECK_SUCCESS(de_load_tseries(de, ids[n], &ts));
+                FAIL_IF(ts.nbytes != total, "reader tseries size");
+                value = ts.value;
+            }
+            else if (n == 1)
+            {
+                mvtseries_t mv;
+                CHECK_SUCCESS(de_load_mvtseries(de, ids[n], &mv));
+                FAIL_IF(mv.nbytes != total, "reader mvtseries size");
+                value = mv.value;
+            }
+            else
+            {
+                ndtseries_t nd;
+                CHECK_SUCCESS(de_load_ndtseries(de, ids[n], &nd));
+                FAIL_IF(nd.nbytes != total, "reader ndtseries size");
+                value = nd.value;
+            }
+            FAIL_IF(memcmp(all, value, total) != 0, "reader values");
+        }
+        CHECK_SUCCESS(de_close_reader(NULL)); // harmless no-op
+    }
+
+    /* test files in the other byte order */
+    {
+        const static char swname[] = "test_swap.daec";
+        const char *order;
+        de_file sw;
+        unlink(swname);
+        CHECK_SUCCESS(de_open(swname, &sw));
+        CHECK_SUCCESS(de_get_attribute(sw, 0, "DE_BYTE_ORDER", &order));
+        const int little = strcmp(order, "little") == 0;
+        FAIL_IF(!little && strcmp(order, "big") != 0, "byte order attribute");
+        CHECK(de_set_byte_order(sw, "middle"), DE_ARG);
+        CHECK(de_set_byte_order(sw, little ? "little" : "big"), DE_EXISTS);
+        /* pretend the file was made on a host of the other byte order */
+        CHECK_SUCCESS(de_set_attribute(sw, 0, "DE_BYTE_ORDER", little ? "big" : "little"));
+        CHECK_SUCCESS(de_close(sw));
+        CHECK_SUCCESS(de_open(swname, &sw));
+
+        axis_id_t ax2, ax3;
+        CHECK_SUCCESS(de_axis_plain(sw, 2, &ax2));
+        CHECK_SUCCESS(de_axis_plain(sw, 3, &ax3));
+        obj_id_t id_sc, id_ts, id_nd;
+        const int32_t ival = 0x01020304;
+        const double dvals[2] = {1.0, -2.5};
+        const int16_t nvals[6] = {1, 2, 3, 0x0102, 5, 6};
+        const int64_t chunk[2] = {1, 2};
+        const axis_id_t ax[2] = {ax2, ax3};
+        CHECK_SUCCESS(de_store_scalar(sw, 0, "sc", type_integer, freq_none, sizeof ival, &ival, &id_sc));
+        CHECK_SUCCESS(de_store_tseries(sw, 0, "ts", type_vector, type_float, freq_none, ax2, sizeof dvals, dvals, &id_ts));
+        CHECK_SUCCESS(de_store_ndtseries_chunked(sw, 0, "nd", type_ndtseries, type_signed, freq_none, 2, ax, chunk, sizeof nvals, nvals, &id_nd));
+        date_t first, last, hol;
+        calendar_id_t cid;
+        CHECK_SUCCESS(de_pack_calendar_date(freq_daily, 2023, 7, 1, &first));
+        CHECK_SUCCESS(de_pack_calendar_date(freq_daily, 2023, 7, 31, &last));
+        CHECK_SUCCESS(de_pack_calendar_date(freq_daily, 2023, 7, 3, &hol));
+        CHECK_SUCCESS(de_store_calendar(sw, "july", first, last, 1, &hol, &cid));
+
+        /* streams swap whole elements */
+        de_writer writer;
+        de_reader reader;
+        obj_id_t id_st;
+        double draw[2];
+        int64_t nbytes = sizeof draw;
+        CHECK_SUCCESS(de_open_tseries_writer(sw, 0, "streamed", type_vector, type_float, freq_none, ax2, sizeof dvals, &id_st, &writer));
+        CHECK(de_write_next(writer, 4, dvals), DE_ARG);
+        CHECK_SUCCESS(de_write_next(writer, 8, dvals));
+        CHECK_SUCCESS(de_write_next(writer, 8, dvals + 1));
+        CHECK_SUCCESS(de_close_writer(writer));
+        CHECK_SUCCESS(de_open_reader(sw, id_ts, NULL, &reader));
+        nbytes = 12;
+        CHECK(de_read_next(reader, &nbytes, draw), DE_ARG);
+        nbytes = sizeof draw;
+        CHECK_SUCCESS(de_read_next(reader, &nbytes, draw));
+        CHECK_SUCCESS(de_close_reader(reader));
+        FAIL_IF(nbytes != sizeof draw || memcmp(draw, dvals, sizeof draw) != 0, "swapped stream");
+
+        /* values are loaded in the order of the host ... */
+        CHECK_SUCCESS(de_close(sw));
+        CHECK_SUCCESS(de_open(swname, &sw));
+        scalar_t scalar;
+        int32_t raw;
+        CHECK_SUCCESS(de_load_scalar(sw, id_sc, &scalar));
+        memcpy(&raw, scalar.value, sizeof raw);
+        FAIL_IF(raw != ival, "swapped scalar");
+        tseries_t ts;
+        CHECK_SUCCESS(de_load_tseries(sw, id_ts, &ts));
+        FAIL_IF(memcmp(ts.value, dvals, sizeof dvals) != 0, "swapped tseries");
+        float f[2];
+        nbytes = sizeof f;
+        CHECK_SUCCESS(de_load_tseries_as(sw, id_ts, type_float, 4, &nbytes, f));
+        FAIL_IF(f[0] != 1.0f || f[1] != -2.5f, "swapped converted tseries");
+        ndtseries_t nd;
+        CHECK_SUCCESS(de_load_ndtseries(sw, id_nd, &nd));
+        FAIL_IF(memcmp(nd.value, nvals, sizeof nvals) != 0, "swapped chunked ndtseries");
+        int16_t col[2];
+        const int64_t start[2] = {0, 1}, count[2] = {2, 1};
+        nbytes = sizeof col;
+        CHECK_SUCCESS(de_load_ndtseries_slice(sw, id_nd, start, count, NULL, &nbytes, col));
+        FAIL_IF(col[0] != 3 || col[1] != 0x0102, "swapped slice");
+        de_calendar cal;
+        int64_t ndays;
+        CHECK_SUCCESS(de_load_calendar(sw, cid, &cal));
+        CHECK_SUCCESS(de_calendar_info(cal, NULL, NULL, &ndays));
+        CHECK_SUCCESS(de_finalize_calendar(cal));
+        FAIL_IF(ndays != 20, "swapped calendar");
+
+        /* ... and stored swapped, which shows in the wrong byte order */
+        CHECK_SUCCESS(de_set_attribute(sw, 0, "DE_BYTE_ORDER", little ? "little" : "big"));
+        CHECK_SUCCESS(de_close(sw));
+        CHECK_SUCCESS(de_open(swname, &sw));
+        const obj_id_t streamed[2] = {id_ts, id_st};
+        for (int k = 0; k < 2; ++k)
+        {
+            nbytes = sizeof draw;
+            CHECK_SUCCESS(de_open_reader(sw, streamed[k], NULL, &reader));
+            CHECK_SUCCESS(de_read_next(reader, &nbytes, draw));
+            CHECK_SUCCESS(de_close_reader(reader));
+            for (int i = 0; i < 8; ++i)
+                FAIL_IF(((const char *)draw)[i] != ((const char *)dvals)[7 - i], "swapped bytes");
+        }
+        /* the holiday too, so it is lost */
+        CHECK_SUCCESS(de_load_calendar(sw, cid, &cal));
+        CHECK_SUCCESS(de_calendar_info(cal, NULL, NULL, &ndays));
+        CHECK_SUCCESS(de_finalize_calendar(cal));
+        FAIL_IF(ndays != 21, "calendar stored in the other byte order");
+        CHECK_SUCCESS(de_close(sw));
+        unlink(swname);
+    }
+
+    /* test deduplication of values */
+    {
+        de_file dd;
+        CHECK_SUCCESS(de_open_memory(&dd));
+        CHECK(de_set_dedup(NULL, 1), DE_NULL);
+        CHECK_SUCCESS(de_set_dedup(dd, 1));
+
+        axis_id_t ax4, ax2, axr;
+        CHECK_SUCCESS(de_axis_plain(dd, 4, &ax4));
+        CHECK_SUCCESS(de_axis_plain(dd, 2, &ax2));
+        CHECK_SUCCESS(de_axis_range(dd, 4, freq_quarterly, 100, &axr));
+        const double v1[4] = {1.0, 2.0, 3.0, 4.0};
+        const double v2[4] = {1.0, 2.0, 3.0, 5.0};
+        const double m[8] = {1.0, 2.0, 3.0, 4.0, 1.0, 2.0, 3.0, 5.0};
+        obj_id_t id_cat, id_a, id_b, id_c, id_q, id_m, id_nd;
+        CHECK_SUCCESS(de_new_catalog(dd, 0, "runs", &id_cat));
+        CHECK_SUCCESS(de_store_tseries(dd, id_cat, "a", type_vector, type_float, freq_none, ax4, sizeof v1, v1, &id_a));
+        CHECK_SUCCESS(de_store_tseries(dd, id_cat, "b", type_vector, type_float, freq_none, ax4, sizeof v1, v1, &id_b));
+        CHECK_SUCCESS(de_store_tseries(dd, 0, "c", type_vector, type_float, freq_none, ax4, sizeof v2, v2, &id_c));
+        CHECK_SUCCESS(de_store_tseries(dd, id_cat, "q", type_tseries, type_float, freq_none, axr, sizeof v1, v1, &id_q));
+        CHECK_SUCCESS(de_store_mvtseries(dd, 0, "m", type_matrix, type_float, freq_none, ax4, ax2, sizeof m, m, &id_m));
+        const axis_id_t axes[2] = {ax4, ax2};
+        CHECK_SUCCESS(de_store_ndtseries(dd, 0, "nd", type_ndtseries, type_float, freq_none, 2, axes, sizeof m, m, &id_nd));
+
+        int64_t nblobs, nbytes, nrefs;
+        CHECK_SUCCESS(de_dedup_stats(dd, &nblobs, &nbytes, &nrefs));
+        FAIL_IF(nblobs != 3 || nbytes != sizeof v1 + sizeof v2 + sizeof m || nrefs != 6, "dedup stats");
+
+        /* shared values load like any other */
+        tseries_t ts;
+        CHECK_SUCCESS(de_load_tseries(dd, id_b, &ts));
+        FAIL_IF(ts.nbytes != sizeof v1 || memcmp(ts.value, v1, sizeof v1) != 0, "shared tseries");
+        CHECK_SUCCESS(de_load_tseries(dd, id_c, &ts));
+        FAIL_IF(ts.nbytes != sizeof v2 || memcmp(ts.value, v2, sizeof v2) != 0, "shared tseries");
+        ndtseries_t nd;
+        CHECK_SUCCESS(de_load_ndtseries(dd, id_nd, &nd));
+        FAIL_IF(nd.nbytes != sizeof m || memcmp(nd.value, m, sizeof m) != 0, "shared ndtseries");
+        double row[2];
+        const int64_t start[2] = {3, 0}, count[2] = {1, 2};
+        nbytes = sizeof row;
+        CHECK_SUCCESS(de_load_mvtseries_slice(dd, id_m, start, count, NULL, &nbytes, row));
+        FAIL_IF(row[0] != 4.0 || row[1] != 5.0, "shared mvtseries slice");
+        de_reader reader;
+        double buf[4];
+        nbytes = sizeof buf;
+        CHECK_SUCCESS(de_open_reader(dd, id_a, NULL, &reader));
+        CHECK_SUCCESS(de_read_next(reader, &nbytes, buf));
+        CHECK_SUCCESS(de_close_reader(reader));
+        FAIL_IF(nbytes != sizeof v1 || memcmp(buf, v1, sizeof v1) != 0, "shared value reader");
+
+        /* mixed with a value that isn't shared */
+        obj_id_t id_u, ids[2];
+        CHECK_SUCCESS(de_set_dedup(dd, 0));
+        CHECK_SUCCESS(de_store_tseries(dd, 0, "u", type_tseries, type_float, freq_none, axr, sizeof v2, v2, &id_u));
+        ids[0] = id_u;
+        ids[1] = id_q;
+        axis_t axis;
+        double al[8];
+        nbytes = sizeof al;
+        CHECK_SUCCESS(de_load_aligned(dd, 2, ids, align_intersection, &axis, NULL, &nbytes, al));
+        FAIL_IF(memcmp(al, v2, sizeof v2) != 0 || memcmp(al + 4, v1, sizeof v1) != 0, "aligned shared values");
+        CHECK_SUCCESS(de_dedup_stats(dd, &nblobs, NULL, &nrefs));
+        FAIL_IF(nblobs != 3 || nrefs != 6, "unshared value not counted");
+
+        /* blobs go away with the last reference, also when catalogs are deleted */
+        CHECK_SUCCESS(de_delete_object(dd, id_c));
+        CHECK_SUCCESS(de_dedup_stats(dd, &nblobs, NULL, &nrefs));
+        FAIL_IF(nblobs != 2 || nrefs != 5, "dedup stats after delete");
+        CHECK_SUCCESS(de_delete_object(dd, id_a));
+        CHECK_SUCCESS(de_dedup_stats(dd, &nblobs, NULL, &nrefs));
+        FAIL_IF(nblobs != 2 || nrefs != 4, "dedup stats after delete");
+        CHECK_SUCCESS(de_delete_object(dd, id_cat));
+        CHECK_SUCCESS(de_dedup_stats(dd, &nblobs, &nbytes, &nrefs));
+        FAIL_IF(nblobs != 1 || nbytes != sizeof m || nrefs != 2, "dedup stats after delete");
+        CHECK_SUCCESS(de_delete_object(dd, id_m));
+        CHECK_SUCCESS(de_delete_object(dd, id_nd));
+        CHECK_SUCCESS(de_dedup_stats(dd, &nblobs, &nbytes, &nrefs));
+        FAIL_IF(nblobs != 0 || nbytes != 0 || nrefs != 0, "dedup stats after delete");
+        CHECK_SUCCESS(de_close(dd));
+    }
+
+    /* test vintages */
+    {
+        de_file dv;
+        CHECK_SUCCESS(de_open_memory(&dv));
+        enum
+        {
+            NV = 40,
+            LEN = 50,
+        };
+        /* each vintage adds an observation and revises the last two */
+        static double hist[NV][LEN + NV];
+        for (int v = 0; v < NV; ++v)
+            for (int i = 0; i < LEN + v; ++i)
+                hist[v][i] = (v > 0 && i < LEN + v - 3) ? hist[v - 1][i] : 1000.0 * v + i;
+        /* one vintage that changes everything */
+        for (int i = 0; i < LEN + 20; ++i)
+            hist[20][i] = -i;
+        for (int v = 21; v < NV; ++v)
+            for (int i = 0; i < LEN + v - 3; ++i)
+                hist[v][i] = hist[v - 1][i];
+
+        obj_id_t id;
+        axis_id_t ax;
+        tseries_t ts;
+        CHECK_SUCCESS(de_axis_range(dv, LEN, freq_quarterly, 100, &ax));
+        CHECK_SUCCESS(de_store_tseries(dv, 0, "gdp", type_tseries, type_float, freq_none, ax, 0, NULL, &id));
+        CHECK(de_load_tseries_asof(dv, id, 1000, &ts), DE_OBJ_DNE);
+        for (int v = 0; v < NV; ++v)
+        {
+            /* the history may go in the shared store of values */
+            if (v == NV / 2)
+                CHECK_SUCCESS(de_set_dedup(dv, 1));
+            CHECK_SUCCESS(de_axis_range(dv, LEN + v, freq_quarterly, 100, &ax));
+            CHECK_SUCCESS(de_append_vintage(dv, id, 1000 + 10 * v, ax, (LEN + v) * sizeof(double), hist[v]));
+        }
+        CHECK(de_append_vintage(dv, id, 1000 + 10 * (NV - 1), ax, 0, NULL), DE_ARG);
+        CHECK(de_append_vintage(dv, 0, 5000, ax, 0, NULL), DE_BAD_CLASS);
+
+        /* the value of the object is the last vintage */
+        CHECK_SUCCESS(de_load_tseries(dv, id, &ts));
+        FAIL_IF(ts.axis.length != LEN + NV - 1 || memcmp(ts.value, hist[NV - 1], ts.nbytes) != 0, "last vintage");
+        CHECK(de_load_tseries_asof(dv, id, 999, &ts), DE_OBJ_DNE);
+        for (int v = 0; v < NV; ++v)
+        {
+            for (int dt = 0; dt < 10; dt += 9)
+            {
+                CHECK_SUCCESS(de_load_tseries_asof(dv, id, 1000 + 10 * v + dt, &ts));
+                FAIL_IF(ts.eltype != type_float || ts.axis.length != LEN + v || ts.axis.first != 100 ||
+                            ts.nbytes != (LEN + v) * (int64_t)sizeof(double) ||
+                            memcmp(ts.value, hist[v], ts.nbytes) != 0,
+                        "vintage as of");
+            }
+        }
+        CHECK_SUCCESS(de_close(dv));
+    }
+
+    /* test copying subtrees between files */
+    {
+        const static char srcname[] = "test_copy.daec";
+        de_file src, dst, mem;
+        unlink(srcname);
+        CHECK_SUCCESS(de_open(srcname, &src));
+        CHECK_SUCCESS(de_open_memory(&dst));
+        CHECK_SUCCESS(de_set_dedup(src, 1));
+
+        obj_id_t id_top, id_sub, id_sc, id_ts, id_tw, id_mv, id_nd, id;
+        axis_id_t ax3, ax4, axr;
+        const int32_t ival = 42;
+        const double v[12] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+        const int64_t chunk[2] = {2, 2};
+        CHECK_SUCCESS(de_axis_plain(src, 3, &ax3));
+        CHECK_SUCCESS(de_axis_plain(src, 4, &ax4));
+        CHECK_SUCCESS(de_axis_range(src, 4, freq_monthly, 200, &axr));
+        CHECK_SUCCESS(de_new_catalog(src, 0, "top", &id_top));
+        CHECK_SUCCESS(de_new_catalog(src, id_top, "sub", &id_sub));
+        CHECK_SUCCESS(de_set_attribute(src, id_sub, "note", "copied"));
+        CHECK_SUCCESS(de_store_scalar(src, id_top, "sc", type_integer, freq_none, sizeof ival, &ival, &id_sc));
+        CHECK_SUCCESS(de_store_tseries(src, id_sub, "ts", type_tseries, type_float, freq_none, axr, 4 * sizeof(double), v, &id_ts));
+        CHECK_SUCCESS(de_store_tseries(src, id_sub, "twin", type_tseries, type_float, freq_none, axr, 4 * sizeof(double), v, &id_tw));
+        CHECK_SUCCESS(de_append_vintage(src, id_tw, 1, axr, 4 * sizeof(double), v + 4));
+        CHECK_SUCCESS(de_append_vintage(src, id_tw, 2, axr, 4 * sizeof(double), v));
+        CHECK_SUCCESS(de_store_mvtseries_chunked(src, id_top, "mv", type_matrix, type_float, freq_none, ax4, ax3, chunk, sizeof v, v, &id_mv));
+        const axis_id_t axes[2] = {ax3, ax4};
+        CHECK_SUCCESS(de_store_ndtseries(src, id_sub, "nd", type_ndtseries, type_float, freq_none, 2, axes, sizeof v, v, &id_nd));
+
+        /* errors */
+        CHECK(de_copy_subtree(NULL, id_top, dst, 0, "copy", &id), DE_NULL);
+        CHECK(de_copy_subtree(src, id_top, dst, 0, "a/b", &id), DE_BAD_NAME);
+        CHECK(de_copy_subtree(src, id_top, src, 0, "top", &id), DE_EXISTS);
+        CHECK(de_copy_subtree(src, id_top, src, id_sub, "again", &id), DE_ARG);
+        CHECK(de_copy_subtree(src, id_top, src, id_sc, "copy", &id), DE_BAD_CLASS);
+        CHECK_SUCCESS(de_open_memory(&mem));
+        CHECK(de_copy_subtree(mem, 0, dst, 0, "copy", &id), DE_ARG);
+        CHECK_SUCCESS(de_close(mem));
+
+        /* an axis that is already there is reused */
+        axis_id_t dax;
+        CHECK_SUCCESS(de_axis_plain(dst, 7, &dax));
+        CHECK_SUCCESS(de_axis_plain(dst, 4, &dax));
+        obj_id_t id_pub;
+        CHECK_SUCCESS(de_new_catalog(dst, 0, "pub", &id_pub));
+        CHECK_SUCCESS(de_copy_subtree(src, id_top, dst, id_pub, "copy", &id));
+
+        const char *path;
+        int64_t depth, n;
+        CHECK_SUCCESS(de_find_fullpath(dst, "/pub/copy/sub/ts", &id));
+        CHECK_SUCCESS(de_get_object_info(dst, id, &path, &depth, NULL));
+        FAIL_IF(depth != 4 || strcmp(path, "/pub/copy/sub/ts") != 0, "copied object info");
+        tseries_t ts;
+        CHECK_SUCCESS(de_load_tseries(dst, id, &ts));
+        FAIL_IF(ts.axis.ax_type != axis_range || ts.axis.first != 200 || ts.axis.frequency != freq_monthly ||
+                    memcmp(ts.value, v, 4 * sizeof(double)) != 0,
+                "copied tseries");
+        CHECK_SUCCESS(de_find_fullpath(dst, "/pub/copy/sub/twin", &id));
+        CHECK_SUCCESS(de_load_tseries_asof(dst, id, 1, &ts));
+        FAIL_IF(memcmp(ts.value, v + 4, 4 * sizeof(double)) != 0, "copied vintages");
+        int64_t nrefs;
+        CHECK_SUCCESS(de_dedup_stats(dst, &n, NULL, &nrefs));
+        FAIL_IF(n != 2 || nrefs != 3, "copied shared values");
+        const char *note;
+        CHECK_SUCCESS(de_find_fullpath(dst, "/pub/copy/sub", &id));
+        CHECK_SUCCESS(de_get_attribute(dst, id, "note", &note));
+        FAIL_IF(strcmp(note, "copied") != 0, "copied attribute");
+        scalar_t scalar;
+        CHECK_SUCCESS(de_find_fullpath(dst, "/pub/copy/sc", &id));
+        CHECK_SUCCESS(de_load_scalar(dst, id, &scalar));
+        FAIL_IF(*(const int32_t *)scalar.value != ival, "copied scalar");
+        mvtseries_t mv;
+        CHECK_SUCCESS(de_find_fullpath(dst, "/pub/copy/mv", &id));
+        CHECK_SUCCESS(de_load_mvtseries(dst, id, &mv));
+        FAIL_IF(mv.axis1.id != dax || mv.nbytes != sizeof v || memcmp(mv.value, v, sizeof v) != 0, "copied chunked mvtseries");
+        ndtseries_t nd;
+        CHECK_SUCCESS(de_find_fullpath(dst, "/pub/copy/sub/nd", &id));
+        CHECK_SUCCESS(de_load_ndtseries(dst, id, &nd));
+        FAIL_IF(nd.naxes != 2 || nd.axis[0].length != 3 || nd.axis[1].id != dax ||
+                    memcmp(nd.value, v, sizeof v) != 0,
+                "copied ndtseries");
+
+        /* a copy within the same file, of a single object */
+        CHECK_SUCCESS(de_copy_subtree(src, id_ts, src, 0, "ts", &id));
+        CHECK_SUCCESS(de_load_tseries(src, id, &ts));
+        FAIL_IF(ts.axis.id != axr || memcmp(ts.value, v, 4 * sizeof(double)) != 0, "copy in the same file");
+        CHECK_SUCCESS(de_get_object_info(src, id, &path, &depth, NULL));
+        FAIL_IF(depth != 1 || strcmp(path, "/ts") != 0, "copy in the same file");
+        /* new ids follow the largest one in use */
+        obj_id_t id2;
+        CHECK_SUCCESS(de_copy_subtree(src, id_ts, src, 0, "ts2", &id2));
+        FAIL_IF(id2 != id + 1, "id of a copy");
+
+        /* the whole source file */
+        CHECK_SUCCESS(de_copy_subtree(src, 0, dst, 0, "all", &id));
+        CHECK_SUCCESS(de_catalog_size(dst, id, &n));
+        FAIL_IF(n != 3, "copy of the root");
+        CHECK_SUCCESS(de_find_fullpath(dst, "/all/top/sub/nd", &id));
+        CHECK_SUCCESS(de_close(dst));
+        CHECK_SUCCESS(de_close(src));
+        unlink(srcname);
+    }
+
+    /* test merging files */
+    {
+        const static char aname[] = "test_merge_a.daec";
+        const static char bname[] = "test_merge_b.daec";
+        de_file a, b, dst;
+        unlink(aname);
+        unlink(bname);
+        CHECK_SUCCESS(de_open(aname, &a));
+        CHECK_SUCCESS(de_open(bname, &b));
+
+        obj_id_t id, id_data, id_only;
+        axis_id_t ax;
+        const double va[3] = {1, 2, 3}, vb[3] = {4, 5, 6};
+        const int32_t ival = 7;
+        CHECK_SUCCESS(de_new_catalog(a, 0, "data", &id_data));
+        CHECK_SUCCESS(de_set_attribute(a, id_data, "source", "a"));
+        CHECK_SUCCESS(de_axis_plain(a, 3, &ax));
+        CHECK_SUCCESS(de_store_tseries(a, id_data, "y", type_tseries, type_float, freq_none, ax, sizeof va, va, NULL));
+        CHECK_SUCCESS(de_store_scalar(a, id_data, "x", type_integer, freq_none, sizeof ival, &ival, NULL));
+        CHECK_SUCCESS(de_store_scalar(a, 0, "common", type_integer, freq_none, sizeof ival, &ival, NULL));
+
+        CHECK_SUCCESS(de_new_catalog(b, 0, "data", &id_data));
+        CHECK_SUCCESS(de_set_attribute(b, id_data, "source", "b"));
+        CHECK_SUCCESS(de_set_attribute(b, id_data, "extra", "1"));
+        CHECK_SUCCESS(de_axis_plain(b, 3, &ax));
+        CHECK_SUCCESS(de_store_tseries(b, id_data, "y", type_tseries, type_float, freq_none, ax, sizeof vb, vb, NULL));
+        CHECK_SUCCESS(de_store_scalar(b, id_data, "y~1", type_integer, freq_none, sizeof ival, &ival, NULL));
+        CHECK_SUCCESS(de_store_scalar(b, id_data, "z", type_integer, freq_none, sizeof ival, &ival, NULL));
+        CHECK_SUCCESS(de_new_catalog(b, 0, "common", NULL));
+        CHECK_SUCCESS(de_new_catalog(b, 0, "only", &id_only));
+        CHECK_SUCCESS(de_store_tseries(b, id_only, "w", type_tseries, type_float, freq_none, ax, sizeof vb, vb, NULL));
+
+        /* errors */
+        int64_t nconflicts;
+        CHECK(de_merge(NULL, a, merge_skip, &nconflicts), DE_NULL);
+        CHECK(de_merge(a, a, merge_skip, &nconflicts), DE_ARG);
+        CHECK(de_merge(b, a, (merge_mode_t)7, &nconflicts), DE_ARG);
+
+        const char *note;
+        tseries_t ts;
+        const merge_mode_t modes[3] = {merge_skip, merge_overwrite, merge_rename};
+        for (int m = 0; m < 3; ++m)
+        {
+            CHECK_SUCCESS(de_open_memory(&dst));
+            CHECK_SUCCESS(de_merge(a, dst, modes[m], &nconflicts));
+            FAIL_IF(nconflicts != 0, "merge into an empty file");
+            CHECK_SUCCESS(de_merge(b, dst, modes[m], &nconflicts));
+            FAIL_IF(nconflicts != 2, "merge conflicts");
+            CHECK_SUCCESS(de_find_fullpath(dst, "/data/x", &id));
+            CHECK_SUCCESS(de_find_fullpath(dst, "/data/z", &id));
+            CHECK_SUCCESS(de_find_fullpath(dst, "/data/y~1", &id));
+            CHECK_SUCCESS(de_find_fullpath(dst, "/only/w", &id));
+            CHECK_SUCCESS(de_load_tseries(dst, id, &ts));
+            FAIL_IF(memcmp(ts.value, vb, sizeof vb) != 0, "merged tseries");
+            CHECK_SUCCESS(de_find_fullpath(dst, "/data", &id));
+            CHECK_SUCCESS(de_get_attribute(dst, id, "extra", &note));
+            CHECK_SUCCESS(de_get_attribute(dst, id, "source", &note));
+            FAIL_IF(strcmp(note, modes[m] == merge_overwrite ? "b" : "a") != 0, "merged attributes");
+            CHECK_SUCCESS(de_find_fullpath(dst, "/data/y", &id));
+            CHECK_SUCCESS(de_load_tseries(dst, id, &ts));
+            FAIL_IF(memcmp(ts.value, modes[m] == merge_overwrite ? vb : va, sizeof va) != 0, "merge conflict on tseries");
+            CHECK_SUCCESS(de_find_fullpath(dst, "/common", &id));
+            object_t object;
+            CHECK_SUCCESS(de_load_object(dst, id, &object));
+            FAIL_IF(object.obj_class != (modes[m] == merge_overwrite ? class_catalog : class_scalar), "merge conflict on class");
+            if (modes[m] == merge_rename)
+            {
+                /* "y~1" is taken by an object of b */
+                CHECK_SUCCESS(de_find_fullpath(dst, "/data/y~2", &id));
+                CHECK_SUCCESS(de_load_tseries(dst, id, &ts));
+                FAIL_IF(memcmp(ts.value, vb, sizeof vb) != 0, "merge with rename");
+                CHECK_SUCCESS(de_find_fullpath(dst, "/common~1", &id));
+            }
+            else
+            {
+                CHECK(de_find_fullpath(dst, "/data/y~2", &id), DE_OBJ_DNE);
+                CHECK(de_find_fullpath(dst, "/common~1", &id), DE_OBJ_DNE);
+            }
+            CHECK_SUCCESS(de_close(dst));
+        }
+        CHECK_SUCCESS(de_close(b));
+        CHECK_SUCCESS(de_close(a));
+        unlink(aname);
+        unlink(bname);
+    }
+
+    /* test immutable files */
+    {
+        /* the name must be escaped in the URI */
+        const static char imname[] = "test_immutable%41.daec";
+        de_file im;
+        unlink(imname);
+        CHECK(de_open_immutable(imname, 0, &im), 14); /* sqlite3: unable to open database file*/
+        CHECK(de_open_immutable(NULL, 0, &im), DE_NULL);
+        CHECK_SUCCESS(de_open(imname, &im));
+        obj_id_t id;
+        axis_id_t ax;
+        const double v[3] = {1, 2, 3};
+        CHECK_SUCCESS(de_axis_plain(im, 3, &ax));
+        CHECK_SUCCESS(de_store_tseries(im, 0, "ts", type_tseries, type_float, freq_none, ax, sizeof v, v, NULL));
+        CHECK_SUCCESS(de_close(im));
+
+        for (int in_memory = 0; in_memory < 2; ++in_memory)
+        {
+            de_file im2;
+            CHECK_SUCCESS(de_open_immutable(imname, in_memory, &im));
+            CHECK_SUCCESS(de_open_immutable(imname, in_memory, &im2));
+            tseries_t ts;
+            CHECK_SUCCESS(de_find_fullpath(im, "/ts", &id));
+            CHECK_SUCCESS(de_load_tseries(im, id, &ts));
+            FAIL_IF(memcmp(ts.value, v, sizeof v) != 0, "load from an immutable file");
+            CHECK_SUCCESS(de_find_fullpath(im2, "/ts", &id));
+            CHECK(de_new_catalog(im, 0, "new", &id), 8); /* SQLITE_READONLY = 8 */
+            CHECK_SUCCESS(de_close(im2));
+            CHECK_SUCCESS(de_close(im));
+        }
+        unlink(imname);
+    }
+
+    /* test working on a copy in memory and saving it */
+    {
+        const static char wname[] = "test_work.daec";
+        const static char sname[] = "test_saved.daec";
+        de_file work, saved;
+        unlink(wname);
+        unlink(sname);
+        CHECK(de_open_file_in_memory(wname, &work), 14); /* sqlite3: unable to open database file*/
+        CHECK_SUCCESS(de_open(wname, &work));
+        obj_id_t id, id_cat;
+        axis_id_t ax;
+        double v[1000];
+        for (int i = 0; i < 1000; ++i)
+            v[i] = i;
+        CHECK_SUCCESS(de_axis_plain(work, 1000, &ax));
+        CHECK_SUCCESS(de_store_tseries(work, 0, "ts", type_tseries, type_float, freq_none, ax, sizeof v, v, NULL));
+        CHECK_SUCCESS(de_close(work));
+
+        CHECK_SUCCESS(de_open_file_in_memory(wname, &work));
+        CHECK_SUCCESS(de_find_fullpath(work, "/ts", &id));
+        CHECK_SUCCESS(de_new_catalog(work, 0, "many", &id_cat));
+        CHECK_SUCCESS(de_axis_plain(work, 1000, &ax));
+        for (int i = 0; i < 100; ++i)
+        {
+            char name[20];
+            sprintf(name, "ts%d", i);
+            v[0] = i;
+            CHECK_SUCCESS(de_store_tseries(work, id_cat, name, type_tseries, type_float, freq_none, ax, sizeof v, v, NULL));
+        }
+        /* the file itself is unchanged */
+        CHECK_SUCCESS(de_open_readonly(wname, &saved));
+        CHECK(de_find_fullpath(saved, "/many", &id), DE_OBJ_DNE);
+        CHECK_SUCCESS(de_close(saved));
+
+        CHECK(de_save_as(NULL, sname, NULL), DE_NULL);
+        CHECK(de_save_as(work, "./path/does/not/exist/file.daec", NULL), 14); /* SQLITE_CANTOPEN = 14 */
+        progress_calls = 0;
+        CHECK_SUCCESS(de_save_as(work, sname, count_progress));
+        FAIL_IF(progress_calls < 1 || progress_done != progress_total || progress_total < 1, "save progress");
+        /* save over the original, which may be open and then sees the new
+           content */
+        CHECK_SUCCESS(de_open_readonly(wname, &saved));
+        CHECK_SUCCESS(de_save_as(work, wname, NULL));
+        CHECK_SUCCESS(de_find_fullpath(saved, "/many", &id));
+        CHECK_SUCCESS(de_close(saved));
+        CHECK_SUCCESS(de_close(work));
+
+        const char *saved_names[2] = {sname, wname};
+        for (int i = 0; i < 2; ++i)
+        {
+            tseries_t ts;
+            CHECK_SUCCESS(de_open(saved_names[i], &saved));
+            CHECK_SUCCESS(de_find_fullpath(saved, "/many/ts99", &id));
+            CHECK_SUCCESS(de_load_tseries(saved, id, &ts));
+            FAIL_IF(((const double *)ts.value)[0] != 99 || ((const double *)ts.value)[999] != 999, "saved tseries");
+            CHECK_SUCCESS(de_close(saved));
+        }
+        unlink(wname);
+        unlink(sname);
+    }
+
+    /* test backups of a file in use */
+    {
+        const static char lname[] = "test_live.daec";
+        const static char bname[] = "test_backup.daec";
+        de_file live, backup;
+        unlink(lname);
+        unlink(bname);
+        CHECK_SUCCESS(de_open(lname, &live));
+        obj_id_t id;
+        axis_id_t ax;
+        double v[1000] = {0};
+        CHECK_SUCCESS(de_axis_plain(live, 1000, &ax));
+        for (int i = 0; i < 20; ++i)
+        {
+            char name[20];
+            sprintf(name, "ts%d", i);
+            v[0] = i;
+            CHECK_SUCCESS(de_store_tseries(live, 0, name, type_tseries, type_float, freq_none, ax, sizeof v, v, NULL));
+        }
+        CHECK(de_backup(NULL, bname, 8, 0, NULL), DE_NULL);
+        CHECK(de_backup(live, bname, 0, 0, NULL), DE_ARG);
+        CHECK(de_backup(live, bname, 8, -1, NULL), DE_ARG);
+
+        /* the backup starts over after the change by another connection and
+           includes it */
+        progress_calls = 0;
+        progress_writes = 1;
+        progress_writer_fname = lname;
+        CHECK_SUCCESS(de_backup(live, bname, 8, 1, write_progress));
+        FAIL_IF(progress_calls <= (progress_total + 7) / 8 || progress_done != progress_total, "backup progress");
+        CHECK_SUCCESS(de_open_readonly(bname, &backup));
+        CHECK_SUCCESS(de_find_fullpath(backup, "/written during backup", &id));
+        CHECK_SUCCESS(de_find_fullpath(backup, "/ts19", &id));
+        CHECK_SUCCESS(de_close(backup));
+
+        /* but not forever, if the changes go on */
+        progress_calls = 0;
+        progress_writes = 1000;
+        CHECK(de_backup(live, bname, 8, 0, write_progress), 5); /* SQLITE_BUSY = 5 */
+        FAIL_IF(progress_calls > 1000, "backup restarts");
+        CHECK_SUCCESS(de_open_readonly(bname, &backup));
+        CHECK(de_find_fullpath(backup, "/written during backup 2", &id), DE_OBJ_DNE);
+        CHECK_SUCCESS(de_close(backup));
+
+        /* nor while another connection holds a lock on either file */
+        {
+            de_file other;
+            CHECK_SUCCESS(de_open(lname, &other));
+            /* a transaction that outgrows the page cache takes an exclusive lock */
+            for (int i = 0; i < 1000; ++i)
+            {
+                char name[20];
+                sprintf(name, "locked%d", i);
+                CHECK_SUCCESS(de_store_tseries(other, 0, name, type_tseries, type_float, freq_none, ax, sizeof v, v, NULL));
+            }
+            CHECK(de_backup(live, bname, 8, 0, NULL), 5); /* SQLITE_BUSY = 5 */
+            CHECK_SUCCESS(de_close(other));
+            /* a reader of the backup keeps its lock while its last lookup is current */
+            CHECK_SUCCESS(de_open_readonly(bname, &backup));
+            CHECK_SUCCESS(de_find_fullpath(backup, "/ts19", &id));
+            CHECK(de_backup(live, bname, 8, 0, NULL), 5); /* SQLITE_BUSY = 5 */
+            CHECK(de_find_fullpath(backup, "/locked0", &id), DE_OBJ_DNE);
+            CHECK_SUCCESS(de_close(backup));
+            CHECK_SUCCESS(de_backup(live, bname, 8, 0, NULL));
+            CHECK_SUCCESS(de_open_readonly(bname, &backup));
+            CHECK_SUCCESS(de_find_fullpath(backup, "/locked999", &id));
+            CHECK_SUCCESS(de_close(backup));
+        }
+
+        /* the file is still in use */
+        CHECK_SUCCESS(de_find_fullpath(live, "/written during backup", &id));
+        CHECK_SUCCESS(de_store_tseries(live, 0, "after", type_tseries, type_float, freq_none, ax, sizeof v, v, NULL));
+        CHECK_SUCCESS(de_close(live));
+        unlink(lname);
+        unlink(bname);
+    }
+
+    /* test storage statistics and compaction */
+    {
+        const static char cname[] = "test_compact.daec";
+        const static char iname[] = "test_compact_into.daec";
+        de_file dc;
+        unlink(cname);
+        unlink(iname);
+        CHECK_SUCCESS(de_open(cname, &dc));
+        obj_id_t id, id_cat;
+        axis_id_t ax;
+        double v[1000] = {0};
+        CHECK_SUCCESS(de_axis_plain(dc, 1000, &ax));
+        CHECK_SUCCESS(de_new_catalog(dc, 0, "bulk", &id_cat));
+        for (int i = 0; i < 50; ++i)
+        {
+            char name[20];
+            sprintf(name, "ts%d", i);
+            CHECK_SUCCESS(de_store_tseries(dc, id_cat, name, type_tseries, type_float, freq_none, ax, sizeof v, v, NULL));
+        }
+        CHECK_SUCCESS(de_store_tseries(dc, 0, "kept", type_tseries, type_float, freq_none, ax, sizeof v, v, NULL));
+
+        storage_stats_t stats;
+        CHECK(de_storage_stats(NULL, &stats), DE_NULL);
+        CHECK(de_storage_stats(dc, NULL), DE_NULL);
+        CHECK_SUCCESS(de_storage_stats(dc, &stats));
+        FAIL_IF(stats.page_size <= 0 || stats.page_count * stats.page_size < 50 * (int64_t)sizeof v, "storage stats");
+        int64_t ts_bytes = 0, total = 0;
+        for (int64_t i = 0; i < stats.ntables; ++i)
+        {
+            total += stats.tables[i].nbytes;
+            if (strcmp(stats.tables[i].name, "tseries") == 0)
+                ts_bytes = stats.tables[i].nbytes;
+        }
+        FAIL_IF(ts_bytes < 50 * (int64_t)sizeof v || total > stats.page_count * stats.page_size, "storage of tables");
+
+        CHECK_SUCCESS(de_delete_object(dc, id_cat));
+        CHECK_SUCCESS(de_storage_stats(dc, &stats));
+        const int64_t pages_before = stats.page_count;
+        FAIL_IF(stats.free_pages < 50 * (int64_t)sizeof v / stats.page_size, "free pages after delete");
+
+        CHECK(de_compact(NULL, compact_full, NULL), DE_NULL);
+        CHECK(de_compact(dc, compact_into, NULL), DE_NULL);
+        CHECK(de_compact(dc, (compact_mode_t)7, NULL), DE_ARG);
+        CHECK_SUCCESS(de_compact(dc, compact_into, iname));
+        CHECK_SUCCESS(de_storage_stats(dc, &stats));
+        FAIL_IF(stats.page_count != pages_before, "compact into leaves the file as it is");
+        CHECK_SUCCESS(de_compact(dc, compact_full, NULL));
+        CHECK_SUCCESS(de_storage_stats(dc, &stats));
+        FAIL_IF(stats.free_pages != 0 || stats.page_count >= pages_before, "compact full");
+
+        /* the first incremental compaction turns it on */
+        CHECK_SUCCESS(de_compact(dc, compact_incremental, NULL));
+        CHECK_SUCCESS(de_storage_stats(dc, &stats));
+        FAIL_IF(stats.auto_vacuum != 2, "incremental auto_vacuum");
+        CHECK_SUCCESS(de_find_fullpath(dc, "/kept", &id));
+        CHECK_SUCCESS(de_delete_object(dc, id));
+        CHECK_SUCCESS(de_compact(dc, compact_incremental, NULL));
+        CHECK_SUCCESS(de_storage_stats(dc, &stats));
+        FAIL_IF(stats.free_pages != 0, "compact incremental");
+        CHECK_SUCCESS(de_close(dc));
+
+        CHECK_SUCCESS(de_open(iname, &dc));
+        CHECK_SUCCESS(de_find_fullpath(dc, "/kept", &id));
+        CHECK(de_find_fullpath(dc, "/bulk", &id), DE_OBJ_DNE);
+        CHECK_SUCCESS(de_storage_stats(dc, &stats));
+        FAIL_IF(stats.free_pages != 0 || stats.page_count >= pages_before, "compact into");
+        CHECK_SUCCESS(de_close(dc));
+        unlink(cname);
+        unlink(iname);
+    }
+
+    /* test statistics of catalogs, computed when asked for and then kept in the file */
+    for (int kept = 0; kept <= 1; ++kept)
+    {
+        de_file dc;
+        CHECK_SUCCESS(de_open_memory(&dc));
+        obj_id_t id_a, id_b, id;
+        axis_id_t ax_m, ax_q, ax_p;
+        date_t d;
+        double v[12] = {0};
+        CHECK_SUCCESS(de_new_catalog(dc, 0, "a", &id_a));
+        CHECK_SUCCESS(de_new_catalog(dc, id_a, "b", &id_b));
+        CHECK_SUCCESS(de_pack_year_period_date(freq_monthly, 2020, 1, &d));
+        CHECK_SUCCESS(de_axis_range(dc, 12, freq_monthly, d, &ax_m));
+        CHECK_SUCCESS(de_pack_year_period_date(freq_quarterly, 2019, 1, &d));
+        CHECK_SUCCESS(de_axis_range(dc, 4, freq_quarterly, d, &ax_q));
+        CHECK_SUCCESS(de_axis_plain(dc, 5, &ax_p));
+        CHECK_SUCCESS(de_store_tseries(dc, id_b, "m", type_tseries, type_float, freq_none, ax_m, 12 * sizeof(double), v, NULL));
+        CHECK_SUCCESS(de_store_tseries(dc, id_a, "q", type_tseries, type_float, freq_none, ax_q, 4 * sizeof(double), v, NULL));
+        CHECK_SUCCESS(de_store_tseries(dc, id_a, "p", type_tseries, type_float, freq_none, ax_p, 5 * sizeof(double), v, NULL));
+        CHECK_SUCCESS(de_store_scalar(dc, id_a, "s", type_float, freq_none, sizeof(double), v, &id));
+        if (kept)
+        {
+            CHECK(de_set_catalog_stats(NULL, 1), DE_NULL);
+            CHECK_SUCCESS(de_set_catalog_stats(dc, 1));
+            CHECK_SUCCESS(de_set_catalog_stats(dc, 1));
+        }
+
+        catalog_stats_t stats;
+        date_t first, last;
+        CHECK(de_catalog_stats(NULL, id_a, &stats), DE_NULL);
+        CHECK(de_catalog_stats(dc, id_a, NULL), DE_NULL);
+        CHECK(de_catalog_stats(dc, id, &stats), DE_BAD_CLASS);
+        CHECK_SUCCESS(de_catalog_stats(dc, id_b, &stats));
+        CHECK_SUCCESS(de_pack_calendar_date(freq_daily, 2020, 1, 1, &first));
+        CHECK_SUCCESS(de_pack_calendar_date(freq_daily, 2020, 12, 31, &last));
+        FAIL_IF(stats.count != 1 || stats.nbytes != 12 * sizeof(double), "catalog stats of /a/b");
+        FAIL_IF(!stats.dated || stats.first_day != first || stats.last_day != last, "date coverage of /a/b");
+        CHECK_SUCCESS(de_catalog_stats(dc, id_a, &stats));
+        CHECK_SUCCESS(de_pack_calendar_date(freq_daily, 2019, 1, 1, &first));
+        FAIL_IF(stats.count != 5 || stats.nbytes != 22 * sizeof(double), "catalog stats of /a");
+        FAIL_IF(!stats.dated || stats.first_day != first || stats.last_day != last, "date coverage of /a");
+        CHECK_SUCCESS(de_catalog_stats(dc, 0, &stats));
+        FAIL_IF(stats.count != 6 || stats.nbytes != 22 * sizeof(double), "catalog stats of the root");
+
+        /* deleting a subtree takes it out of every catalog above it */
+        CHECK_SUCCESS(de_delete_object(dc, id_b));
+        CHECK_SUCCESS(de_catalog_stats(dc, id_a, &stats));
+        CHECK_SUCCESS(de_pack_calendar_date(freq_daily, 2019, 12, 31, &last));
+        FAIL_IF(stats.count != 3 || stats.nbytes != 10 * sizeof(double), "catalog stats after delete");
+        FAIL_IF(!stats.dated || stats.first_day != first || stats.last_day != last, "date coverage after delete");
+        CHECK_SUCCESS(de_catalog_stats(dc, 0, &stats));
+        FAIL_IF(stats.count != 4 || stats.nbytes != 10 * sizeof(double), "root stats after delete");
+        CHECK_SUCCESS(de_find_fullpath(dc, "/a/q", &id));
+        CHECK_SUCCESS(de_delete_object(dc, id));
+        CHECK_SUCCESS(de_catalog_stats(dc, id_a, &stats));
+        FAIL_IF(stats.count != 2 || stats.nbytes != 6 * sizeof(double) || stats.dated, "no date coverage left");
+
+        /* shared values count for each object */
+        CHECK_SUCCESS(de_set_dedup(dc, 1));
+        CHECK_SUCCESS(de_new_catalog(dc, id_a, "c", &id));
+        CHECK_SUCCESS(de_store_tseries(dc, id, "x", type_tseries, type_float, freq_none, ax_m, 12 * sizeof(double), v, NULL));
+        CHECK_SUCCESS(de_store_tseries(dc, id, "y", type_tseries, type_float, freq_none, ax_m, 12 * sizeof(double), v, NULL));
+        CHECK_SUCCESS(de_catalog_stats(dc, id, &stats));
+        FAIL_IF(stats.count != 2 || stats.nbytes != 24 * sizeof(double), "catalog stats with shared values");
+        CHECK_SUCCESS(de_catalog_stats(dc, id_a, &stats));
+        FAIL_IF(stats.count != 5 || stats.nbytes != 30 * sizeof(double) || !stats.dated, "catalog stats of /a with shared values");
+        if (kept)
+        {
+            /* the same, computed again */
+            CHECK_SUCCESS(de_set_catalog_stats(dc, 0));
+            CHECK_SUCCESS(de_catalog_stats(dc, id_a, &stats));
+            FAIL_IF(stats.count != 5 || stats.nbytes != 30 * sizeof(double) || !stats.dated, "catalog stats no longer kept");
+        }
+        CHECK_SUCCESS(de_close(dc));
+    }
+
+    /* test garbage collection of axes */
+    {
+        de_file dc;
+        CHECK_SUCCESS(de_open_memory(&dc));
+        obj_id_t id_ts, id_mv;
+        axis_id_t ax_used, ax_rows, ax_cols, ax_vint, ax_unused, ax;
+        axis_t axis;
+        double v[12] = {0};
+        int64_t removed = -1;
+        CHECK(de_gc_axes(NULL, &removed), DE_NULL);
+        CHECK_SUCCESS(de_gc_axes(dc, NULL));
+        CHECK_SUCCESS(de_axis_plain(dc, 12, &ax_used));
+        CHECK_SUCCESS(de_axis_plain(dc, 3, &ax_rows));
+        CHECK_SUCCESS(de_axis_plain(dc, 4, &ax_cols));
+        CHECK_SUCCESS(de_axis_plain(dc, 6, &ax_vint));
+        CHECK_SUCCESS(de_axis_names(dc, 2, "a,b", &ax_unused));
+        CHECK_SUCCESS(de_store_tseries(dc, 0, "ts", type_tseries, type_float, freq_none, ax_used, sizeof v, v, &id_ts));
+        CHECK_SUCCESS(de_store_mvtseries(dc, 0, "mv", type_mvtseries, type_float, freq_none, ax_rows, ax_cols, sizeof v, v, &id_mv));
+        CHECK_SUCCESS(de_append_vintage(dc, id_ts, 1, ax_vint, 6 * sizeof(double), v));
+        CHECK_SUCCESS(de_append_vintage(dc, id_ts, 2, ax_used, sizeof v, v));
+        CHECK_SUCCESS(de_gc_axes(dc, &removed));
+        FAIL_IF(removed != 1, "unused axes removed");
+        CHECK(de_load_axis(dc, ax_unused, &axis), DE_AXIS_DNE);
+        CHECK_SUCCESS(de_load_axis(dc, ax_vint, &axis));
+
+        /* axes of deleted objects go with the next collection */
+        CHECK_SUCCESS(de_delete_object(dc, id_mv));
+        CHECK_SUCCESS(de_delete_object(dc, id_ts));
+        CHECK_SUCCESS(de_gc_axes(dc, &removed));
+        FAIL_IF(removed != 4, "axes of deleted objects removed");
+        CHECK_SUCCESS(de_gc_axes(dc, &removed));
+        FAIL_IF(removed != 0, "nothing left to remove");
+        CHECK_SUCCESS(de_axis_plain(dc, 12, &ax));
+        CHECK_SUCCESS(de_store_tseries(dc, 0, "ts", type_tseries, type_float, freq_none, ax, sizeof v, v, NULL));
+        CHECK_SUCCESS(de_close(dc));
+    }
+
+    /* test deleting large subtrees */
+    {
+        de_file dc;
+        CHECK_SUCCESS(de_open_memory(&dc));
+        CHECK_SUCCESS(de_set_dedup(dc, 1));
+        obj_id_t id_top, id_cat, id_ts, id;
+        axis_id_t ax_d, ax_n;
+        double v[12] = {0};
+        char name[16];
+        CHECK_SUCCESS(de_axis_range(dc, 12, freq_daily, 800000, &ax_d));
+        CHECK_SUCCESS(de_axis_plain(dc, 12, &ax_n));
+        CHECK_SUCCESS(de_store_tseries(dc, 0, "keep", type_tseries, type_float, freq_none, ax_n, sizeof v, v, NULL));
+        object_t object;
+        catalog_stats_t before, after;
+        int64_t nblobs_before, nblobs_after, nrefs, ndeleted = -1;
+        CHECK_SUCCESS(de_catalog_stats(dc, 0, &before));
+        CHECK_SUCCESS(de_dedup_stats(dc, &nblobs_before, NULL, NULL));
+
+        /* three catalogs of three series each, some of them shared with "keep" */
+        CHECK_SUCCESS(de_new_catalog(dc, 0, "top", &id_top));
+        for (int c = 0; c < 3; ++c)
+        {
+            sprintf(name, "c%d", c);
+            CHECK_SUCCESS(de_new_catalog(dc, id_top, name, &id_cat));
+            CHECK_SUCCESS(de_set_attribute(dc, id_cat, "c", name));
+            for (int i = 0; i < 3; ++i)
+            {
+                sprintf(name, "t%d", i);
+                v[0] = i;
+                if (i < 2)
+                    CHECK_SUCCESS(de_store_tseries(dc, id_cat, name, type_tseries, type_float, freq_daily, ax_d, sizeof v, v, &id_ts));
+                else
+                    CHECK_SUCCESS(de_store_tseries(dc, id_cat, name, type_tseries, type_float, freq_none, ax_n, sizeof v, v, &id_ts));
+                CHECK_SUCCESS(de_set_attribute(dc, id_ts, "i", name));
+            }
+        }
+        CHECK_SUCCESS(de_append_vintage(dc, id_ts, 1, ax_n, sizeof v, v));
+
+        CHECK(de_delete_subtree(NULL, id_top, NULL, NULL), DE_NULL);
+        CHECK(de_delete_subtree(dc, 0, NULL, NULL), DE_DEL_ROOT);
+        progress_calls = progress_done = progress_total = 0;
+        CHECK_SUCCESS(de_delete_subtree(dc, id_top, count_progress, &ndeleted));
+        FAIL_IF(ndeleted != 13, "number of deleted objects");
+        FAIL_IF(progress_calls == 0 || progress_done != progress_total, "progress of the delete");
+        CHECK(de_find_object(dc, 0, "top", &id), DE_OBJ_DNE);
+        CHECK(de_load_object(dc, id_ts, &object), DE_OBJ_DNE);
+        CHECK(de_delete_subtree(dc, id_top, NULL, NULL), DE_OBJ_DNE);
+
+        /* the catalogs above and the store of shared values are as they were */
+        CHECK_SUCCESS(de_catalog_stats(dc, 0, &after));
+        FAIL_IF(after.count != before.count || after.nbytes != before.nbytes || after.dated != before.dated,
+                "root stats after deleting a subtree");
+        CHECK_SUCCESS(de_dedup_stats(dc, &nblobs_after, NULL, &nrefs));
+        FAIL_IF(nblobs_after != nblobs_before || nrefs != 1, "shared values after deleting a subtree");
+
+        /* a single object is a subtree too */
+        CHECK_SUCCESS(de_find_object(dc, 0, "keep", &id));
+        CHECK_SUCCESS(de_delete_subtree(dc, id, NULL, &ndeleted));
+        FAIL_IF(ndeleted != 1, "deleting a single object");
+        CHECK_SUCCESS(de_catalog_stats(dc, 0, &after));
+        FAIL_IF(after.count != 0 || after.nbytes != 0, "root stats when empty");
+        CHECK_SUCCESS(de_close(dc));
+    }
+
+    /* test renaming and moving objects */
+    {
+        de_file dc;
+        CHECK_SUCCESS(de_open_memory(&dc));
+        obj_id_t id_a, id_b, id_c, id_x, id_y, id;
+        axis_id_t ax_d, ax_n;
+        double v[12] = {0};
+        const char *path;
+        int64_t depth;
+        catalog_stats_t stats;
+        CHECK_SUCCESS(de_set_catalog_stats(dc, 1));
+        CHECK_SUCCESS(de_axis_range(dc, 12, freq_daily, 800000, &ax_d));
+        CHECK_SUCCESS(de_axis_plain(dc, 12, &ax_n));
+        CHECK_SUCCESS(de_new_catalog(dc, 0, "a", &id_a));
+        CHECK_SUCCESS(de_new_catalog(dc, id_a, "b", &id_b));
+        CHECK_SUCCESS(de_new_catalog(dc, 0, "c", &id_c));
+        CHECK_SUCCESS(de_store_tseries(dc, id_b, "x", type_tseries, type_float, freq_daily, ax_d, sizeof v, v, &id_x));
+        CHECK_SUCCESS(de_store_tseries(dc, id_a, "y", type_tseries, type_float, freq_none, ax_n, sizeof v, v, &id_y));
+
+        CHECK(de_rename(NULL, id_a, "aa"), DE_NULL);
+        CHECK(de_rename(dc, id_a, NULL), DE_NULL);
+        CHECK(de_rename(dc, 0, "root"), DE_ARG);
+        CHECK(de_rename(dc, id_a, "a/a"), DE_BAD_NAME);
+        CHECK(de_rename(dc, id_a, "c"), DE_EXISTS);
+        CHECK_SUCCESS(de_rename(dc, id_a, "a"));
+
+        /* the paths of everything under a renamed catalog change with it */
+        CHECK_SUCCESS(de_rename(dc, id_a, "aa"));
+        CHECK(de_find_fullpath(dc, "/a/b/x", &id), DE_OBJ_DNE);
+        CHECK_SUCCESS(de_find_fullpath(dc, "/aa/b/x", &id));
+        FAIL_IF(id != id_x, "fullpath after rename");
+        CHECK_SUCCESS(de_find_object(dc, 0, "aa", &id));
+        FAIL_IF(id != id_a, "find after rename");
+
+        CHECK(de_move(NULL, id_b, id_c), DE_NULL);
+        CHECK(de_move(dc, 0, id_c), DE_ARG);
+        CHECK(de_move(dc, id_a, id_a), DE_ARG);
+        CHECK(de_move(dc, id_a, id_b), DE_ARG);
+        CHECK(de_move(dc, id_b, id_y), DE_BAD_CLASS);
+        CHECK(de_move(dc, id_b, 9999), DE_OBJ_DNE);
+        CHECK_SUCCESS(de_new_catalog(dc, id_c, "b", &id));
+        CHECK(de_move(dc, id_b, id_c), DE_EXISTS);
+        CHECK_SUCCESS(de_delete_object(dc, id));
+
+        /* so do those under a moved catalog, and the statistics of both catalogs */
+        CHECK_SUCCESS(de_move(dc, id_b, id_c));
+        CHECK_SUCCESS(de_get_object_info(dc, id_x, &path, &depth, NULL));
+        FAIL_IF(strcmp(path, "/c/b/x") != 0 || depth != 3, "fullpath after move");
+        CHECK_SUCCESS(de_catalog_stats(dc, id_a, &stats));
+        FAIL_IF(stats.count != 1 || stats.nbytes != sizeof v || stats.dated, "stats of the old catalog");
+        CHECK_SUCCESS(de_catalog_stats(dc, id_c, &stats));
+        FAIL_IF(stats.count != 2 || stats.nbytes != sizeof v || !stats.dated || stats.first_day != 800000,
+                "stats of the new catalog");
+        CHECK_SUCCESS(de_catalog_stats(dc, 0, &stats));
+        FAIL_IF(stats.count != 5 || stats.nbytes != 2 * sizeof v, "stats of the root");
+
+        CHECK_SUCCESS(de_move(dc, id_x, 0));
+        CHECK_SUCCESS(de_get_object_info(dc, id_x, &path, &depth, NULL));
+        FAIL_IF(strcmp(path, "/x") != 0 || depth != 1, "fullpath after move to the root");
+        CHECK_SUCCESS(de_catalog_stats(dc, id_c, &stats));
+        FAIL_IF(stats.count != 1 || stats.nbytes != 0 || stats.dated, "stats after moving out");
+        CHECK_SUCCESS(de_close(dc));
+    }
+
+    /* test deferred object info */
+    {
+        const static char dname[] = "test_defer.daec";
+        de_file dc;
+        unlink(dname);
+        CHECK_SUCCESS(de_open(dname, &dc));
+        CHECK(de_set_defer_info(NULL, 1), DE_NULL);
+        CHECK_SUCCESS(de_set_defer_info(dc, 1));
+        obj_id_t id_c, id_d, id_x, id_y, id;
+        const char *path;
+        int64_t depth, created;
+        const double x = 1.0;
+        CHECK_SUCCESS(de_new_catalog(dc, 0, "c", &id_c));
+        CHECK_SUCCESS(de_new_catalog(dc, id_c, "d", &id_d));
+        CHECK_SUCCESS(de_store_scalar(dc, id_d, "x", type_float, freq_none, sizeof x, &x, &id_x));
+
+        /* the info is there as soon as it is asked for */
+        CHECK_SUCCESS(de_find_fullpath(dc, "/c/d/x", &id));
+        FAIL_IF(id != id_x, "find new object with deferred info");
+        CHECK_SUCCESS(de_store_scalar(dc, id_c, "y", type_float, freq_none, sizeof x, &x, &id_y));
+        CHECK_SUCCESS(de_get_object_info(dc, id_y, &path, &depth, &created));
+        FAIL_IF(strcmp(path, "/c/y") != 0 || depth != 2 || created <= 0, "info of new object");
+
+        /* and it is all in the file when it is closed */
+        CHECK_SUCCESS(de_new_catalog(dc, id_d, "e", &id));
+        CHECK_SUCCESS(de_store_scalar(dc, id, "z", type_float, freq_none, sizeof x, &x, NULL));
+        CHECK_SUCCESS(de_rename(dc, id_d, "dd"));
+        CHECK_SUCCESS(de_store_scalar(dc, id_d, "w", type_float, freq_none, sizeof x, &x, NULL));
+        CHECK_SUCCESS(de_close(dc));
+        CHECK_SUCCESS(de_open(dname, &dc));
+        CHECK_SUCCESS(de_find_fullpath(dc, "/c/dd/e/z", &id));
+        CHECK_SUCCESS(de_get_object_info(dc, id, &path, &depth, NULL));
+        FAIL_IF(depth != 4, "depth of deferred info");
+        CHECK_SUCCESS(de_find_fullpath(dc, "/c/dd/w", &id));
+
+        /* turning it off fills in what is missing */
+        CHECK_SUCCESS(de_set_defer_info(dc, 1));
+        CHECK_SUCCESS(de_store_scalar(dc, id_c, "v", type_float, freq_none, sizeof x, &x, &id));
+        CHECK_SUCCESS(de_set_defer_info(dc, 0));
+        CHECK_SUCCESS(de_get_object_info(dc, id, &path, NULL, NULL));
+        FAIL_IF(strcmp(path, "/c/v") != 0, "info filled in when turned off");
+        CHECK_SUCCESS(de_store_scalar(dc, id_c, "u", type_float, freq_none, sizeof x, &x, &id));
+        CHECK_SUCCESS(de_get_object_info(dc, id, &path, NULL, NULL));
+        FAIL_IF(strcmp(path, "/c/u") != 0, "info after it is turned off");
+        CHECK_SUCCESS(de_close(dc));
+        unlink(dname);
+    }
+
+    /* test bulk loads */
+    {
+        const static char bname[] = "test_bulk.daec";
+        de_file db;
+        unlink(bname);
+        CHECK_SUCCESS(de_open(bname, &db));
+        obj_id_t id_cat[3], id_ts[3], id;
+        axis_id_t ax;
+        double v[4] = {0};
+        char name[16];
+        CHECK_SUCCESS(de_new_catalog(db, 0, "before", NULL));
+        CHECK(de_bulk_begin(NULL, 0), DE_NULL);
+        CHECK(de_bulk_end(NULL), DE_NULL);
+        CHECK(de_bulk_end(db), DE_ARG);
+        CHECK_SUCCESS(de_bulk_begin(db, bulk_no_sync | bulk_drop_indexes));
+        CHECK(de_bulk_begin(db, 0), DE_ARG);
+        CHECK(de_truncate(db), DE_ARG);
+        CHECK_SUCCESS(de_axis_plain(db, 4, &ax));
+        for (int i = 0; i < 3; ++i)
+        {
+            sprintf(name, "c%d", i);
+            CHECK_SUCCESS(de_new_catalog(db, 0, name, &id_cat[i]));
+            CHECK_SUCCESS(de_store_tseries(db, id_cat[i], "t", type_tseries, type_float, freq_none, ax, sizeof v, v, &id_ts[i]));
+        }
+        CHECK_SUCCESS(de_delete_object(db, id_cat[2]));
+        CHECK(de_load_object(db, id_ts[2], &object), DE_OBJ_DNE);
+        CHECK_SUCCESS(de_bulk_end(db));
+        CHECK_SUCCESS(de_find_fullpath(db, "/c1/t", &id));
+        FAIL_IF(id != id_ts[1], "object of a bulk load");
+
+        /* the foreign keys are back on, with their cascades */
+        CHECK_SUCCESS(de_delete_object(db, id_cat[0]));
+        CHECK(de_load_object(db, id_ts[0], &object), DE_OBJ_DNE);
+        FAIL_IF(de_append_vintage(db, id_ts[1], 1, ax + 1000, sizeof v, v) == DE_SUCCESS, "foreign keys after a bulk load");
+        de_clear_error();
+
+        /* a load that fails its checks leaves nothing behind */
+        CHECK_SUCCESS(de_bulk_begin(db, bulk_drop_indexes));
+        CHECK_SUCCESS(de_new_catalog(db, 0, "lost", NULL));
+        CHECK_SUCCESS(de_append_vintage(db, id_ts[1], 2, ax + 1000, sizeof v, v));
+        CHECK(de_bulk_end(db), DE_BAD_OBJ);
+        CHECK(de_find_object(db, 0, "lost", &id), DE_OBJ_DNE);
+        CHECK_SUCCESS(de_find_object(db, 0, "before", &id));
+        FAIL_IF(de_append_vintage(db, id_ts[1], 3, ax + 1000, sizeof v, v) == DE_SUCCESS, "foreign keys after a failed load");
+        de_clear_error();
+
+        /* closing the file ends the load */
+        CHECK_SUCCESS(de_bulk_begin(db, 0));
+        CHECK_SUCCESS(de_new_catalog(db, 0, "closed", NULL));
+        CHECK_SUCCESS(de_close(db));
+        CHECK_SUCCESS(de_open(bname, &db));
+        CHECK_SUCCESS(de_find_fullpath(db, "/closed", &id));
+
+        /* even if the load fails its checks */
+        CHECK_SUCCESS(de_bulk_begin(db, 0));
+        CHECK_SUCCESS(de_new_catalog(db, 0, "lost", NULL));
+        CHECK_SUCCESS(de_append_vintage(db, id_ts[1], 4, ax + 1000, sizeof v, v));
+        CHECK(de_close(db), DE_BAD_OBJ);
+        CHECK_SUCCESS(de_open(bname, &db));
+        CHECK(de_find_object(db, 0, "lost", &id), DE_OBJ_DNE);
+        CHECK_SUCCESS(de_close(db));
+        unlink(bname);
+    }
+
     /* test search and list */
     {
         CHECK_SUCCESS(de_finalize_search(NULL)); // harmless no-op
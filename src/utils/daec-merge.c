@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include "common.h"
+
+#include "daec.h"
+
+void print_usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [options...] outfile.daec infile.daec [infile.daec ...]\n", program);
+    fprintf(stderr, "    Merge the input files, in order, into the output file, which is created if it does not exist.\n");
+    fprintf(stderr, "    Catalogs at the same path are merged. Other objects at the same path are conflicts.\n");
+    fprintf(stderr, "    The files are merged one at a time, each in a single transaction.\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "   -s or --skip        : keep the object already in the output (default).\n");
+    fprintf(stderr, "   -o or --overwrite   : replace the object already in the output.\n");
+    fprintf(stderr, "   -r or --rename      : copy the object under a new name, e.g. \"name~1\".\n");
+    fprintf(stderr, "   -q or --quiet       : do not report the progress.\n");
+    fprintf(stderr, "\n");
+    fflush(stderr);
+    return;
+}
+
+/*
+    The merge is sequential. Each input file is attached to the connection to
+    the output file and merged into it by the database engine, with set-based
+    statements in a single transaction (see de_merge), so there is no decoding
+    in this program to spread over threads.
+*/
+
+int main(int argc, char *argv[])
+{
+    merge_mode_t mode = merge_skip;
+    bool quiet = false;
+    int first = 1;
+    for (; first < argc && argv[first][0] == '-'; ++first)
+    {
+        const char *opt = argv[first];
+        if ((strcmp(opt, "-s") == 0) || (strcmp(opt, "--skip") == 0))
+            mode = merge_skip;
+        else if ((strcmp(opt, "-o") == 0) || (strcmp(opt, "--overwrite") == 0))
+            mode = merge_overwrite;
+        else if ((strcmp(opt, "-r") == 0) || (strcmp(opt, "--rename") == 0))
+            mode = merge_rename;
+        else if ((strcmp(opt, "-q") == 0) || (strcmp(opt, "--quiet") == 0))
+            quiet = true;
+        else
+        {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (argc - first < 2)
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    de_file out;
+    if (de_open(argv[first], &out) != DE_SUCCESS)
+    {
+        print_de_error();
+        print_error("Failed to open file %s for writing.", argv[first]);
+        return EXIT_FAILURE;
+    }
+
+    const int nfiles = argc - first - 1;
+    char **fnames = argv + first + 1;
+    int rc = DE_SUCCESS;
+    int64_t total = 0;
+    for (int i = 0; i < nfiles; ++i)
+    {
+        const char *fname = fnames[i];
+        de_file in;
+        if ((rc = de_open_readonly(fname, &in)) != DE_SUCCESS)
+        {
+            print_de_error();
+            print_error("Failed to open file %s for reading.", fname);
+            break;
+        }
+        int64_t nconflicts = 0;
+        rc = de_merge(in, out, mode, &nconflicts);
+        de_close(in);
+        if (rc != DE_SUCCESS)
+        {
+            print_de_error();
+            print_error("Failed to merge file %s.", fname);
+            break;
+        }
+        total += nconflicts;
+        if (!quiet)
+            printf("%s: %" PRId64 " conflicts\n", fname, nconflicts);
+    }
+
+    if (de_close(out) != DE_SUCCESS)
+    {
+        print_de_error();
+        print_error("Failed to close file %s.", argv[first]);
+        return EXIT_FAILURE;
+    }
+    if (!quiet && rc == DE_SUCCESS)
+        printf("%d files merged into %s, %" PRId64 " conflicts\n", nfiles, argv[first], total);
+    return rc == DE_SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE;
+}